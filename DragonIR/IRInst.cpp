@@ -582,6 +582,30 @@ void BcIRInst::toString(std::string & str)
     }
 }
 
+/// @brief 条件选择指令
+/// @param _result 结果操作数
+/// @param _cond 条件，取值为0或1
+/// @param _trueVal 条件为1时的结果
+/// @param _falseVal 条件为0时的结果
+SelectIRInst::SelectIRInst(Value * _result, Value * _cond, Value * _trueVal, Value * _falseVal)
+    : IRInst(IRInstOperator::IRINST_OP_SELECT, _result)
+{
+    srcValues.push_back(_cond);
+    srcValues.push_back(_trueVal);
+    srcValues.push_back(_falseVal);
+}
+
+/// @brief 析构函数
+SelectIRInst::~SelectIRInst()
+{}
+
+/// @brief 转换成字符串
+void SelectIRInst::toString(std::string & str)
+{
+    str = dstValue->getName() + " = select " + srcValues[0]->toString() + ", " + srcValues[1]->toString() + ", " +
+          srcValues[2]->toString();
+}
+
 PhiIRInst::PhiIRInst() : IRInst(IRInstOperator::IRINST_OP_PHI, nullptr)
 {}
 /// @brief Phi函数指令
@@ -81,6 +81,9 @@ enum class IRInstOperator {
     // IRINST_OP_BR,
     IRINST_OP_BC,
 
+    /// @brief 条件选择，dst = cond ? src1 : src2，cond只取0或1，由if转换产生
+    IRINST_OP_SELECT,
+
     /// @brief 最大指令码，也是无效指令
     IRINST_OP_MAX,
 
@@ -191,6 +194,20 @@ public:
         return falseInst;
     }
 
+    /// @brief 设置真出口的Label，优化时跳转目标重定向使用
+    /// @param inst 真出口Label指令
+    void setTrueInst(IRInst * inst)
+    {
+        trueInst = inst;
+    }
+
+    /// @brief 设置假出口的Label，优化时跳转目标重定向使用
+    /// @param inst 假出口Label指令
+    void setFalseInst(IRInst * inst)
+    {
+        falseInst = inst;
+    }
+
     int getTag()
     {
         return this->localVarTag;
@@ -478,6 +495,24 @@ public:
     void toString(std::string & str) override;
 };
 
+/// @brief 条件选择指令，两个源操作数都已经计算好，按条件取其一，不产生跳转
+class SelectIRInst : public IRInst {
+
+public:
+    /// @brief 构造函数
+    /// @param _result 结果操作数
+    /// @param _cond 条件，取值为0或1
+    /// @param _trueVal 条件为1时的结果
+    /// @param _falseVal 条件为0时的结果
+    SelectIRInst(Value * _result, Value * _cond, Value * _trueVal, Value * _falseVal);
+
+    /// @brief 析构函数
+    virtual ~SelectIRInst() override;
+
+    /// @brief 转换成字符串
+    void toString(std::string & str) override;
+};
+
 class PhiIRInst : public IRInst {
 
 public:
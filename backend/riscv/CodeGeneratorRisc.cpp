@@ -4,15 +4,35 @@
 #include "SymbolTable.h"
 #include "Value.h"
 #include "ValueType.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
 //超过10的数组存在全局
 #define MaxSize 100
+
+extern int dataFlowOpt;
+
+/// @brief 目标是否支持Zicond扩展
+extern int zicondExt;
+
+// 除数是2的幂且被除数非负时返回幂次，否则返回-1
+static int nonNegativePow2Divisor(ValueRange *ranges, IRInst *inst) {
+  Value *src2 = inst->getSrc2();
+  if (ranges == nullptr || !isIntLiteral(src2) || src2->intVal <= 1 ||
+      (src2->intVal & (src2->intVal - 1)) != 0 ||
+      ranges->getOperandRange(inst, 0).lo < 0)
+    return -1;
+  int shift = 0;
+  while ((1 << shift) != src2->intVal)
+    shift++;
+  return shift;
+}
 //全局变量（不包括const）
 bool CodeGeneratorRisc::isGlobal(Value *var) {
   return (var->isLocalVar() && symtab.findSymbolValue(var));
@@ -158,7 +178,14 @@ CodeGeneratorRisc::~CodeGeneratorRisc() {}
 void CodeGeneratorRisc::genCodeSection(Function *fun) {
   registerAllocation(fun);
 
+  // 值域分析证明不会溢出的整型运算，结果写回寄存器时不必再做符号扩展
+  ValueRange ranges(fun);
+  if (dataFlowOpt)
+    ranges.run();
+  valueRange = &ranges;
   generateCode(fun->getInterCode().getInsts(), fun);
+  valueRange = nullptr;
+  resultExtended = false;
 
   std::string name = fun->getName();
   std::string asmName = name[0] == '@' ? name.substr(1) : name;
@@ -382,9 +409,185 @@ void CodeGeneratorRisc::store_var(Value *var, int32_t reg) {
 
     return;
   }
-  if (var->regId != reg)
+  // 驻留在寄存器中的整型变量按32位符号扩展，与lw读回的值一致
+  if (!is_float && var->type.type == BasicType::TYPE_INT && !resultExtended)
+    code_seq.push_back(new RiscInst(InstType::sext_w, regs[var->regId],
+                                    regs[reg], ""));
+  else if (var->regId != reg)
     code_seq.push_back(
-        new RiscInst(InstType::mv, regs[reg], regs[var->regId], ""));
+        new RiscInst(InstType::mv, regs[var->regId], regs[reg], ""));
+}
+
+// 局部标量变量与临时变量的地址不会被取走，可以整体驻留在寄存器中。
+// 在线性IR上求出每个变量的活跃区间，与向回跳转构成的循环区间相交时扩展到整个循环，
+// 然后按区间起点线性扫描，把s1~s11分给循环嵌套深度加权后使用最频繁的变量。
+// 这些寄存器跨函数调用保持不变，只需在序言与尾声中保存
+void CodeGeneratorRisc::promoteScalars(Function *fun) {
+  static const int32_t callee_saved[] = {9,  18, 19, 20, 21, 22,
+                                         23, 24, 25, 26, 27};
+  static const size_t reg_num = sizeof(callee_saved) / sizeof(callee_saved[0]);
+  std::vector<IRInst *> &insts = fun->getInterCode().getInsts();
+  saved_regs.clear();
+
+  // 向回跳转的范围即循环
+  std::map<IRInst *, int32_t> label_index;
+  for (size_t i = 0; i < insts.size(); i++)
+    if (insts[i]->getOp() == IRInstOperator::IRINST_OP_LABEL)
+      label_index[insts[i]] = i;
+  std::vector<std::pair<int32_t, int32_t>> loops;
+  std::vector<int32_t> depth(insts.size() + 1, 0);
+  for (size_t i = 0; i < insts.size(); i++) {
+    // 与translate_br、translate_bc选取跳转目标的方式一致
+    std::vector<IRInst *> targets;
+    if (insts[i]->getOp() == IRInstOperator::IRINST_OP_BR) {
+      targets.push_back(insts[i]->getTrueInst());
+    } else if (insts[i]->getOp() == IRInstOperator::IRINST_OP_BC) {
+      BcIRInst *bc = static_cast<BcIRInst *>(insts[i]);
+      int mode = bc->mode;
+      targets.push_back(mode == 0 || mode == 1 || mode == 3 || mode == 4
+                            ? bc->getTrueInst()
+                            : bc->modeInst_2);
+      targets.push_back(mode == 0 || mode == 2 || mode == 3 || mode == 5
+                            ? bc->getFalseInst()
+                            : bc->modeInst_1);
+    }
+    for (IRInst *target : targets) {
+      auto it = label_index.find(target);
+      if (it != label_index.end() && it->second <= (int32_t)i) {
+        loops.push_back({it->second, i});
+        depth[it->second]++;
+        depth[i + 1]--;
+      }
+    }
+  }
+
+  // 每个变量的使用权重与出现范围，循环内的出现权重乘以8
+  std::map<Value *, int64_t> weight;
+  std::map<Value *, std::pair<int32_t, int32_t>> range;
+  std::set<Value *> excluded;
+  // 只在一个基本块内出现且先定值后使用的变量不会跨越循环的回边
+  std::map<Value *, int32_t> local_block;
+  int32_t cur_depth = 0, block_id = 0;
+  for (size_t i = 0; i < insts.size(); i++) {
+    IRInst *inst = insts[i];
+    cur_depth += depth[i];
+    if (inst->getOp() == IRInstOperator::IRINST_OP_LABEL ||
+        (i > 0 && (insts[i - 1]->getOp() == IRInstOperator::IRINST_OP_BR ||
+                   insts[i - 1]->getOp() == IRInstOperator::IRINST_OP_BC)))
+      block_id++;
+    std::vector<Value *> operands = inst->getSrc();
+    if (inst->getDst() != nullptr)
+      operands.push_back(inst->getDst());
+    if (inst->getOp() == IRInstOperator::IRINST_OP_BC &&
+        static_cast<BcIRInst *>(inst)->temp != nullptr)
+      operands.push_back(static_cast<BcIRInst *>(inst)->temp);
+
+    // 指针赋值中的地址总是从栈中读取
+    if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN) {
+      int32_t flag = static_cast<AssignIRInst *>(inst)->_flag;
+      if (flag == 2 || flag == 4)
+        excluded.insert(inst->getSrc().front());
+      if (flag == 3 || flag == 4 || inst->Assign_flag == 6)
+        excluded.insert(inst->getDst());
+    }
+    // 浮点与整型混合的指令在浮点寄存器中转换，第5个及之后的实参直接从栈中读取
+    bool has_float = false;
+    for (auto var : operands)
+      has_float |= var->type.type == BasicType::TYPE_FLOAT;
+    for (size_t k = 0; k < operands.size(); k++) {
+      Value *var = operands[k];
+      if (has_float || (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL &&
+                        k >= 4 && k < inst->getSrc().size())) {
+        excluded.insert(var);
+        continue;
+      }
+      int64_t w = 1;
+      for (int32_t d = 0; d < cur_depth && d < 6; d++)
+        w *= 8;
+      weight[var] += w;
+      auto it = range.find(var);
+      if (it == range.end()) {
+        range[var] = {i, i};
+        bool is_src = std::find(inst->getSrc().begin(), inst->getSrc().end(),
+                                var) != inst->getSrc().end();
+        local_block[var] = inst->getDst() == var && !is_src ? block_id : -1;
+      } else {
+        it->second.second = i;
+        if (local_block[var] != block_id)
+          local_block[var] = -1;
+      }
+    }
+  }
+
+  struct Interval {
+    Value *var;
+    int32_t start, end;
+    int64_t weight;
+  };
+  std::vector<Interval> intervals;
+  for (auto var : fun->getVarValues()) {
+    if (var == nullptr || var->regId != -1 || var->baseRegNo != -1 ||
+        var->getOffset() != 0 || excluded.count(var) || !range.count(var) ||
+        weight[var] < 2)
+      continue;
+    if (var->type.type != BasicType::TYPE_INT &&
+        var->type.type != BasicType::TYPE_BOOL)
+      continue;
+    if (!(var->isLocalVar() || var->isTemp()) || var->isConst() ||
+        var->isliteral() || var->is_numpy || var->is_issavenp() ||
+        var->np != nullptr || var->is_saveFParam || isGlobal(var) ||
+        isGlobalTemp(var) || var->getSize() > 4)
+      continue;
+
+    // 与循环相交的区间覆盖整个循环，直到不再变化
+    int32_t start = range[var].first, end = range[var].second;
+    for (bool changed = local_block[var] < 0; changed;) {
+      changed = false;
+      for (auto &loop : loops) {
+        if (loop.first <= end && start <= loop.second &&
+            (loop.first < start || loop.second > end)) {
+          start = std::min(start, loop.first);
+          end = std::max(end, loop.second);
+          changed = true;
+        }
+      }
+    }
+    intervals.push_back({var, start, end, weight[var]});
+  }
+  std::stable_sort(
+      intervals.begin(), intervals.end(),
+      [](const Interval &a, const Interval &b) { return a.start < b.start; });
+
+  // 区间结束严格早于新区间开始时才回收寄存器，同一条指令的源与目的不共用寄存器。
+  // 寄存器不足时，权重最小的区间留在栈中
+  std::vector<Interval *> active;
+  std::vector<int32_t> free_regs(callee_saved, callee_saved + reg_num);
+  std::set<int32_t> used;
+  for (auto &cur : intervals) {
+    for (size_t k = 0; k < active.size();) {
+      if (active[k]->end < cur.start) {
+        free_regs.push_back(active[k]->var->regId);
+        active.erase(active.begin() + k);
+      } else
+        k++;
+    }
+    if (free_regs.empty()) {
+      auto victim = std::min_element(
+          active.begin(), active.end(), [](Interval *a, Interval *b) {
+            return a->weight < b->weight;
+          });
+      if ((*victim)->weight >= cur.weight)
+        continue;
+      free_regs.push_back((*victim)->var->regId);
+      (*victim)->var->regId = -1;
+      active.erase(victim);
+    }
+    cur.var->regId = free_regs.back();
+    free_regs.pop_back();
+    used.insert(cur.var->regId);
+    active.push_back(&cur);
+  }
+  saved_regs.assign(used.begin(), used.end());
 }
 
 // TODO:寄存器分配中，局部变量和函数形参变量存在栈中，Const变量（全局、局部,包括const修饰的数组）存在.rodata段，【非const】数组变量（全局，局部）优化到.data段
@@ -453,6 +656,7 @@ void CodeGeneratorRisc::registerAllocation(Function *fun) {
       cnt++;
     }
   }
+  promoteScalars(fun);
   // for (auto var: symtab.getValueVector()) { // Get all the variables in the
   // function.
   //     if (var == nullptr || var->getOffset() != 0 || var->regId != -1)
@@ -719,6 +923,7 @@ void CodeGeneratorRisc::registerAllocation(Function *fun) {
 
   sp_offset += 16 + cnt * 8;
   sp_offset += fcnt * 8;
+  sp_offset += saved_regs.size() * 8;
 
   // protect registers
   // 栈帧修改为16字节对齐
@@ -745,6 +950,11 @@ void CodeGeneratorRisc::registerAllocation(Function *fun) {
     code_seq.push_back(new RiscInst(InstType::sd, RiscInst::regname[11 + i],
                                     RiscInst::regname[REG_SP],
                                     std::to_string(8 * (i + fcnt))));
+  // 被调用者保存寄存器放在ra之上
+  for (size_t i = 0; i < saved_regs.size(); i++)
+    code_seq.push_back(new RiscInst(
+        InstType::sd, RiscInst::regname[saved_regs[i]],
+        RiscInst::regname[REG_SP], std::to_string(8 * (cnt + fcnt + 2 + i))));
   // set fp
   for (int i = 0; i < fcnt; i++)
     code_seq.push_back(new RiscInst(InstType::fsd, RiscInst::f_regname[11 + i],
@@ -906,6 +1116,8 @@ void CodeGeneratorRisc::generateCode(std::vector<IRInst *> &inst_seq,
   for (auto inst : inst_seq) {
     std::string temp;
     inst->toString(temp);
+    resultExtended =
+        valueRange != nullptr && valueRange->isSignExtended(inst);
     switch (inst->getOp()) {
     case IRInstOperator::IRINST_OP_ENTRY:
       translate_entry(inst);
@@ -922,6 +1134,9 @@ void CodeGeneratorRisc::generateCode(std::vector<IRInst *> &inst_seq,
     case IRInstOperator::IRINST_OP_BC:
       translate_bc(inst);
       break;
+    case IRInstOperator::IRINST_OP_SELECT:
+      translate_select(inst);
+      break;
     case IRInstOperator::IRINST_OP_ADD_I:
       translate_addi(inst);
       break;
@@ -1129,6 +1344,17 @@ void CodeGeneratorRisc::translate_divi(IRInst *inst) {
 
 void CodeGeneratorRisc::translate_div(IRInst *inst) {
   Value *dst = inst->getDst(), *src1 = inst->getSrc1(), *src2 = inst->getSrc2();
+  int32_t shift = nonNegativePow2Divisor(valueRange, inst);
+  if (shift > 0) {
+    // 非负数除以2的幂即算术右移
+    int32_t reg1 = getReg(src1, 29), dreg = getReg(dst, 28);
+    load_var(src1, reg1);
+    code_seq.push_back(new RiscInst(InstType::srai, RiscInst::regname[dreg],
+                                    RiscInst::regname[reg1],
+                                    std::to_string(shift)));
+    store_var(dst, dreg);
+    return;
+  }
   int32_t reg1 = getReg(src1, 29), reg2 = getReg(src2, 30),
           dreg = getReg(dst, 28);
   load_var(src1, reg1);
@@ -1164,6 +1390,26 @@ void CodeGeneratorRisc::translate_fdiv(IRInst *inst) {
 
 void CodeGeneratorRisc::translate_remi(IRInst *inst) {
   Value *dst = inst->getDst(), *src1 = inst->getSrc1(), *src2 = inst->getSrc2();
+  int32_t shift = nonNegativePow2Divisor(valueRange, inst);
+  if (shift > 0) {
+    // 非负数对2的幂取余即保留低位
+    int32_t reg1 = getReg(src1, 29), dreg = getReg(dst, 28);
+    int32_t mask = src2->intVal - 1;
+    load_var(src1, reg1);
+    if (mask < 2048) {
+      code_seq.push_back(new RiscInst(InstType::andi, RiscInst::regname[dreg],
+                                      RiscInst::regname[reg1],
+                                      std::to_string(mask)));
+    } else {
+      code_seq.push_back(new RiscInst(InstType::li, RiscInst::regname[30], "",
+                                      std::to_string(mask)));
+      code_seq.push_back(new RiscInst(InstType::AND, RiscInst::regname[dreg],
+                                      RiscInst::regname[reg1],
+                                      RiscInst::regname[30]));
+    }
+    store_var(dst, dreg);
+    return;
+  }
   int32_t reg1 = getReg(src1, 29), reg2 = getReg(src2, 30),
           dreg = getReg(dst, 28);
   load_var(src1, reg1);
@@ -1205,6 +1451,79 @@ void CodeGeneratorRisc::translate_bc(IRInst *inst) {
                                   RiscInst::regname[0]));
 }
 
+// select的条件只取0或1。有Zicond扩展时两个czero各保留一个操作数再合并；
+// 否则用条件取负得到全0或全1的掩码，按b ^ ((a ^ b) & mask)选取。一个操作数是0时只需保留另一个
+void CodeGeneratorRisc::translate_select(IRInst *inst) {
+  Value *dst = inst->getDst(), *cond = inst->getSrc()[0],
+        *src1 = inst->getSrc()[1], *src2 = inst->getSrc()[2];
+  bool zero1 = src1->isliteral() && src1->intVal == 0;
+  bool zero2 = src2->isliteral() && src2->intVal == 0;
+  int32_t creg = getReg(cond, 29), reg1 = getReg(src1, 30),
+          reg2 = getReg(src2, 31), dreg = getReg(dst, 28);
+  load_var(cond, creg);
+  if (!zero1)
+    load_var(src1, reg1);
+  if (!zero2)
+    load_var(src2, reg2);
+
+  if (zicondExt) {
+    if (zero2) {
+      code_seq.push_back(new RiscInst(InstType::czero_eqz,
+                                      RiscInst::regname[dreg],
+                                      RiscInst::regname[reg1],
+                                      RiscInst::regname[creg]));
+    } else if (zero1) {
+      code_seq.push_back(new RiscInst(InstType::czero_nez,
+                                      RiscInst::regname[dreg],
+                                      RiscInst::regname[reg2],
+                                      RiscInst::regname[creg]));
+    } else {
+      code_seq.push_back(new RiscInst(InstType::czero_eqz,
+                                      RiscInst::regname[30],
+                                      RiscInst::regname[reg1],
+                                      RiscInst::regname[creg]));
+      code_seq.push_back(new RiscInst(InstType::czero_nez,
+                                      RiscInst::regname[29],
+                                      RiscInst::regname[reg2],
+                                      RiscInst::regname[creg]));
+      code_seq.push_back(new RiscInst(InstType::OR, RiscInst::regname[dreg],
+                                      RiscInst::regname[30],
+                                      RiscInst::regname[29]));
+    }
+    store_var(dst, dreg);
+    return;
+  }
+
+  if (zero1) {
+    // 条件为0时取src2：掩码为cond - 1
+    code_seq.push_back(new RiscInst(InstType::addi, RiscInst::regname[29],
+                                    RiscInst::regname[creg], "-1"));
+    code_seq.push_back(new RiscInst(InstType::AND, RiscInst::regname[dreg],
+                                    RiscInst::regname[reg2],
+                                    RiscInst::regname[29]));
+    store_var(dst, dreg);
+    return;
+  }
+  code_seq.push_back(new RiscInst(InstType::neg, RiscInst::regname[29],
+                                  RiscInst::regname[creg], ""));
+  if (zero2) {
+    code_seq.push_back(new RiscInst(InstType::AND, RiscInst::regname[dreg],
+                                    RiscInst::regname[reg1],
+                                    RiscInst::regname[29]));
+  } else {
+    code_seq.push_back(new RiscInst(InstType::XOR, RiscInst::regname[30],
+                                    RiscInst::regname[reg1],
+                                    RiscInst::regname[reg2]));
+    code_seq.push_back(new RiscInst(InstType::AND, RiscInst::regname[30],
+                                    RiscInst::regname[30],
+                                    RiscInst::regname[29]));
+    code_seq.push_back(new RiscInst(InstType::XOR, RiscInst::regname[dreg],
+                                    RiscInst::regname[reg2],
+                                    RiscInst::regname[30]));
+  }
+  store_var(dst, dreg);
+}
+
 void CodeGeneratorRisc::translate_cmp_eq(IRInst *inst) {
   BinaryIRInst *b_inst = static_cast<BinaryIRInst *>(inst);
   Value *dst = inst->getDst(), *src1 = inst->getSrc1();
@@ -1547,6 +1866,11 @@ void CodeGeneratorRisc::translate_exit(IRInst *inst, Function *fun) {
                                       RiscInst::regname[5], std::to_string(0)));
     }
   }
+  // 返回值取出之后再恢复被调用者保存寄存器
+  for (size_t i = 0; i < saved_regs.size(); i++)
+    code_seq.push_back(new RiscInst(
+        InstType::ld, RiscInst::regname[saved_regs[i]],
+        RiscInst::regname[REG_SP], std::to_string(8 * (cnt + fcnt + 2 + i))));
   code_seq.push_back(new RiscInst(InstType::add, RiscInst::regname[REG_SP],
                                   RiscInst::regname[REG_FP],
                                   RiscInst::regname[0]));
@@ -7,6 +7,7 @@
 #include "CodeGenerator.h"
 #include "CodeGeneratorAsm.h"
 #include "RiscCode.h"
+#include "ValueRange.h"
 
 class CodeGeneratorRisc : public CodeGeneratorAsm {
 public:
@@ -24,6 +25,7 @@ public:
     void translate_label(IRInst * inst);
     void translate_br(IRInst * inst);
     void translate_bc(IRInst * inst);
+    void translate_select(IRInst * inst);
     void translate_addi(IRInst * inst);
     void translate_add(IRInst * inst);
     void translate_fadd(IRInst * inst);
@@ -60,8 +62,16 @@ protected:
     void load_var(Value * var, int32_t reg);
     void store_var(Value * var, int32_t reg);
     int32_t getReg(Value * var, int32_t reg);
+    //把使用频繁的整型标量分配到被调用者保存寄存器
+    void promoteScalars(Function * fun);
     std::vector<RiscInst *> code_seq;
+    //当前函数用到的被调用者保存寄存器
+    std::vector<int32_t> saved_regs;
     std::vector<float> real_const;
+    //当前函数的整型值域，未开启优化时为空
+    ValueRange * valueRange = nullptr;
+    //当前指令的整型结果按64位计算后仍是32位结果的符号扩展
+    bool resultExtended = false;
 };
 
 // 8f64b9b7
\ No newline at end of file
@@ -89,6 +89,12 @@ std::string RiscInst::toString()
         case InstType::NOT:
             ret = "\tnot " + rst + ", " + arg1;
             break;
+        case InstType::czero_eqz:
+            ret = "\tczero.eqz " + rst + ", " + arg1 + ", " + arg2;
+            break;
+        case InstType::czero_nez:
+            ret = "\tczero.nez " + rst + ", " + arg1 + ", " + arg2;
+            break;
         case InstType::addi:
             ret = "\taddi " + rst + ", " + arg1 + ", " + arg2;
             ;
@@ -96,6 +102,12 @@ std::string RiscInst::toString()
         case InstType::subi:
             ret = "\tsubi " + rst + ", " + arg1 + ", " + arg2;
             break;
+        case InstType::andi:
+            ret = "\tandi " + rst + ", " + arg1 + ", " + arg2;
+            break;
+        case InstType::srai:
+            ret = "\tsrai " + rst + ", " + arg1 + ", " + arg2;
+            break;
         case InstType::li:
             ret = "\tli " + rst + ", " + arg2;
             break;
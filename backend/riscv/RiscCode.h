@@ -31,8 +31,12 @@ enum class InstType {
     AND,
     OR,
     NOT,
+    czero_eqz,
+    czero_nez,
     addi,
     subi,
+    andi,
+    srai,
     lui,
     li,
     push,
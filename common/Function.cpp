@@ -119,6 +119,20 @@ void Function::setBuiltin(bool _builtin)
     builtIn = _builtin;
 }
 
+/// @brief 判断该函数是否被运行时库等外部代码调用
+/// @return true: 被外部调用，即使从main不可达也要保留
+bool Function::isExternallyUsed()
+{
+    return externallyUsed;
+}
+
+/// @brief 设置函数是否被运行时库等外部代码调用
+/// @param _externallyUsed true: 被外部调用
+void Function::setExternallyUsed(bool _externallyUsed)
+{
+    externallyUsed = _externallyUsed;
+}
+
 /// @brief 函数指令信息输出
 /// @param str 函数指令
 void Function::toString(std::string & str, SymbolTable & symtab)
@@ -116,6 +116,14 @@ public:
     /// @param _builtin true: 内置函数 false: 用户自定义函数
     void setBuiltin(bool _builtin);
 
+    /// @brief 判断该函数是否被运行时库等外部代码调用
+    /// @return true: 被外部调用，即使从main不可达也要保留
+    bool isExternallyUsed();
+
+    /// @brief 设置函数是否被运行时库等外部代码调用
+    /// @param _externallyUsed true: 被外部调用
+    void setExternallyUsed(bool _externallyUsed);
+
     /// @brief 函数指令信息输出
     /// @param str 函数指令
     void toString(std::string & str, SymbolTable & symtab);
@@ -250,6 +258,9 @@ private:
     // @brief 是否是内置函数
     bool builtIn = false;
 
+    /// @brief 是否被运行时库等外部代码调用
+    bool externallyUsed = false;
+
     /// @brief 线性IR指令块，可包含多条IR指令
     InterCode code;
 
@@ -136,6 +136,44 @@ void SymbolTable::moveFunctionEnd(Function * func)
     }
 }
 
+/// @brief 从函数列表中删除函数，删除后不再输出IR与汇编
+/// @param func 函数信息
+void SymbolTable::removeFunction(Function * func)
+{
+    auto pIter = std::find(funcVector.begin(), funcVector.end(), func);
+    if (pIter != funcVector.end()) {
+        funcVector.erase(pIter);
+    }
+
+    auto pMapIter = funcMap.find(func->getName());
+    if (pMapIter != funcMap.end() && pMapIter->second == func) {
+        funcMap.erase(pMapIter);
+    }
+
+    if (mainFunc == func) {
+        mainFunc = nullptr;
+    }
+}
+
+/// @brief 从符号表中删除全局变量或常量并释放
+/// @param val 变量，调用者需保证不再被任何指令引用
+void SymbolTable::removeValue(Value * val)
+{
+    auto pIter = std::find(varsVector.begin(), varsVector.end(), val);
+    if (pIter == varsVector.end()) {
+        return;
+    }
+    varsVector.erase(pIter);
+
+    // 同名的Value可能有多个，只删除指向本Value的映射
+    auto pMapIter = varsMap.find(val->name);
+    if (pMapIter != varsMap.end() && pMapIter->second == val) {
+        varsMap.erase(pMapIter);
+    }
+
+    delete val;
+}
+
 /// @brief 文本输出线性IR指令
 /// @param filePath 输出文件路径
 void SymbolTable::outputIR(const std::string & filePath, SymbolTable & symtab)
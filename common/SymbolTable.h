@@ -50,6 +50,14 @@ public:
     /// @param func
     void moveFunctionEnd(Function * func);
 
+    /// @brief 从函数列表中删除函数，删除后不再输出IR与汇编
+    /// @param func 函数信息
+    void removeFunction(Function * func);
+
+    /// @brief 从符号表中删除全局变量或常量并释放
+    /// @param val 变量，调用者需保证不再被任何指令引用
+    void removeValue(Value * val);
+
     /// @brief 输出线性IR指令列表
     /// @param filePath
     void outputIR(const std::string & filePath, SymbolTable & symtab);
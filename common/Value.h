@@ -151,6 +151,9 @@ public:
   ///@brief 是不是活跃变量
   bool is_active = false;
 
+  ///@brief 是否被编译器可见范围之外的代码使用，无用全局变量删除时保留
+  bool is_externallyUsed = false;
+
   ///@brief 记录数组元素的下标
   std::vector<int> indexs;
 
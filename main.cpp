@@ -34,6 +34,7 @@
 #include "FrontEndExecutor.h"
 #include "Graph.h"
 #include "IRGenerator.h"
+#include "Optimizer.h"
 #include "BasicBlocks.h"
 #include "CfgGraph.h"
 #include "ControlFlowAnalysis.h"
@@ -68,6 +69,15 @@ int controlFlowOpt = 0;
 ///@brief 是否进行数据流优化
 int dataFlowOpt = 0;
 
+/// @brief 是否对纯递归函数进行记忆化，需单独开启
+int memoizeOpt = 0;
+
+/// @brief 是否把没有跨迭代依赖的循环并行化，需与-O同时使用，生成的代码需链接sysy_parallel运行时库
+int parallelOpt = 0;
+
+/// @brief 目标是否支持Zicond扩展，select用czero指令实现
+int zicondExt = 0;
+
 /// @brief 显示汇编
 int gShowASM = 0;
 
@@ -107,8 +117,11 @@ SymbolTable symtab;
 /// @brief 显示帮助
 /// @param exeName
 void showHelp(const std::string &exeName) {
-  std::cout << exeName + " -S [-A | -D| -F] [-a | -I] [-o output] source\n";
+  std::cout << exeName + " -S [-A | -D| -F] [-a | -I] [-O [-P]] [-M] [-Z] [-o output] source\n";
   std::cout << exeName + " -R [-A | -D] source\n";
+  std::cout << "  -P: parallelize loops, link the assembly with the RISC-V runtime\n";
+  std::cout << "      runtime/libsysy_parallel.a built by CMake with SYSY_TARGET_CC, e.g.\n";
+  std::cout << "      riscv64-linux-gnu-gcc -pthread out.s libsysy_parallel.a sylib.a\n";
 }
 
 /// @brief 参数解析与有效性检查
@@ -118,8 +131,8 @@ void showHelp(const std::string &exeName) {
 int ArgsAnalysis(int argc, char *argv[]) {
   int ch;
 
-  // 指定参数解析的选项，可识别-h、-o、-S、-a、-I、-R、-A、-D、-F选项，并且-o要求必须要有附加参数
-  const char options[] = "ho:SaIRADFO";
+  // 指定参数解析的选项，可识别-h、-o、-S、-a、-I、-R、-A、-D、-F、-O、-M、-P、-Z选项，并且-o要求必须要有附加参数
+  const char options[] = "ho:SaIRADFOMPZ";
 
   opterr = 1;
 
@@ -168,6 +181,18 @@ lb_check:
       controlFlowOpt = 1;
       dataFlowOpt = 1;
       break;
+    case 'M':
+      // 纯递归函数的记忆化
+      memoizeOpt = 1;
+      break;
+    case 'P':
+      // 循环并行化，调用运行时库的多线程执行
+      parallelOpt = 1;
+      break;
+    case 'Z':
+      // 目标支持Zicond条件置零扩展
+      zicondExt = 1;
+      break;
     default:
       return -1;
       break; /* no break */
@@ -340,6 +365,11 @@ int main(int argc, char *argv[]) {
     // 清理抽象语法树
     free_ast();
 
+    // 线性IR上的优化，需在IR输出以及变量重命名之前进行
+    if (controlFlowOpt || dataFlowOpt || memoizeOpt) {
+      optimizeIR(symtab);
+    }
+
     if (gShowLineIR) {
 
       // 输出IR
@@ -0,0 +1,173 @@
+/**
+ * @file Optimizer.cpp
+ * @brief 线性IR上的机器无关优化入口，在IR输出与汇编生成之前执行
+ */
+#include "Optimizer.h"
+#include "CallGraph.h"
+#include "ConstArrayFolding.h"
+#include "CopyPropagation.h"
+#include "DeadGlobalElimination.h"
+#include "GlobalCodeMotion.h"
+#include "IPConstantPropagation.h"
+#include "IfConversion.h"
+#include "JumpThreading.h"
+#include "InstCombine.h"
+#include "LoopElimination.h"
+#include "LoopInterchange.h"
+#include "LoopParallelization.h"
+#include "LoopRotate.h"
+#include "LoopScalarReplacement.h"
+#include "LoopUnroll.h"
+#include "LoopUnswitch.h"
+#include "Memoization.h"
+#include "PartialRedundancyElimination.h"
+#include "RangeFolding.h"
+#include "ScalarPromotion.h"
+#include "ScalarReplacement.h"
+#include "SimplifyCFG.h"
+#include "StoreForwarding.h"
+
+/// @brief 是否进行控制流优化
+extern int controlFlowOpt;
+
+///@brief 是否进行数据流优化
+extern int dataFlowOpt;
+
+/// @brief 是否对纯递归函数进行记忆化
+extern int memoizeOpt;
+
+/// @brief 是否把没有跨迭代依赖的循环并行化
+extern int parallelOpt;
+
+/// @brief 对符号表中所有用户定义的函数执行IR优化遍
+/// @param symtab 符号表
+void optimizeIR(SymbolTable & symtab)
+{
+    // 常量实参传入被调函数后，循环边界与除数成为常量，先于函数内的循环变换进行
+    if (dataFlowOpt) {
+        IPConstantPropagation(symtab).run();
+    }
+
+    for (auto func: symtab.getFunctionList()) {
+        if (func->isBuiltin()) {
+            continue;
+        }
+
+        // 常量下标访问的小局部数组拆成标量，循环变换与寄存器分配都能直接处理
+        if (dataFlowOpt) {
+            // 传入的常量实参折叠后，循环边界与下标表达式先化简为规范形式。
+            // 展开前不做重结合，展开出的相邻迭代的下标保持变量加常量的形式，存储转发可以识别相同的地址
+            InstCombine(func, false).run();
+
+            ScalarReplacement(func).run();
+        }
+
+        if (controlFlowOpt) {
+            // 无用循环删除与标量循环的闭式替换，先于其它循环变换以免循环结构被改写
+            LoopElimination(func).run();
+
+            // 循环不变条件外提
+            LoopUnswitch(func).run();
+
+            // 两层嵌套循环交换与分块
+            LoopInterchange(func).run();
+        }
+    }
+
+    // 并行化按循环交换后的访问顺序做依赖测试，外提出的循环函数与其它函数一起展开
+    if (controlFlowOpt && parallelOpt) {
+        LoopParallelization(symtab).run();
+    }
+
+    for (auto func: symtab.getFunctionList()) {
+        if (func->isBuiltin()) {
+            continue;
+        }
+
+        if (controlFlowOpt) {
+            // 计数循环展开
+            LoopUnroll(func).run();
+
+            // 循环旋转放在最后，前面的循环变换都按照循环头判断条件的形式识别循环
+            LoopRotate(func).run();
+        }
+    }
+
+    if (dataFlowOpt) {
+        // 副作用摘要在循环变换之后计算，后续的遍只会减少访存，摘要保持保守
+        CallGraph callGraph(symtab);
+        for (auto func: symtab.getFunctionList()) {
+            if (func->isBuiltin()) {
+                continue;
+            }
+
+            // 循环内不与函数调用冲突的全局标量提升为临时变量，先于存储转发以便出口处的写回被合并
+            ScalarPromotion(func, callGraph).run();
+
+            // 数组元素与全局变量的存储转发与死存储删除，在循环展开之后进行以覆盖展开出的重复访存
+            StoreForwarding(func, callGraph).run();
+
+            // 迭代内的重复读已被转发，相邻迭代重复读取的数组元素再改由轮转的临时变量传递
+            LoopScalarReplacement(func, callGraph).run();
+
+            // 循环条件约束了取值范围的比较与运算折叠为常量
+            RangeFolding(func).run();
+
+            // 下标区间已知的const数组读取改为常量、下标的线性运算或select
+            ConstArrayFolding(func).run();
+
+            // 转发与替换得到的复制常量与展开出的地址偏移再做一次化简
+            InstCombine(func).run();
+
+            // 展开与转发之后重复的下标计算在各条路径上合并，只在部分路径上冗余的运算移动到最晚的安全位置
+            PartialRedundancyElimination(func).run();
+
+            // 循环不变的运算提到循环之外，只在一个分支中使用的运算下沉到该分支
+            GlobalCodeMotion(func).run();
+        }
+    }
+
+    // 控制流的化简在函数内的其它优化之后进行
+    if (controlFlowOpt) {
+        for (auto func: symtab.getFunctionList()) {
+            if (func->isBuiltin()) {
+                continue;
+            }
+
+            // 各遍拆出的关键边、空的前置块与常量条件的分支统一化简，直线块合并后块内的临时变量不再跨块
+            SimplifyCFG(func).run();
+
+            // 数据相关的小分支改为select，汇合块与分支所在的块合并后，外层的分支结构再继续转换
+            while (IfConversion(func).run()) {
+                SimplifyCFG(func).run();
+            }
+
+            // 短路求值与嵌套if中由前驱的分支已经决定走向的条件跳转，复制小块后直接跳到已知的出口
+            if (JumpThreading(func).run()) {
+                SimplifyCFG(func).run();
+            }
+        }
+    }
+
+    // 复制传播在控制流化简之后进行，if转换按分支内先运算后复制到变量的形式识别
+    if (dataFlowOpt) {
+        for (auto func: symtab.getFunctionList()) {
+            if (func->isBuiltin()) {
+                continue;
+            }
+
+            // 各优化留下的复制链传播到原始的源操作数，只被复制到变量的运算结果直接定值该变量
+            CopyPropagation(func).run();
+        }
+    }
+
+    // 记忆化改变函数的入口与出口，在函数内的优化之后进行
+    if (memoizeOpt) {
+        Memoization(symtab).run();
+    }
+
+    // 其它优化删除调用与访存之后，不再被使用的函数与全局变量不再输出
+    if (dataFlowOpt) {
+        DeadGlobalElimination(symtab).run();
+    }
+}
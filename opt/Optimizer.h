@@ -0,0 +1,11 @@
+/**
+ * @file Optimizer.h
+ * @brief 线性IR上的机器无关优化入口，在IR输出与汇编生成之前执行
+ */
+#pragma once
+
+#include "SymbolTable.h"
+
+/// @brief 对符号表中所有用户定义的函数执行IR优化遍
+/// @param symtab 符号表
+void optimizeIR(SymbolTable & symtab);
@@ -0,0 +1,737 @@
+/**
+ * @file FunctionCFG.cpp
+ * @brief 直接基于函数线性IR指令序列的控制流图
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "FunctionCFG.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 获取块尾的跳转或出口指令
+/// @return 块尾的br/bc/exit指令，没有则返回nullptr
+IRInst * IRBlock::getTerminator()
+{
+    if (insts.empty() || !isTerminatorInst(insts.back())) {
+        return nullptr;
+    }
+    return insts.back();
+}
+
+/// @brief 把bc指令统一成mode 3，即"bc temp, 真出口, 假出口"，后端对mode 3的翻译与原mode一致
+/// @param inst bc指令
+static void normalizeBc(IRInst * inst)
+{
+    BcIRInst * bc = static_cast<BcIRInst *>(inst);
+    if (bc->temp == nullptr || bc->mode == 3) {
+        return;
+    }
+    if (bc->mode == 4) {
+        // or：假出口是第二个条件的入口
+        bc->setFalseInst(bc->modeInst_1);
+    } else if (bc->mode == 5) {
+        // and：真出口是第二个条件的入口
+        bc->setTrueInst(bc->modeInst_2);
+    }
+    bc->mode = 3;
+}
+
+/// @brief 构造函数，按照函数的线性IR划分基本块并建立前驱后继关系
+/// @param _func 函数
+FunctionCFG::FunctionCFG(Function * _func) : func(_func)
+{
+    IRBlock * cur = nullptr;
+    for (auto inst: func->getInterCode().getInsts()) {
+        if (inst->getOp() == IRInstOperator::IRINST_OP_LABEL) {
+            // 顺序执行进入Label的块补上显式跳转，这样基本块的布局可以自由调整
+            if (cur != nullptr) {
+                cur->insts.push_back(new BrIRInst(inst));
+            }
+            cur = new IRBlock(inst);
+            blocks.push_back(cur);
+            labelMap[inst] = cur;
+            continue;
+        }
+        if (cur == nullptr) {
+            // 跳转指令之后没有Label的代码，不可达
+            cur = new IRBlock(nullptr);
+            blocks.push_back(cur);
+        }
+        if (inst->getOp() == IRInstOperator::IRINST_OP_BC) {
+            normalizeBc(inst);
+        }
+        cur->insts.push_back(inst);
+        if (isTerminatorInst(inst)) {
+            cur = nullptr;
+        }
+    }
+
+    buildEdges();
+}
+
+/// @brief 析构函数
+FunctionCFG::~FunctionCFG()
+{
+    for (auto block: blocks) {
+        delete block;
+    }
+    blocks.clear();
+}
+
+/// @brief 根据Label指令查找基本块
+/// @param label Label指令
+/// @return 基本块，找不到返回nullptr
+IRBlock * FunctionCFG::getBlockByLabel(IRInst * label)
+{
+    auto pIter = labelMap.find(label);
+    if (pIter == labelMap.end()) {
+        return nullptr;
+    }
+    return pIter->second;
+}
+
+/// @brief 依据块尾跳转指令重新建立前驱后继关系
+void FunctionCFG::buildEdges()
+{
+    for (auto block: blocks) {
+        block->succs.clear();
+        block->preds.clear();
+    }
+
+    std::vector<IRInst *> targets;
+    for (auto block: blocks) {
+        IRInst * term = block->getTerminator();
+        if (term == nullptr) {
+            continue;
+        }
+        targets.clear();
+        getBranchTargets(term, targets);
+        for (auto target: targets) {
+            IRBlock * succ = getBlockByLabel(target);
+            if (succ == nullptr) {
+                continue;
+            }
+            if (std::find(block->succs.begin(), block->succs.end(), succ) == block->succs.end()) {
+                block->succs.push_back(succ);
+                succ->preds.push_back(block);
+            }
+        }
+    }
+}
+
+/// @brief 计算逆后序以及直接支配结点（Cooper-Harvey-Kennedy迭代算法）
+void FunctionCFG::computeDominators()
+{
+    for (auto block: blocks) {
+        block->rpo = -1;
+        block->idom = nullptr;
+    }
+    rpoOrder.clear();
+
+    // 非递归的深度优先遍历得到后序
+    std::vector<IRBlock *> postOrder;
+    std::unordered_set<IRBlock *> visited;
+    std::vector<std::pair<IRBlock *, size_t>> stack;
+    stack.emplace_back(getEntry(), 0);
+    visited.insert(getEntry());
+    while (!stack.empty()) {
+        IRBlock * block = stack.back().first;
+        size_t & next = stack.back().second;
+        if (next < block->succs.size()) {
+            IRBlock * succ = block->succs[next++];
+            if (visited.insert(succ).second) {
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            postOrder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    rpoOrder.assign(postOrder.rbegin(), postOrder.rend());
+    for (int i = 0; i < (int) rpoOrder.size(); ++i) {
+        rpoOrder[i]->rpo = i;
+    }
+
+    IRBlock * entry = getEntry();
+    entry->idom = entry;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto block: rpoOrder) {
+            if (block == entry) {
+                continue;
+            }
+            IRBlock * newIdom = nullptr;
+            for (auto pred: block->preds) {
+                if (pred->idom == nullptr) {
+                    // 前驱尚未处理或者不可达
+                    continue;
+                }
+                if (newIdom == nullptr) {
+                    newIdom = pred;
+                    continue;
+                }
+                // 沿支配树向上求两者的最近公共支配结点
+                IRBlock * a = pred;
+                IRBlock * b = newIdom;
+                while (a != b) {
+                    while (a->rpo > b->rpo) {
+                        a = a->idom;
+                    }
+                    while (b->rpo > a->rpo) {
+                        b = b->idom;
+                    }
+                }
+                newIdom = a;
+            }
+            if (newIdom != block->idom) {
+                block->idom = newIdom;
+                changed = true;
+            }
+        }
+    }
+    entry->idom = nullptr;
+}
+
+/// @brief 判断基本块a是否支配基本块b
+bool FunctionCFG::dominates(IRBlock * a, IRBlock * b)
+{
+    if (!b->isReachable()) {
+        return false;
+    }
+    for (IRBlock * block = b; block != nullptr; block = block->idom) {
+        if (block == a) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 新建一个空基本块，插入到布局中after之后
+/// @param after 布局上的前一个块，为nullptr时追加到末尾
+/// @param label 入口Label，为nullptr时新建一个
+/// @return 新基本块
+IRBlock * FunctionCFG::createBlock(IRBlock * after, IRInst * label)
+{
+    IRBlock * block = new IRBlock(label != nullptr ? label : new LabelIRInst());
+    labelMap[block->label] = block;
+
+    auto pIter = std::find(blocks.begin(), blocks.end(), after);
+    if (after == nullptr || pIter == blocks.end()) {
+        blocks.push_back(block);
+    } else {
+        blocks.insert(pIter + 1, block);
+    }
+    return block;
+}
+
+/// @brief 新建一个带新Label的空基本块，插入到布局中before之前
+/// @param before 布局上的后一个块
+/// @return 新基本块
+IRBlock * FunctionCFG::createBlockBefore(IRBlock * before)
+{
+    auto pIter = std::find(blocks.begin(), blocks.end(), before);
+    if (pIter == blocks.begin() || pIter == blocks.end()) {
+        return createBlock(nullptr);
+    }
+    return createBlock(*(pIter - 1));
+}
+
+/// @brief 从布局中移除基本块，块内指令不再回写
+void FunctionCFG::removeBlock(IRBlock * block)
+{
+    auto pIter = std::find(blocks.begin(), blocks.end(), block);
+    if (pIter == blocks.end()) {
+        return;
+    }
+    blocks.erase(pIter);
+    if (block->label != nullptr) {
+        labelMap.erase(block->label);
+    }
+
+    // 维护相邻块的前驱后继
+    for (auto succ: block->succs) {
+        succ->preds.erase(std::remove(succ->preds.begin(), succ->preds.end(), block), succ->preds.end());
+    }
+    for (auto pred: block->preds) {
+        pred->succs.erase(std::remove(pred->succs.begin(), pred->succs.end(), block), pred->succs.end());
+    }
+    delete block;
+}
+
+/// @brief 删除从入口不可达的基本块，支配关系随之重新计算
+/// @return true：有基本块被删除
+bool FunctionCFG::removeUnreachableBlocks()
+{
+    computeDominators();
+
+    std::vector<IRBlock *> dead;
+    for (auto block: blocks) {
+        if (!block->isReachable()) {
+            dead.push_back(block);
+        }
+    }
+    for (auto block: dead) {
+        removeBlock(block);
+    }
+    return !dead.empty();
+}
+
+/// @brief 把基本块按布局顺序回写到函数的指令序列，跳转到紧随其后Label的br指令被省略
+void FunctionCFG::writeBack()
+{
+    std::vector<IRInst *> & insts = func->getInterCode().getInsts();
+    insts.clear();
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        IRBlock * block = blocks[i];
+        if (block->label != nullptr) {
+            insts.push_back(block->label);
+        }
+        for (size_t k = 0; k < block->insts.size(); ++k) {
+            IRInst * inst = block->insts[k];
+            if (k + 1 == block->insts.size() && inst->getOp() == IRInstOperator::IRINST_OP_BR &&
+                i + 1 < blocks.size() && blocks[i + 1]->label == inst->getTrueInst()) {
+                // 顺序执行即可到达，无需跳转
+                continue;
+            }
+            insts.push_back(inst);
+        }
+    }
+}
+
+/// @brief 是否是块尾指令（br、bc、exit）
+bool isTerminatorInst(IRInst * inst)
+{
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_BR:
+        case IRInstOperator::IRINST_OP_BC:
+        case IRInstOperator::IRINST_OP_EXIT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief 获取跳转指令的目标Label，bc为真、假两个出口
+/// @param inst 跳转指令
+/// @param targets 目标Label
+void getBranchTargets(IRInst * inst, std::vector<IRInst *> & targets)
+{
+    if (inst->getOp() == IRInstOperator::IRINST_OP_BR) {
+        targets.push_back(inst->getTrueInst());
+    } else if (inst->getOp() == IRInstOperator::IRINST_OP_BC) {
+        BcIRInst * bc = static_cast<BcIRInst *>(inst);
+        int mode = bc->mode;
+        if (mode == 0 || mode == 1 || mode == 3 || mode == 4) {
+            targets.push_back(bc->getTrueInst());
+        } else {
+            targets.push_back(bc->modeInst_2);
+        }
+        if (mode == 0 || mode == 2 || mode == 3 || mode == 5) {
+            targets.push_back(bc->getFalseInst());
+        } else {
+            targets.push_back(bc->modeInst_1);
+        }
+    }
+}
+
+/// @brief 把跳转指令中指向oldLabel的出口改为newLabel
+void replaceBranchTarget(IRInst * inst, IRInst * oldLabel, IRInst * newLabel)
+{
+    if (inst->getOp() == IRInstOperator::IRINST_OP_BR) {
+        if (inst->getTrueInst() == oldLabel) {
+            inst->setTrueInst(newLabel);
+            inst->setFalseInst(newLabel);
+        }
+    } else if (inst->getOp() == IRInstOperator::IRINST_OP_BC) {
+        normalizeBc(inst);
+        if (inst->getTrueInst() == oldLabel) {
+            inst->setTrueInst(newLabel);
+        }
+        if (inst->getFalseInst() == oldLabel) {
+            inst->setFalseInst(newLabel);
+        }
+    }
+}
+
+/// @brief 是否是写内存的赋值，即*dst = src
+static bool isStoreAssign(IRInst * inst)
+{
+    AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+    return assign->_flag == 3 || assign->_flag == 4 || assign->_flag == 6 || inst->Assign_flag == 6;
+}
+
+/// @brief 获取指令定值的变量，store、无返回值的函数调用等返回nullptr
+Value * getInstDef(IRInst * inst)
+{
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_ADD_I:
+        case IRInstOperator::IRINST_OP_SUB_I:
+        case IRInstOperator::IRINST_OP_MOD_I:
+        case IRInstOperator::IRINST_OP_DIV_I:
+        case IRInstOperator::IRINST_OP_MULT_I:
+        case IRInstOperator::IRINST_OP_LT:
+        case IRInstOperator::IRINST_OP_BT:
+        case IRInstOperator::IRINST_OP_LE:
+        case IRInstOperator::IRINST_OP_BE:
+        case IRInstOperator::IRINST_OP_EQ:
+        case IRInstOperator::IRINST_OP_NQ:
+        case IRInstOperator::IRINST_OP_AND:
+        case IRInstOperator::IRINST_OP_OR:
+        case IRInstOperator::IRINST_OP_SELECT:
+            return inst->getDst();
+        case IRInstOperator::IRINST_OP_ASSIGN:
+            return isStoreAssign(inst) ? nullptr : inst->getDst();
+        case IRInstOperator::IRINST_OP_FUNC_CALL:
+            if (inst->getDst() != nullptr && inst->getDst()->type.type != BasicType::TYPE_VOID) {
+                return inst->getDst();
+            }
+            return nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+/// @brief 获取指令使用的变量，包括bc的条件变量以及*p = x中的指针p
+void getInstUses(IRInst * inst, std::vector<Value *> & uses)
+{
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_BC:
+            if (static_cast<BcIRInst *>(inst)->temp != nullptr) {
+                uses.push_back(static_cast<BcIRInst *>(inst)->temp);
+            }
+            return;
+        case IRInstOperator::IRINST_OP_ASSIGN:
+            uses.push_back(inst->getSrc()[0]);
+            if (isStoreAssign(inst)) {
+                uses.push_back(inst->getDst());
+            }
+            return;
+        case IRInstOperator::IRINST_OP_LABEL:
+        case IRInstOperator::IRINST_OP_BR:
+        case IRInstOperator::IRINST_OP_ENTRY:
+            return;
+        default:
+            for (auto src: inst->getSrc()) {
+                uses.push_back(src);
+            }
+            return;
+    }
+}
+
+/// @brief 把指令中使用的from替换为to，不改变定值
+void replaceInstUse(IRInst * inst, Value * from, Value * to)
+{
+    if (inst->getOp() == IRInstOperator::IRINST_OP_BC) {
+        BcIRInst * bc = static_cast<BcIRInst *>(inst);
+        if (bc->temp == from) {
+            bc->temp = to;
+        }
+        return;
+    }
+    std::vector<Value *> & srcs = inst->getSrc();
+    for (size_t i = 0; i < srcs.size(); ++i) {
+        if (srcs[i] != from) {
+            continue;
+        }
+        srcs[i] = to;
+
+        // 立即数形式的第二操作数被替换后按普通操作数输出
+        if (i == 1 && !to->isliteral() && inst->getOp() >= IRInstOperator::IRINST_OP_ADD_I &&
+            inst->getOp() <= IRInstOperator::IRINST_OP_OR) {
+            BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+            if (binary->mode == 2 || binary->mode == 3) {
+                binary->mode = 0;
+                binary->Binary_mode = 0;
+            }
+        }
+    }
+}
+
+/// @brief 是否是可以当作寄存器处理的标量变量：局部变量、临时变量或局部const变量，非数组、非数组元素地址
+bool isScalarVar(Value * val)
+{
+    if (val == nullptr || val->isliteral()) {
+        return false;
+    }
+    // 局部const变量只在声明处定值一次，与普通的局部变量相同
+    if (!(val->isLocalVar() || val->isTemp() || val->isConst())) {
+        return false;
+    }
+    if (val->is_numpy || val->is_issavenp() || val->np != nullptr) {
+        return false;
+    }
+    if (val->type.type != BasicType::TYPE_INT && val->type.type != BasicType::TYPE_FLOAT &&
+        val->type.type != BasicType::TYPE_BOOL) {
+        return false;
+    }
+    // 全局变量可能被函数调用修改
+    return !symtab.findSymbolValue(val);
+}
+
+/// @brief 是否是整型字面量
+bool isIntLiteral(Value * val)
+{
+    return val != nullptr && val->isliteral() && val->type.type == BasicType::TYPE_INT;
+}
+
+/// @brief 是否是整型的const全局标量，初值在编译时已知
+/// @param val 变量
+/// @param value const变量的初值
+bool getConstGlobalInt(Value * val, int32_t & value)
+{
+    if (val == nullptr || !val->isConst() || val->isliteral() || val->is_numpy || val->np != nullptr ||
+        val->type.type != BasicType::TYPE_INT || !symtab.findSymbolValue(val)) {
+        return false;
+    }
+    value = val->intVal;
+    return true;
+}
+
+/// @brief 变量在进入基本块时是否活跃，即存在一条从块入口出发、先使用后定值的路径
+/// @param block 基本块
+/// @param val 变量，全局变量在函数调用与函数出口处也视为被使用
+bool isLiveIn(IRBlock * block, Value * val)
+{
+    bool isGlobal = symtab.findSymbolValue(val);
+    std::unordered_set<IRBlock *> visited;
+    std::vector<IRBlock *> worklist{block};
+    std::vector<Value *> uses;
+    visited.insert(block);
+
+    while (!worklist.empty()) {
+        IRBlock * cur = worklist.back();
+        worklist.pop_back();
+
+        bool killed = false;
+        for (auto inst: cur->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            if (std::find(uses.begin(), uses.end(), val) != uses.end()) {
+                return true;
+            }
+            if (isGlobal && (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL ||
+                             inst->getOp() == IRInstOperator::IRINST_OP_EXIT)) {
+                return true;
+            }
+            if (getInstDef(inst) == val) {
+                killed = true;
+                break;
+            }
+        }
+        if (killed) {
+            continue;
+        }
+        for (auto succ: cur->succs) {
+            if (visited.insert(succ).second) {
+                worklist.push_back(succ);
+            }
+        }
+    }
+    return false;
+}
+
+/// @brief 收集只在单个基本块内出现，且在块内先定值后使用的临时变量，复制该块时可以重命名
+/// @param cfg 控制流图
+/// @param temps 临时变量到所在基本块的映射
+void collectBlockLocalTemps(FunctionCFG * cfg, std::unordered_map<Value *, IRBlock *> & temps)
+{
+    std::unordered_set<Value *> rejected;
+    std::vector<Value *> uses;
+
+    for (auto block: cfg->getBlocks()) {
+        for (auto inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (use == nullptr || !use->isTemp()) {
+                    continue;
+                }
+                auto pIter = temps.find(use);
+                if (pIter == temps.end() || pIter->second != block) {
+                    rejected.insert(use);
+                }
+            }
+            Value * def = getInstDef(inst);
+            if (def == nullptr || !def->isTemp()) {
+                continue;
+            }
+            auto pIter = temps.find(def);
+            if (pIter == temps.end()) {
+                temps.emplace(def, block);
+            } else if (pIter->second != block) {
+                rejected.insert(def);
+            }
+        }
+    }
+
+    for (auto temp: rejected) {
+        temps.erase(temp);
+    }
+    for (auto pIter = temps.begin(); pIter != temps.end();) {
+        if (pIter->first->is_FParam()) {
+            pIter = temps.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+}
+
+/// @brief 删除结果没有被使用的临时变量的运算、复制与读内存指令
+/// @param cfg 控制流图
+/// @return true：有指令被删除
+bool removeDeadTempDefs(FunctionCFG * cfg)
+{
+    auto isRemovable = [](IRInst * inst) {
+        Value * def = getInstDef(inst);
+        if (def == nullptr || !def->isTemp() || def->is_FParam()) {
+            return false;
+        }
+        if ((inst->getOp() >= IRInstOperator::IRINST_OP_ADD_I && inst->getOp() <= IRInstOperator::IRINST_OP_OR) ||
+            inst->getOp() == IRInstOperator::IRINST_OP_SELECT) {
+            return true;
+        }
+        // 复制、读内存与取负
+        int flag = static_cast<AssignIRInst *>(inst)->_flag;
+        return inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && (flag == 0 || flag == 2 || flag == 5);
+    };
+
+    bool changed = false;
+    std::vector<Value *> uses;
+    for (bool removed = true; removed;) {
+        std::unordered_set<Value *> used;
+        for (auto block: cfg->getBlocks()) {
+            for (auto inst: block->insts) {
+                uses.clear();
+                getInstUses(inst, uses);
+                used.insert(uses.begin(), uses.end());
+            }
+        }
+
+        // 删除后其操作数可能随之变为无用，重复直到不再变化
+        removed = false;
+        for (auto block: cfg->getBlocks()) {
+            auto pIter = std::remove_if(block->insts.begin(), block->insts.end(), [&](IRInst * inst) {
+                return isRemovable(inst) && !used.count(getInstDef(inst));
+            });
+            if (pIter != block->insts.end()) {
+                block->insts.erase(pIter, block->insts.end());
+                removed = true;
+            }
+        }
+        changed |= removed;
+    }
+    return changed;
+}
+
+/// @brief 新建一个与val同属性的临时变量，用于代码复制时的重命名
+Value * cloneTempValue(Function * func, Value * val)
+{
+    Value * temp = func->newTempValue(val->type.type);
+    temp->is_numpy = val->is_numpy;
+    temp->np = val->np;
+    temp->intVal = val->intVal;
+    temp->realVal = val->realVal;
+    temp->indexLinear = val->indexLinear;
+    temp->MIN_is_three = val->MIN_is_three;
+    temp->NOT_is_three = val->NOT_is_three;
+    if (val->is_issavenp()) {
+        temp->set_is_savenp();
+    }
+    return temp;
+}
+
+/// @brief 复制一条指令，操作数按valueMap重命名，跳转目标按labelMap重定向
+/// @param inst 源指令
+/// @param valueMap 变量映射，不在映射中的变量保持不变
+/// @param labelMap Label映射，不在映射中的Label保持不变
+/// @return 新指令
+IRInst * cloneInst(IRInst * inst,
+                   std::unordered_map<Value *, Value *> & valueMap,
+                   std::unordered_map<IRInst *, IRInst *> & labelMap)
+{
+    auto mapValue = [&valueMap](Value * val) -> Value * {
+        auto pIter = valueMap.find(val);
+        return pIter == valueMap.end() ? val : pIter->second;
+    };
+    auto mapLabel = [&labelMap](IRInst * label) -> IRInst * {
+        auto pIter = labelMap.find(label);
+        return pIter == labelMap.end() ? label : pIter->second;
+    };
+
+    IRInst * newInst = nullptr;
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_LABEL:
+            newInst = mapLabel(inst);
+            if (newInst == inst) {
+                newInst = new LabelIRInst();
+            }
+            return newInst;
+        case IRInstOperator::IRINST_OP_ENTRY:
+            return new EntryIRInst();
+        case IRInstOperator::IRINST_OP_EXIT:
+            return new ExitIRInst(inst->getSrc().empty() ? nullptr : mapValue(inst->getSrc1()));
+        case IRInstOperator::IRINST_OP_BR:
+            return new BrIRInst(mapLabel(inst->getTrueInst()));
+        case IRInstOperator::IRINST_OP_BC: {
+            std::vector<IRInst *> targets;
+            getBranchTargets(inst, targets);
+            BcIRInst * bc = new BcIRInst();
+            bc->mode = 3;
+            bc->temp = mapValue(static_cast<BcIRInst *>(inst)->temp);
+            bc->setTrueInst(mapLabel(targets[0]));
+            bc->setFalseInst(mapLabel(targets[1]));
+            return bc;
+        }
+        case IRInstOperator::IRINST_OP_ASSIGN: {
+            AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+            if (assign->_flag == 6) {
+                newInst = new AssignIRInst(mapValue(inst->getDst()), assign->src, 6);
+            } else {
+                newInst = new AssignIRInst(mapValue(inst->getDst()), mapValue(inst->getSrc1()), assign->_flag);
+            }
+            break;
+        }
+        case IRInstOperator::IRINST_OP_FUNC_CALL: {
+            std::vector<Value *> params;
+            for (auto src: inst->getSrc()) {
+                params.push_back(mapValue(src));
+            }
+            newInst = new FuncCallIRInst(static_cast<FuncCallIRInst *>(inst)->name, params, mapValue(inst->getDst()));
+            break;
+        }
+        case IRInstOperator::IRINST_OP_SELECT:
+            newInst = new SelectIRInst(mapValue(inst->getDst()),
+                                       mapValue(inst->getSrc()[0]),
+                                       mapValue(inst->getSrc()[1]),
+                                       mapValue(inst->getSrc()[2]));
+            break;
+        default: {
+            BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+            if (binary->mode == 2 || binary->mode == 3) {
+                newInst = new BinaryIRInst(inst->getOp(),
+                                           mapValue(inst->getDst()),
+                                           mapValue(inst->getSrc1()),
+                                           binary->src,
+                                           binary->mode);
+            } else {
+                newInst = new BinaryIRInst(inst->getOp(),
+                                           mapValue(inst->getDst()),
+                                           mapValue(inst->getSrc1()),
+                                           mapValue(inst->getSrc2()),
+                                           binary->mode);
+            }
+            break;
+        }
+    }
+
+    newInst->Binary_mode = inst->Binary_mode;
+    newInst->Binary_src = inst->Binary_src;
+    newInst->Assign_flag = inst->Assign_flag;
+    newInst->Assign_src = inst->Assign_src;
+    newInst->isGlobal = inst->isGlobal;
+    return newInst;
+}
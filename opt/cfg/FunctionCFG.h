@@ -0,0 +1,195 @@
+/**
+ * @file FunctionCFG.h
+ * @brief 直接基于函数线性IR指令序列的控制流图，供各个IR优化遍共用
+ *
+ * 与BasicBlocks按Label名字复制指令不同，这里的基本块直接持有函数InterCode中的指令指针，
+ * 优化遍修改基本块后通过writeBack()回写到函数的指令序列中。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Function.h"
+#include "IRInst.h"
+#include "Value.h"
+
+/// @brief IR层面的基本块
+class IRBlock {
+
+public:
+    /// @brief 构造函数
+    /// @param _label 入口Label指令，不可达的尾随代码块可为空
+    IRBlock(IRInst * _label) : label(_label)
+    {}
+
+    /// @brief 获取块尾的跳转或出口指令
+    /// @return 块尾的br/bc/exit指令，没有则返回nullptr
+    IRInst * getTerminator();
+
+    /// @brief 是否从函数入口可达，需先计算支配关系
+    bool isReachable()
+    {
+        return rpo >= 0;
+    }
+
+    /// @brief 入口Label指令
+    IRInst * label;
+
+    /// @brief 块内指令，不含入口Label
+    std::vector<IRInst *> insts;
+
+    /// @brief 后继基本块
+    std::vector<IRBlock *> succs;
+
+    /// @brief 前驱基本块
+    std::vector<IRBlock *> preds;
+
+    /// @brief 直接支配结点
+    IRBlock * idom = nullptr;
+
+    /// @brief 逆后序编号，-1表示不可达
+    int rpo = -1;
+};
+
+/// @brief 函数级的控制流图
+class FunctionCFG {
+
+public:
+    /// @brief 构造函数，按照函数的线性IR划分基本块并建立前驱后继关系
+    /// @param _func 函数
+    FunctionCFG(Function * _func);
+
+    /// @brief 析构函数
+    ~FunctionCFG();
+
+    /// @brief 获取函数
+    Function * getFunction()
+    {
+        return func;
+    }
+
+    /// @brief 按布局顺序获取基本块
+    std::vector<IRBlock *> & getBlocks()
+    {
+        return blocks;
+    }
+
+    /// @brief 获取入口基本块
+    IRBlock * getEntry()
+    {
+        return blocks.front();
+    }
+
+    /// @brief 获取可达基本块的逆后序序列，需先调用computeDominators
+    std::vector<IRBlock *> & getRPO()
+    {
+        return rpoOrder;
+    }
+
+    /// @brief 根据Label指令查找基本块
+    /// @param label Label指令
+    /// @return 基本块，找不到返回nullptr
+    IRBlock * getBlockByLabel(IRInst * label);
+
+    /// @brief 依据块尾跳转指令重新建立前驱后继关系
+    void buildEdges();
+
+    /// @brief 计算逆后序以及直接支配结点（Cooper-Harvey-Kennedy迭代算法）
+    void computeDominators();
+
+    /// @brief 判断基本块a是否支配基本块b
+    bool dominates(IRBlock * a, IRBlock * b);
+
+    /// @brief 新建一个空基本块，插入到布局中after之后
+    /// @param after 布局上的前一个块，为nullptr时追加到末尾
+    /// @param label 入口Label，为nullptr时新建一个
+    /// @return 新基本块
+    IRBlock * createBlock(IRBlock * after = nullptr, IRInst * label = nullptr);
+
+    /// @brief 新建一个带新Label的空基本块，插入到布局中before之前
+    /// @param before 布局上的后一个块
+    /// @return 新基本块
+    IRBlock * createBlockBefore(IRBlock * before);
+
+    /// @brief 从布局中移除基本块，块内指令不再回写
+    void removeBlock(IRBlock * block);
+
+    /// @brief 删除从入口不可达的基本块，支配关系随之重新计算
+    /// @return true：有基本块被删除
+    bool removeUnreachableBlocks();
+
+    /// @brief 把基本块按布局顺序回写到函数的指令序列，跳转到紧随其后Label的br指令被省略
+    void writeBack();
+
+private:
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 布局顺序的基本块
+    std::vector<IRBlock *> blocks;
+
+    /// @brief Label指令到基本块的映射
+    std::unordered_map<IRInst *, IRBlock *> labelMap;
+
+    /// @brief 可达块的逆后序
+    std::vector<IRBlock *> rpoOrder;
+};
+
+/// @brief 是否是块尾指令（br、bc、exit）
+bool isTerminatorInst(IRInst * inst);
+
+/// @brief 获取跳转指令的目标Label，bc为真、假两个出口
+/// @param inst 跳转指令
+/// @param targets 目标Label
+void getBranchTargets(IRInst * inst, std::vector<IRInst *> & targets);
+
+/// @brief 把跳转指令中指向oldLabel的出口改为newLabel
+void replaceBranchTarget(IRInst * inst, IRInst * oldLabel, IRInst * newLabel);
+
+/// @brief 获取指令定值的变量，store、无返回值的函数调用等返回nullptr
+Value * getInstDef(IRInst * inst);
+
+/// @brief 获取指令使用的变量，包括bc的条件变量以及*p = x中的指针p
+void getInstUses(IRInst * inst, std::vector<Value *> & uses);
+
+/// @brief 把指令中使用的from替换为to，不改变定值
+void replaceInstUse(IRInst * inst, Value * from, Value * to);
+
+/// @brief 是否是可以当作寄存器处理的标量变量：局部变量、临时变量或局部const变量，非数组、非数组元素地址
+bool isScalarVar(Value * val);
+
+/// @brief 是否是整型字面量
+bool isIntLiteral(Value * val);
+
+/// @brief 是否是整型的const全局标量，初值在编译时已知
+/// @param val 变量
+/// @param value const变量的初值
+bool getConstGlobalInt(Value * val, int32_t & value);
+
+/// @brief 变量在进入基本块时是否活跃，即存在一条从块入口出发、先使用后定值的路径
+/// @param block 基本块
+/// @param val 变量，全局变量在函数调用与函数出口处也视为被使用
+bool isLiveIn(IRBlock * block, Value * val);
+
+/// @brief 收集只在单个基本块内出现，且在块内先定值后使用的临时变量，复制该块时可以重命名
+/// @param cfg 控制流图
+/// @param temps 临时变量到所在基本块的映射
+void collectBlockLocalTemps(FunctionCFG * cfg, std::unordered_map<Value *, IRBlock *> & temps);
+
+/// @brief 删除结果没有被使用的临时变量的运算、复制与读内存指令
+/// @param cfg 控制流图
+/// @return true：有指令被删除
+bool removeDeadTempDefs(FunctionCFG * cfg);
+
+/// @brief 新建一个与val同属性的临时变量，用于代码复制时的重命名
+Value * cloneTempValue(Function * func, Value * val);
+
+/// @brief 复制一条指令，操作数按valueMap重命名，跳转目标按labelMap重定向
+/// @param inst 源指令
+/// @param valueMap 变量映射，不在映射中的变量保持不变
+/// @param labelMap Label映射，不在映射中的Label保持不变
+/// @return 新指令
+IRInst * cloneInst(IRInst * inst,
+                   std::unordered_map<Value *, Value *> & valueMap,
+                   std::unordered_map<IRInst *, IRInst *> & labelMap);
@@ -0,0 +1,289 @@
+/**
+ * @file IfConversion.cpp
+ * @brief if转换：分支中只有少量无副作用整型运算的菱形与三角形结构改为在条件跳转之前计算两个分支，
+ * 再用select按条件选取被修改的变量，消除数据相关的难以预测的跳转
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "IfConversion.h"
+
+/// @brief 是否是可以放在整型寄存器中的标量变量
+static bool isIntScalar(Value * val)
+{
+    return isScalarVar(val) && val->type.type != BasicType::TYPE_FLOAT;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _maxSpeculated 两个分支中提前计算的运算的最大个数
+/// @param _maxSelects 每个分支结构产生的select的最大个数
+IfConversion::IfConversion(Function * _func, int _maxSpeculated, int _maxSelects)
+    : func(_func), maxSpeculated(_maxSpeculated), maxSelects(_maxSelects)
+{}
+
+/// @brief 转换函数内的分支结构
+/// @return true：函数的IR被修改
+bool IfConversion::run()
+{
+    FunctionCFG graph(func);
+    cfg = &graph;
+
+    // 内层的分支结构转换后，外层的分支块可能成为新的候选
+    bool changed = false;
+    for (bool progress = true; progress;) {
+        progress = false;
+        localTemps.clear();
+        collectBlockLocalTemps(cfg, localTemps);
+
+        std::vector<IRBlock *> blocks = graph.getBlocks();
+        std::unordered_set<IRBlock *> removed;
+        for (auto block: blocks) {
+            if (removed.count(block)) {
+                continue;
+            }
+            std::vector<IRBlock *> succs = block->succs;
+            if (convert(block)) {
+                removed.insert(succs.begin(), succs.end());
+                progress = true;
+            }
+        }
+        changed |= progress;
+    }
+
+    if (changed) {
+        graph.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 转换以基本块尾部bc开始的菱形或三角形结构
+/// @param block 分支所在的基本块
+/// @return true：已转换
+bool IfConversion::convert(IRBlock * block)
+{
+    IRInst * term = block->getTerminator();
+    if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BC) {
+        return false;
+    }
+    Value * cond = static_cast<BcIRInst *>(term)->temp;
+    if (cond == nullptr || !cond->isTemp()) {
+        return false;
+    }
+
+    // select要求条件只取0或1，条件必须是块内比较的结果
+    IRInst * condDef = nullptr;
+    for (size_t i = block->insts.size() - 1; i-- > 0;) {
+        if (getInstDef(block->insts[i]) == cond) {
+            condDef = block->insts[i];
+            break;
+        }
+    }
+    if (condDef == nullptr || condDef->getOp() < IRInstOperator::IRINST_OP_LT ||
+        condDef->getOp() > IRInstOperator::IRINST_OP_NQ) {
+        return false;
+    }
+
+    std::vector<IRInst *> targets;
+    getBranchTargets(term, targets);
+    IRBlock * trueBlock = cfg->getBlockByLabel(targets[0]);
+    IRBlock * falseBlock = cfg->getBlockByLabel(targets[1]);
+    if (trueBlock == nullptr || falseBlock == nullptr || trueBlock == falseBlock) {
+        return false;
+    }
+
+    // 菱形：两个出口都是分支块并汇合到同一个块；三角形：一个出口是分支块，另一个出口就是汇合块
+    IRBlock * trueArm = nullptr;
+    IRBlock * falseArm = nullptr;
+    IRBlock * join = nullptr;
+    IRBlock * trueSucc = getArmSucc(block, trueBlock);
+    IRBlock * falseSucc = getArmSucc(block, falseBlock);
+    if (trueSucc != nullptr && trueSucc == falseSucc) {
+        trueArm = trueBlock;
+        falseArm = falseBlock;
+        join = trueSucc;
+    } else if (trueSucc == falseBlock) {
+        trueArm = trueBlock;
+        join = falseBlock;
+    } else if (falseSucc == trueBlock) {
+        falseArm = falseBlock;
+        join = trueBlock;
+    } else {
+        return false;
+    }
+    if (join == block) {
+        return false;
+    }
+
+    std::vector<Value *> defs;
+    int computed = 0;
+    if (!checkArm(trueArm, cond, defs, computed) || !checkArm(falseArm, cond, defs, computed) ||
+        computed > maxSpeculated) {
+        return false;
+    }
+
+    // 在分支之外还被使用的变量需要按条件选取两个分支出口处的值
+    std::vector<Value *> outputs;
+    for (auto def: defs) {
+        auto pIter = localTemps.find(def);
+        if (pIter == localTemps.end() || (pIter->second != trueArm && pIter->second != falseArm)) {
+            outputs.push_back(def);
+        }
+    }
+    if ((int) outputs.size() > maxSelects) {
+        return false;
+    }
+
+    std::unordered_map<Value *, Value *> trueMap, falseMap;
+    std::vector<IRInst *> code;
+    speculate(trueArm, trueMap, code);
+    speculate(falseArm, falseMap, code);
+
+    auto exitValue = [](std::unordered_map<Value *, Value *> & valueMap, Value * val) {
+        auto pIter = valueMap.find(val);
+        return pIter == valueMap.end() ? val : pIter->second;
+    };
+    // select依次写回变量，读取其它被写回变量原值的操作数先复制一份。两个出口处的值相同时直接复制
+    std::vector<IRInst *> selects;
+    std::unordered_map<Value *, Value *> snapshots;
+    for (auto output: outputs) {
+        Value * operands[2] = {exitValue(trueMap, output), exitValue(falseMap, output)};
+        for (auto & operand: operands) {
+            if (operand == output || std::find(outputs.begin(), outputs.end(), operand) == outputs.end()) {
+                continue;
+            }
+            if (!snapshots.count(operand)) {
+                snapshots[operand] = cloneTempValue(func, operand);
+                code.push_back(new AssignIRInst(snapshots[operand], operand));
+            }
+            operand = snapshots[operand];
+        }
+        if (operands[0] == operands[1]) {
+            if (operands[0] != output) {
+                selects.push_back(new AssignIRInst(output, operands[0]));
+            }
+        } else {
+            selects.push_back(new SelectIRInst(output, cond, operands[0], operands[1]));
+        }
+    }
+
+    // 提前计算的运算与select放在bc之前，bc改为跳转到汇合块
+    block->insts.pop_back();
+    block->insts.insert(block->insts.end(), code.begin(), code.end());
+    block->insts.insert(block->insts.end(), selects.begin(), selects.end());
+    block->insts.push_back(new BrIRInst(join->label));
+    if (trueArm != nullptr) {
+        cfg->removeBlock(trueArm);
+    }
+    if (falseArm != nullptr) {
+        cfg->removeBlock(falseArm);
+    }
+    cfg->buildEdges();
+    return true;
+}
+
+/// @brief 是否是只有block一个前驱、以br结尾的分支块，返回br的目标块
+IRBlock * IfConversion::getArmSucc(IRBlock * block, IRBlock * arm)
+{
+    if (arm == block || arm == cfg->getEntry() || arm->preds.size() != 1 || arm->preds[0] != block) {
+        return nullptr;
+    }
+    IRInst * term = arm->getTerminator();
+    if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BR) {
+        return nullptr;
+    }
+    return cfg->getBlockByLabel(term->getTrueInst());
+}
+
+/// @brief 检查分支块中的指令是否都能提前计算，并统计需要计算的运算个数
+/// @param arm 分支块，nullptr表示空分支
+/// @param cond 条件变量，分支中不能被定值
+/// @param defs 分支中定值的变量，按第一次定值的顺序
+/// @param computed 复制之外的运算个数，累加到原值上
+/// @return false：分支中有不能提前计算的指令
+bool IfConversion::checkArm(IRBlock * arm, Value * cond, std::vector<Value *> & defs, int & computed)
+{
+    if (arm == nullptr) {
+        return true;
+    }
+
+    std::vector<Value *> uses;
+    for (size_t i = 0; i + 1 < arm->insts.size(); ++i) {
+        IRInst * inst = arm->insts[i];
+        IRInstOperator op = inst->getOp();
+        Value * dst = getInstDef(inst);
+        if (dst == nullptr || dst == cond || !isIntScalar(dst)) {
+            return false;
+        }
+
+        // 只提前计算不会出错且代价固定的运算，除法与取余除外。内层已经转换的select也可以提前计算
+        bool copy = false;
+        if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if ((flag != 0 && flag != 5) || inst->Assign_flag == 6) {
+                return false;
+            }
+            copy = flag == 0;
+        } else if (op != IRInstOperator::IRINST_OP_SELECT &&
+                   (op == IRInstOperator::IRINST_OP_DIV_I || op == IRInstOperator::IRINST_OP_MOD_I ||
+                    op < IRInstOperator::IRINST_OP_ADD_I || op > IRInstOperator::IRINST_OP_NQ ||
+                    static_cast<BinaryIRInst *>(inst)->mode > 3)) {
+            return false;
+        }
+        uses.clear();
+        getInstUses(inst, uses);
+        for (auto use: uses) {
+            if (!isIntLiteral(use) && !isIntScalar(use)) {
+                return false;
+            }
+        }
+        // 改名后的结果不能同时作为操作数
+        if (!copy && std::find(uses.begin(), uses.end(), dst) != uses.end()) {
+            return false;
+        }
+
+        if (std::find(defs.begin(), defs.end(), dst) == defs.end()) {
+            defs.push_back(dst);
+        }
+        computed += copy ? 0 : 1;
+    }
+    return true;
+}
+
+/// @brief 把分支块中的运算改名后复制到code中，复制指令只记录改名
+/// @param arm 分支块，nullptr表示空分支
+/// @param valueMap 分支中定值的变量到其在分支出口处的值
+/// @param code 提前计算的运算
+void IfConversion::speculate(IRBlock * arm, std::unordered_map<Value *, Value *> & valueMap, std::vector<IRInst *> & code)
+{
+    if (arm == nullptr) {
+        return;
+    }
+
+    auto current = [&valueMap](Value * val) {
+        auto pIter = valueMap.find(val);
+        return pIter == valueMap.end() ? val : pIter->second;
+    };
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    std::vector<Value *> uses;
+    for (size_t i = 0; i + 1 < arm->insts.size(); ++i) {
+        IRInst * inst = arm->insts[i];
+        Value * dst = getInstDef(inst);
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0) {
+            valueMap[dst] = current(inst->getSrc1());
+            continue;
+        }
+
+        // 结果写到新的临时变量，操作数取分支内当前的值
+        std::unordered_map<Value *, Value *> instMap;
+        uses.clear();
+        getInstUses(inst, uses);
+        for (auto use: uses) {
+            instMap[use] = current(use);
+        }
+        Value * temp = cloneTempValue(func, dst);
+        instMap[dst] = temp;
+        code.push_back(cloneInst(inst, instMap, labelMap));
+        valueMap[dst] = temp;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file IfConversion.h
+ * @brief if转换：分支中只有少量无副作用整型运算的菱形与三角形结构改为在条件跳转之前计算两个分支，
+ * 再用select按条件选取被修改的变量，消除数据相关的难以预测的跳转
+ *
+ * 分支中的运算结果改名为新的临时变量后提前计算，复制只记录改名而不产生指令。
+ * 提前计算的运算个数与select的个数都不超过给定的上限，超过时保留原来的跳转。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "FunctionCFG.h"
+
+/// @brief 把小的菱形与三角形分支结构转换为无跳转的select
+class IfConversion {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _maxSpeculated 两个分支中提前计算的运算的最大个数
+    /// @param _maxSelects 每个分支结构产生的select的最大个数
+    IfConversion(Function * _func, int _maxSpeculated = 2, int _maxSelects = 2);
+
+    /// @brief 转换函数内的分支结构
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 转换以基本块尾部bc开始的菱形或三角形结构
+    /// @param block 分支所在的基本块
+    /// @return true：已转换
+    bool convert(IRBlock * block);
+
+    /// @brief 是否是只有block一个前驱、以br结尾的分支块，返回br的目标块
+    IRBlock * getArmSucc(IRBlock * block, IRBlock * arm);
+
+    /// @brief 检查分支块中的指令是否都能提前计算，并统计需要计算的运算个数
+    /// @param arm 分支块，nullptr表示空分支
+    /// @param cond 条件变量，分支中不能被定值
+    /// @param defs 分支中定值的变量，按第一次定值的顺序
+    /// @param computed 复制之外的运算个数，累加到原值上
+    /// @return false：分支中有不能提前计算的指令
+    bool checkArm(IRBlock * arm, Value * cond, std::vector<Value *> & defs, int & computed);
+
+    /// @brief 把分支块中的运算改名后复制到code中，复制指令只记录改名
+    /// @param arm 分支块，nullptr表示空分支
+    /// @param valueMap 分支中定值的变量到其在分支出口处的值
+    /// @param code 提前计算的运算
+    void speculate(IRBlock * arm, std::unordered_map<Value *, Value *> & valueMap, std::vector<IRInst *> & code);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 两个分支中提前计算的运算的最大个数
+    int maxSpeculated;
+
+    /// @brief 每个分支结构产生的select的最大个数
+    int maxSelects;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg = nullptr;
+
+    /// @brief 只在一个基本块内定值与使用的临时变量，分支块内的不需要select
+    std::unordered_map<Value *, IRBlock *> localTemps;
+};
@@ -0,0 +1,489 @@
+/**
+ * @file JumpThreading.cpp
+ * @brief 跳转线程化：前驱沿边已知的条件事实能确定后继块中bc的走向时，复制该后继块，
+ * 让前驱直接跳到已知的出口，删除路径上多余的条件跳转
+ */
+#include <algorithm>
+#include <climits>
+
+#include "JumpThreading.h"
+
+/// @brief 沿前驱链收集事实的最大深度
+static const int maxChainDepth = 8;
+
+/// @brief 是否是可以放在整型寄存器中的标量变量，全局变量不在其中，不会被函数调用修改
+static bool isIntScalar(Value * val)
+{
+    return isScalarVar(val) && val->type.type != BasicType::TYPE_FLOAT;
+}
+
+/// @brief 是否是比较运算
+static bool isCompare(IRInstOperator op)
+{
+    return op >= IRInstOperator::IRINST_OP_LT && op <= IRInstOperator::IRINST_OP_NQ;
+}
+
+/// @brief 交换操作数后对应的比较运算
+static IRInstOperator swapCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LE;
+        default:
+            return op;
+    }
+}
+
+/// @brief 结果取反后对应的比较运算
+static IRInstOperator invertCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LE;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_EQ:
+            return IRInstOperator::IRINST_OP_NQ;
+        default:
+            return IRInstOperator::IRINST_OP_EQ;
+    }
+}
+
+/// @brief 比较运算允许的大小关系，1：小于，2：等于，4：大于
+static int compareRelations(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return 1;
+        case IRInstOperator::IRINST_OP_LE:
+            return 3;
+        case IRInstOperator::IRINST_OP_BT:
+            return 4;
+        case IRInstOperator::IRINST_OP_BE:
+            return 6;
+        case IRInstOperator::IRINST_OP_EQ:
+            return 2;
+        default:
+            return 5;
+    }
+}
+
+/// @brief 常量比较的结果
+static bool evalCompare(IRInstOperator op, int64_t lhs, int64_t rhs)
+{
+    int relation = lhs < rhs ? 1 : (lhs == rhs ? 2 : 4);
+    return (compareRelations(op) & relation) != 0;
+}
+
+/// @brief 取比较或整型运算的两个操作数，操作数须是整型标量变量或者整型常量
+static bool getOperands(IRInst * inst, CompareOperand & lhs, CompareOperand & rhs)
+{
+    if (static_cast<BinaryIRInst *>(inst)->mode > 3) {
+        return false;
+    }
+    CompareOperand * operands[2] = {&lhs, &rhs};
+    Value * srcs[2] = {inst->getSrc1(), inst->getSrc2()};
+    for (int i = 0; i < 2; ++i) {
+        if (isIntLiteral(srcs[i])) {
+            operands[i]->var = nullptr;
+            operands[i]->value = srcs[i]->intVal;
+        } else if (isIntScalar(srcs[i])) {
+            operands[i]->var = srcs[i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _maxBlockSize 可以复制的基本块的最大指令数
+/// @param _maxGrowth 函数内复制的指令总数的上限
+JumpThreading::JumpThreading(Function * _func, int _maxBlockSize, int _maxGrowth)
+    : func(_func), maxBlockSize(_maxBlockSize), growthBudget(_maxGrowth)
+{}
+
+/// @brief 线程化函数内的跳转
+/// @return true：函数的IR被修改
+bool JumpThreading::run()
+{
+    FunctionCFG graph(func);
+    cfg = &graph;
+
+    // 每轮在支配关系不变的图上线程化，修改过的块等下一轮重建前驱后继关系后再处理
+    bool changed = false;
+    for (bool progress = true; progress;) {
+        progress = false;
+        graph.computeDominators();
+        localTemps.clear();
+        collectBlockLocalTemps(cfg, localTemps);
+
+        std::vector<IRBlock *> blocks = graph.getBlocks();
+        std::unordered_set<IRBlock *> touched;
+        for (auto block: blocks) {
+            IRInst * term = block->getTerminator();
+            if (touched.count(block) || !block->isReachable() || block == graph.getEntry() || term == nullptr ||
+                term->getOp() != IRInstOperator::IRINST_OP_BC || static_cast<BcIRInst *>(term)->temp == nullptr ||
+                (int) block->insts.size() - 1 > maxBlockSize) {
+                continue;
+            }
+
+            // 循环头被复制后循环会有多个入口，不处理
+            if (std::any_of(block->preds.begin(), block->preds.end(), [&](IRBlock * pred) {
+                    return graph.dominates(block, pred);
+                })) {
+                continue;
+            }
+
+            std::vector<IRInst *> targets;
+            getBranchTargets(term, targets);
+            std::vector<IRBlock *> preds = block->preds;
+            for (auto pred: preds) {
+                if (touched.count(pred) || !pred->isReachable()) {
+                    continue;
+                }
+                bool copy = preds.size() > 1;
+                if (copy && (int) block->insts.size() - 1 > growthBudget) {
+                    continue;
+                }
+
+                collectEdgeFacts(pred, block);
+                int result = evaluateBranch(block);
+                if (result < 0) {
+                    continue;
+                }
+
+                thread(pred, block, result ? targets[0] : targets[1]);
+                touched.insert(pred);
+                touched.insert(block);
+                progress = true;
+                break;
+            }
+        }
+
+        if (progress) {
+            graph.buildEdges();
+            graph.removeUnreachableBlocks();
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        graph.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 收集前驱到后继的边上成立的事实
+/// @param pred 前驱块
+/// @param block 后继块
+void JumpThreading::collectEdgeFacts(IRBlock * pred, IRBlock * block)
+{
+    facts.clear();
+    constants.clear();
+
+    // 自下而上遍历前驱及其唯一前驱链，下方已定值的变量不再采用上方的事实与常量
+    std::unordered_set<Value *> killed;
+    std::unordered_set<IRBlock *> visited{block};
+    IRBlock * from = block;
+    for (IRBlock * cur = pred; cur != nullptr && visited.insert(cur).second && (int) visited.size() <= maxChainDepth;) {
+        IRInst * term = cur->getTerminator();
+        if (term != nullptr && term->getOp() == IRInstOperator::IRINST_OP_BC) {
+            std::vector<IRInst *> targets;
+            getBranchTargets(term, targets);
+            if (targets[0] != targets[1]) {
+                addBranchFact(cur, targets[0] == from->label, killed);
+            }
+        }
+
+        for (size_t i = cur->insts.size(); i-- > 0;) {
+            IRInst * inst = cur->insts[i];
+            Value * def = getInstDef(inst);
+            if (def == nullptr || killed.count(def)) {
+                continue;
+            }
+            if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0 &&
+                inst->Assign_flag != 6 && isIntScalar(def) && isIntLiteral(inst->getSrc1()) && !constants.count(def)) {
+                constants[def] = inst->getSrc1()->intVal;
+            }
+            killed.insert(def);
+        }
+
+        from = cur;
+        cur = cur->preds.size() == 1 ? cur->preds[0] : nullptr;
+    }
+}
+
+/// @brief 把块尾bc在一个出口上的条件加入事实
+/// @param block 以bc结尾的基本块
+/// @param taken true：条件为真的出口
+/// @param killed 出口之后被重新定值的变量
+void JumpThreading::addBranchFact(IRBlock * block, bool taken, std::unordered_set<Value *> & killed)
+{
+    Value * cond = static_cast<BcIRInst *>(block->getTerminator())->temp;
+    if (cond == nullptr || !isIntScalar(cond) || killed.count(cond)) {
+        return;
+    }
+
+    // 条件是块内比较的结果时，比较的两个操作数在比较之后未被修改，比较的关系在出口上成立
+    std::unordered_set<Value *> laterDefs;
+    IRInst * cmp = nullptr;
+    for (size_t i = block->insts.size() - 1; i-- > 0;) {
+        IRInst * inst = block->insts[i];
+        Value * def = getInstDef(inst);
+        if (def == cond) {
+            cmp = inst;
+            break;
+        }
+        laterDefs.insert(def);
+    }
+
+    CompareOperand lhs, rhs;
+    if (cmp != nullptr && isCompare(cmp->getOp()) && getOperands(cmp, lhs, rhs)) {
+        constants[cond] = taken ? 1 : 0;
+        for (auto operand: {lhs.var, rhs.var}) {
+            if (operand != nullptr && (operand == cond || laterDefs.count(operand) || killed.count(operand))) {
+                return;
+            }
+        }
+        facts.push_back({taken ? cmp->getOp() : invertCompare(cmp->getOp()), lhs, rhs});
+        return;
+    }
+
+    CompareOperand zero;
+    lhs.var = cond;
+    facts.push_back({taken ? IRInstOperator::IRINST_OP_NQ : IRInstOperator::IRINST_OP_EQ, lhs, zero});
+}
+
+/// @brief 按边上的事实执行后继块，求bc条件的值
+/// @param block 后继块
+/// @return 1：条件为真，0：条件为假，-1：不确定
+int JumpThreading::evaluateBranch(IRBlock * block)
+{
+    blockKills.clear();
+    for (size_t i = 0; i + 1 < block->insts.size(); ++i) {
+        IRInst * inst = block->insts[i];
+        Value * def = getInstDef(inst);
+        if (def == nullptr) {
+            continue;
+        }
+        blockKills.insert(def);
+
+        // 块内的复制、比较与加减乘在操作数已知时求值
+        IRInstOperator op = inst->getOp();
+        bool known = false;
+        int32_t value = 0;
+        CompareOperand lhs, rhs;
+        if (!isIntScalar(def)) {
+            constants.erase(def);
+            continue;
+        }
+        if (op == IRInstOperator::IRINST_OP_ASSIGN && inst->Assign_flag != 6) {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            Value * src = inst->getSrc1();
+            if ((flag == 0 || flag == 5) && (isIntLiteral(src) || isIntScalar(src))) {
+                lhs.var = isIntLiteral(src) ? nullptr : src;
+                lhs.value = isIntLiteral(src) ? src->intVal : 0;
+                lhs = resolve(lhs);
+                known = lhs.var == nullptr;
+                value = flag == 5 ? (int32_t) (0u - (uint32_t) lhs.value) : lhs.value;
+            }
+        } else if (isCompare(op) && getOperands(inst, lhs, rhs)) {
+            int result = evaluateCompare(op, lhs, rhs);
+            known = result >= 0;
+            value = result;
+        } else if ((op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_SUB_I ||
+                    op == IRInstOperator::IRINST_OP_MULT_I) &&
+                   getOperands(inst, lhs, rhs)) {
+            lhs = resolve(lhs);
+            rhs = resolve(rhs);
+            if (lhs.var == nullptr && rhs.var == nullptr) {
+                uint32_t a = (uint32_t) lhs.value, b = (uint32_t) rhs.value;
+                known = true;
+                value = (int32_t) (op == IRInstOperator::IRINST_OP_ADD_I   ? a + b
+                                   : op == IRInstOperator::IRINST_OP_SUB_I ? a - b
+                                                                           : a * b);
+            }
+        }
+
+        constants.erase(def);
+        if (known) {
+            constants[def] = value;
+        }
+    }
+
+    CompareOperand cond, zero;
+    cond.var = static_cast<BcIRInst *>(block->getTerminator())->temp;
+    if (!isIntScalar(cond.var)) {
+        return -1;
+    }
+    return evaluateCompare(IRInstOperator::IRINST_OP_NQ, cond, zero);
+}
+
+/// @brief 操作数替换为已知的常量
+CompareOperand JumpThreading::resolve(CompareOperand operand)
+{
+    if (operand.var != nullptr) {
+        auto pIter = constants.find(operand.var);
+        if (pIter != constants.end()) {
+            operand.var = nullptr;
+            operand.value = pIter->second;
+        }
+    }
+    return operand;
+}
+
+/// @brief 按事实与已知常量求比较的值
+/// @return 1：为真，0：为假，-1：不确定
+int JumpThreading::evaluateCompare(IRInstOperator op, CompareOperand lhs, CompareOperand rhs)
+{
+    lhs = resolve(lhs);
+    rhs = resolve(rhs);
+    if (lhs.var == nullptr && rhs.var == nullptr) {
+        return evalCompare(op, lhs.value, rhs.value);
+    }
+    if (lhs.var == rhs.var) {
+        return evalCompare(op, 0, 0);
+    }
+    if (lhs.var == nullptr) {
+        std::swap(lhs, rhs);
+        op = swapCompare(op);
+    }
+
+    // 后继块中被重新定值的变量上的事实不再成立
+    std::vector<CompareFact> valid;
+    for (auto & fact: facts) {
+        CompareFact f{fact.op, resolve(fact.lhs), resolve(fact.rhs)};
+        if ((fact.lhs.var != nullptr && blockKills.count(fact.lhs.var)) ||
+            (fact.rhs.var != nullptr && blockKills.count(fact.rhs.var))) {
+            continue;
+        }
+        if (f.lhs.var == nullptr) {
+            std::swap(f.lhs, f.rhs);
+            f.op = swapCompare(f.op);
+        }
+        if (f.lhs.var == lhs.var) {
+            valid.push_back(f);
+        } else if (f.rhs.var == lhs.var && f.rhs.var != nullptr) {
+            valid.push_back({swapCompare(f.op), f.rhs, f.lhs});
+        }
+    }
+
+    if (rhs.var != nullptr) {
+        // 两个变量之间的比较，按同一对变量的事实求可能的大小关系
+        int possible = 7;
+        for (auto & fact: valid) {
+            if (fact.rhs == rhs) {
+                possible &= compareRelations(fact.op);
+            }
+        }
+        int relations = compareRelations(op);
+        if (possible == 0) {
+            return -1;
+        }
+        if ((possible & ~relations) == 0) {
+            return 1;
+        }
+        return (possible & relations) == 0 ? 0 : -1;
+    }
+
+    // 变量与常量的比较，按变量与常量的事实求变量的取值区间
+    int64_t lo = INT32_MIN, hi = INT32_MAX;
+    std::unordered_set<int64_t> excluded;
+    for (auto & fact: valid) {
+        if (fact.rhs.var != nullptr) {
+            continue;
+        }
+        int64_t c = fact.rhs.value;
+        switch (fact.op) {
+            case IRInstOperator::IRINST_OP_LT:
+                hi = std::min(hi, c - 1);
+                break;
+            case IRInstOperator::IRINST_OP_LE:
+                hi = std::min(hi, c);
+                break;
+            case IRInstOperator::IRINST_OP_BT:
+                lo = std::max(lo, c + 1);
+                break;
+            case IRInstOperator::IRINST_OP_BE:
+                lo = std::max(lo, c);
+                break;
+            case IRInstOperator::IRINST_OP_EQ:
+                lo = std::max(lo, c);
+                hi = std::min(hi, c);
+                break;
+            default:
+                excluded.insert(c);
+                break;
+        }
+    }
+    while (lo <= hi && excluded.count(lo)) {
+        ++lo;
+    }
+    while (lo <= hi && excluded.count(hi)) {
+        --hi;
+    }
+    if (lo > hi) {
+        return -1;
+    }
+
+    int64_t c = rhs.value;
+    if (lo == hi) {
+        return evalCompare(op, lo, c);
+    }
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return hi < c ? 1 : (lo >= c ? 0 : -1);
+        case IRInstOperator::IRINST_OP_LE:
+            return hi <= c ? 1 : (lo > c ? 0 : -1);
+        case IRInstOperator::IRINST_OP_BT:
+            return lo > c ? 1 : (hi <= c ? 0 : -1);
+        case IRInstOperator::IRINST_OP_BE:
+            return lo >= c ? 1 : (hi < c ? 0 : -1);
+        case IRInstOperator::IRINST_OP_EQ:
+            return (c < lo || c > hi || excluded.count(c)) ? 0 : -1;
+        default:
+            return (c < lo || c > hi || excluded.count(c)) ? 1 : -1;
+    }
+}
+
+/// @brief 复制后继块，前驱改为跳转到副本，副本直接跳转到已知的出口
+/// @param pred 前驱块
+/// @param block 后继块
+/// @param target 已知的出口
+void JumpThreading::thread(IRBlock * pred, IRBlock * block, IRInst * target)
+{
+    // 只有一个前驱时直接改写后继块的bc
+    if (block->preds.size() == 1) {
+        block->insts.back() = new BrIRInst(target);
+        return;
+    }
+
+    // 线性IR不是SSA形式，副本中的变量不需要改名。只在块内使用的临时变量改名，使其仍只在一个块内定值
+    std::unordered_map<Value *, Value *> valueMap;
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    IRBlock * copy = cfg->createBlock(pred);
+    for (size_t i = 0; i + 1 < block->insts.size(); ++i) {
+        IRInst * inst = block->insts[i];
+        Value * def = getInstDef(inst);
+        auto pIter = localTemps.find(def);
+        if (pIter != localTemps.end() && pIter->second == block && !valueMap.count(def)) {
+            valueMap[def] = cloneTempValue(func, def);
+        }
+        copy->insts.push_back(cloneInst(inst, valueMap, labelMap));
+    }
+    copy->insts.push_back(new BrIRInst(target));
+    replaceBranchTarget(pred->getTerminator(), block->label, copy->label);
+    growthBudget -= (int) block->insts.size() - 1;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file JumpThreading.h
+ * @brief 跳转线程化：前驱沿边已知的条件事实能确定后继块中bc的走向时，复制该后继块，
+ * 让前驱直接跳到已知的出口，删除路径上多余的条件跳转
+ *
+ * 边上的事实来自前驱及其唯一前驱链上的条件跳转，以及块尾对变量的字面量赋值。
+ * 同一对操作数的比较按大小关系推出，变量与常量的比较按变量的取值区间推出。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FunctionCFG.h"
+
+/// @brief 比较的操作数，变量或者整型常量
+struct CompareOperand {
+    /// @brief 变量，常量时为nullptr
+    Value * var = nullptr;
+
+    /// @brief 常量值
+    int32_t value = 0;
+
+    bool operator==(const CompareOperand & other) const
+    {
+        return var == other.var && (var != nullptr || value == other.value);
+    }
+};
+
+/// @brief 沿边成立的比较：lhs op rhs为真
+struct CompareFact {
+    /// @brief 比较运算符
+    IRInstOperator op;
+
+    /// @brief 左操作数
+    CompareOperand lhs;
+
+    /// @brief 右操作数
+    CompareOperand rhs;
+};
+
+/// @brief 基于边上条件事实的跳转线程化
+class JumpThreading {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _maxBlockSize 可以复制的基本块的最大指令数
+    /// @param _maxGrowth 函数内复制的指令总数的上限
+    JumpThreading(Function * _func, int _maxBlockSize = 8, int _maxGrowth = 256);
+
+    /// @brief 线程化函数内的跳转
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 收集前驱到后继的边上成立的事实
+    /// @param pred 前驱块
+    /// @param block 后继块
+    void collectEdgeFacts(IRBlock * pred, IRBlock * block);
+
+    /// @brief 把块尾bc在一个出口上的条件加入事实
+    /// @param block 以bc结尾的基本块
+    /// @param taken true：条件为真的出口
+    /// @param killed 出口之后被重新定值的变量
+    void addBranchFact(IRBlock * block, bool taken, std::unordered_set<Value *> & killed);
+
+    /// @brief 按边上的事实执行后继块，求bc条件的值
+    /// @param block 后继块
+    /// @return 1：条件为真，0：条件为假，-1：不确定
+    int evaluateBranch(IRBlock * block);
+
+    /// @brief 按事实与已知常量求比较的值
+    /// @return 1：为真，0：为假，-1：不确定
+    int evaluateCompare(IRInstOperator op, CompareOperand lhs, CompareOperand rhs);
+
+    /// @brief 操作数替换为已知的常量
+    CompareOperand resolve(CompareOperand operand);
+
+    /// @brief 复制后继块，前驱改为跳转到副本，副本直接跳转到已知的出口
+    /// @param pred 前驱块
+    /// @param block 后继块
+    /// @param target 已知的出口
+    void thread(IRBlock * pred, IRBlock * block, IRInst * target);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 可以复制的基本块的最大指令数
+    int maxBlockSize;
+
+    /// @brief 还可以复制的指令数
+    int growthBudget;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg = nullptr;
+
+    /// @brief 当前边上成立的比较
+    std::vector<CompareFact> facts;
+
+    /// @brief 当前位置值已知的变量
+    std::unordered_map<Value *, int32_t> constants;
+
+    /// @brief 后继块中已经被重新定值的变量，涉及它们的事实不再成立
+    std::unordered_set<Value *> blockKills;
+
+    /// @brief 只在一个基本块内定值与使用的临时变量，复制时改名
+    std::unordered_map<Value *, IRBlock *> localTemps;
+};
@@ -0,0 +1,180 @@
+/**
+ * @file SimplifyCFG.cpp
+ * @brief 控制流图化简：常量条件与两个出口相同的bc改为br，跳过只有br的转发块，
+ * 删除不可达块，合并只有唯一前驱与唯一后继的直线块对，反复进行直到不再变化后回写到函数的指令序列
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "SimplifyCFG.h"
+
+/// @brief 构造函数
+/// @param _func 函数
+SimplifyCFG::SimplifyCFG(Function * _func) : func(_func)
+{}
+
+/// @brief 化简函数的控制流图
+/// @return true：函数的IR被修改
+bool SimplifyCFG::run()
+{
+    FunctionCFG graph(func);
+    cfg = &graph;
+
+    bool changed = false;
+    for (bool progress = true; progress;) {
+        progress = foldBranches();
+        progress |= threadForwarders();
+
+        // 跳转改写之后不再有前驱的转发块与分支一并删除
+        graph.buildEdges();
+        progress |= graph.removeUnreachableBlocks();
+        progress |= mergeBlocks();
+        changed |= progress;
+    }
+
+    if (changed) {
+        // 折叠掉的bc条件的计算不再被使用
+        removeDeadTempDefs(&graph);
+        graph.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 条件是常量或者两个出口相同的bc改为br
+/// @return true：有跳转被改写
+bool SimplifyCFG::foldBranches()
+{
+    bool changed = false;
+    std::vector<IRInst *> targets;
+    for (auto block: cfg->getBlocks()) {
+        IRInst * term = block->getTerminator();
+        if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BC) {
+            continue;
+        }
+        Value * cond = static_cast<BcIRInst *>(term)->temp;
+        if (cond == nullptr) {
+            continue;
+        }
+
+        targets.clear();
+        getBranchTargets(term, targets);
+        int32_t value;
+        if (targets[0] == targets[1]) {
+            block->insts.back() = new BrIRInst(targets[0]);
+        } else if (getConstantCond(block, cond, value)) {
+            block->insts.back() = new BrIRInst(value != 0 ? targets[0] : targets[1]);
+        } else {
+            continue;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+/// @brief 跳转到只有br的转发块时，直接跳转到转发链的最终目标
+/// @return true：有跳转被改写
+bool SimplifyCFG::threadForwarders()
+{
+    bool changed = false;
+    std::vector<IRInst *> targets;
+    for (auto block: cfg->getBlocks()) {
+        IRInst * term = block->getTerminator();
+        if (term == nullptr) {
+            continue;
+        }
+        targets.clear();
+        getBranchTargets(term, targets);
+        for (auto target: targets) {
+            IRInst * final = getFinalTarget(target);
+            if (final != target) {
+                replaceBranchTarget(term, target, final);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/// @brief 块尾无条件跳转到唯一前驱是自己的块时，把后继块合并进来
+/// @return true：有基本块被合并
+bool SimplifyCFG::mergeBlocks()
+{
+    bool changed = false;
+    std::vector<IRBlock *> & blocks = cfg->getBlocks();
+    for (size_t i = 0; i < blocks.size();) {
+        IRBlock * block = blocks[i];
+        IRInst * term = block->getTerminator();
+        IRBlock * succ = nullptr;
+        if (term != nullptr && term->getOp() == IRInstOperator::IRINST_OP_BR) {
+            succ = cfg->getBlockByLabel(term->getTrueInst());
+        }
+        if (succ == nullptr || succ == block || succ == cfg->getEntry() || succ->preds.size() != 1) {
+            ++i;
+            continue;
+        }
+
+        // 去掉块尾的br，后继块的指令接在后面，后继块的后继成为本块的后继
+        block->insts.pop_back();
+        block->insts.insert(block->insts.end(), succ->insts.begin(), succ->insts.end());
+        block->succs = succ->succs;
+        for (auto next: succ->succs) {
+            std::replace(next->preds.begin(), next->preds.end(), succ, block);
+        }
+        succ->insts.clear();
+        succ->succs.clear();
+        succ->preds.clear();
+        cfg->removeBlock(succ);
+        changed = true;
+
+        // 合并后的块继续尝试与新的后继合并，删除的块可能在本块之前
+        i = std::find(blocks.begin(), blocks.end(), block) - blocks.begin();
+    }
+    return changed;
+}
+
+/// @brief 获取块尾条件在bc处的常量值
+/// @param block 基本块
+/// @param cond bc的条件
+/// @param value 常量值
+/// @return true：条件是整型常量
+bool SimplifyCFG::getConstantCond(IRBlock * block, Value * cond, int32_t & value)
+{
+    if (isIntLiteral(cond)) {
+        value = cond->intVal;
+        return true;
+    }
+    if (!cond->isTemp()) {
+        return false;
+    }
+
+    // 块内在bc之前最后一次对条件的定值是字面量的复制
+    for (size_t i = block->insts.size() - 1; i-- > 0;) {
+        IRInst * inst = block->insts[i];
+        if (getInstDef(inst) != cond) {
+            continue;
+        }
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0 &&
+            inst->Assign_flag != 6 && isIntLiteral(inst->getSrc1())) {
+            value = inst->getSrc1()->intVal;
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+/// @brief 沿只有br的转发块找到最终的跳转目标
+/// @param label 跳转目标
+/// @return 最终目标的Label
+IRInst * SimplifyCFG::getFinalTarget(IRInst * label)
+{
+    // 转发块构成的环在回到已经经过的块时停止
+    std::unordered_set<IRBlock *> visited;
+    IRBlock * block = cfg->getBlockByLabel(label);
+    while (block != nullptr && block != cfg->getEntry() && block->insts.size() == 1 &&
+           block->insts[0]->getOp() == IRInstOperator::IRINST_OP_BR && visited.insert(block).second) {
+        label = block->insts[0]->getTrueInst();
+        block = cfg->getBlockByLabel(label);
+    }
+    return label;
+}
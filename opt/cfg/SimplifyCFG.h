@@ -0,0 +1,55 @@
+/**
+ * @file SimplifyCFG.h
+ * @brief 控制流图化简：常量条件与两个出口相同的bc改为br，跳过只有br的转发块，
+ * 删除不可达块，合并只有唯一前驱与唯一后继的直线块对，反复进行直到不再变化后回写到函数的指令序列
+ *
+ * 原有的deleteNullBlock与deleteDeadBlock只在BasicBlocks的副本上做标记，这里直接改写函数的线性IR。
+ * 合并后的块内不再有Label，块内临时变量在后端可以按块内变量分配寄存器。
+ */
+#pragma once
+
+#include "FunctionCFG.h"
+
+/// @brief 迭代的控制流图化简
+class SimplifyCFG {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    SimplifyCFG(Function * _func);
+
+    /// @brief 化简函数的控制流图
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 条件是常量或者两个出口相同的bc改为br
+    /// @return true：有跳转被改写
+    bool foldBranches();
+
+    /// @brief 跳转到只有br的转发块时，直接跳转到转发链的最终目标
+    /// @return true：有跳转被改写
+    bool threadForwarders();
+
+    /// @brief 块尾无条件跳转到唯一前驱是自己的块时，把后继块合并进来
+    /// @return true：有基本块被合并
+    bool mergeBlocks();
+
+    /// @brief 获取块尾条件在bc处的常量值
+    /// @param block 基本块
+    /// @param cond bc的条件
+    /// @param value 常量值
+    /// @return true：条件是整型常量
+    bool getConstantCond(IRBlock * block, Value * cond, int32_t & value);
+
+    /// @brief 沿只有br的转发块找到最终的跳转目标
+    /// @param label 跳转目标
+    /// @return 最终目标的Label
+    IRInst * getFinalTarget(IRInst * label);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg = nullptr;
+};
@@ -0,0 +1,341 @@
+/**
+ * @file CallGraph.cpp
+ * @brief 全程序调用图与函数的副作用摘要：记录调用关系与强连通分量，自底向上汇总每个函数读写的全局变量与数组形参
+ */
+#include <algorithm>
+
+#include "CallGraph.h"
+
+/// @brief 是否是可能被修改的全局标量变量
+static bool isMutableGlobal(SymbolTable & symtab, Value * val)
+{
+    return val != nullptr && !val->isConst() && !val->isliteral() && !val->is_numpy && symtab.findSymbolValue(val);
+}
+
+/// @brief 把对一个位置的读写记入摘要
+/// @param func 访存所在的函数
+/// @param loc 访存位置
+/// @param write true：写，false：读
+/// @return true：摘要有变化
+static bool addMemoryEffect(FunctionSummary & summary, Function * func, const MemoryLocation & loc, bool write)
+{
+    if (loc.base == nullptr) {
+        bool & unknown = write ? summary.writesUnknown : summary.readsUnknown;
+        bool changed = !unknown;
+        unknown = true;
+        return changed;
+    }
+    switch (AliasAnalysis::getObjectKind(loc.base)) {
+        case MemoryObjectKind::GLOBAL_ARRAY:
+            return (write ? summary.writtenGlobals : summary.readGlobals).insert(loc.base).second;
+        case MemoryObjectKind::PARAM_ARRAY: {
+            std::vector<FuncFormalParam> & params = func->getParams();
+            for (int i = 0; i < (int) params.size(); ++i) {
+                if (params[i].val == loc.base) {
+                    return (write ? summary.writtenParams : summary.readParams).insert(i).second;
+                }
+            }
+            return addMemoryEffect(summary, func, MemoryLocation(), write);
+        }
+        default:
+            // 局部数组在函数返回后不可见
+            return false;
+    }
+}
+
+/// @brief 构造函数，建立调用图并计算所有用户函数的副作用摘要
+/// @param _symtab 符号表
+CallGraph::CallGraph(SymbolTable & _symtab) : symtab(_symtab)
+{
+    for (auto func: symtab.getFunctionList()) {
+        if (!func->isBuiltin()) {
+            CallGraphNode & node = nodes[func];
+            node.func = func;
+            collectLocalEffects(&node);
+        }
+    }
+    for (auto & item: nodes) {
+        for (auto & site: item.second.calls) {
+            nodes[site.callee].callers.push_back(&site);
+            callSites[site.inst] = &site;
+        }
+    }
+
+    std::unordered_map<CallGraphNode *, int> index, lowLink;
+    std::vector<CallGraphNode *> stack;
+    for (auto func: symtab.getFunctionList()) {
+        CallGraphNode * node = getNode(func);
+        if (node != nullptr && !index.count(node)) {
+            findSCC(node, index, lowLink, stack);
+        }
+    }
+
+    // Tarjan算法按被调函数在前的顺序给出分量，分量内迭代到不动点
+    for (auto & scc: sccs) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto func: scc) {
+                for (auto & site: nodes[func].calls) {
+                    changed |= mergeCallee(site);
+                }
+            }
+        }
+    }
+}
+
+/// @brief 收集函数自身的副作用与调用点
+void CallGraph::collectLocalEffects(CallGraphNode * node)
+{
+    Function * func = node->func;
+    FunctionSummary & summary = node->summary;
+    AliasAnalysis aa(func);
+    std::vector<Value *> uses;
+    for (auto inst: func->getInterCode().getInsts()) {
+        IRInstOperator op = inst->getOp();
+
+        uses.clear();
+        getInstUses(inst, uses);
+        for (auto val: uses) {
+            if (isMutableGlobal(symtab, val)) {
+                summary.readGlobals.insert(val);
+            }
+        }
+        Value * def = getInstDef(inst);
+        if (isMutableGlobal(symtab, def)) {
+            summary.writtenGlobals.insert(def);
+        }
+
+        if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if (flag == 2 || flag == 4) {
+                addMemoryEffect(summary, func, aa.getLocation(inst->getSrc()[0]), false);
+            }
+            if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                addMemoryEffect(summary, func, aa.getLocation(inst->getDst()), true);
+            }
+        } else if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_OR &&
+                   static_cast<BinaryIRInst *>(inst)->mode > 3) {
+            summary.readsUnknown = true;
+        } else if (op == IRInstOperator::IRINST_OP_FUNC_CALL) {
+            FuncCallIRInst * call = static_cast<FuncCallIRInst *>(inst);
+            Function * callee = symtab.findFunction(call->name);
+            if (callee == nullptr) {
+                summary.readsUnknown = summary.writesUnknown = summary.hasIO = true;
+            } else if (callee->isBuiltin()) {
+                // 内置函数都是输入输出，其中getarray写、putarray读实参数组
+                summary.hasIO = true;
+                if (!call->getSrc().empty() && (call->name == "getarray" || call->name == "putarray")) {
+                    MemoryLocation loc = aa.getLocation(call->getSrc().back());
+                    loc.constOffset = false;
+                    addMemoryEffect(summary, func, loc, call->name == "getarray");
+                }
+            } else {
+                CallSite site;
+                site.caller = func;
+                site.callee = callee;
+                site.inst = call;
+                for (auto arg: call->getSrc()) {
+                    MemoryLocation loc;
+                    if (AliasAnalysis::isArrayObject(arg) || arg->is_issavenp()) {
+                        loc = aa.getLocation(arg);
+                        loc.constOffset = false;
+                    }
+                    site.argLocations.push_back(loc);
+                }
+                node->calls.push_back(site);
+            }
+        }
+    }
+}
+
+/// @brief Tarjan算法求强连通分量
+void CallGraph::findSCC(CallGraphNode * node,
+                        std::unordered_map<CallGraphNode *, int> & index,
+                        std::unordered_map<CallGraphNode *, int> & lowLink,
+                        std::vector<CallGraphNode *> & stack)
+{
+    int number = (int) index.size();
+    index[node] = lowLink[node] = number;
+    stack.push_back(node);
+
+    for (auto & site: node->calls) {
+        CallGraphNode * callee = &nodes[site.callee];
+        if (!index.count(callee)) {
+            findSCC(callee, index, lowLink, stack);
+            lowLink[node] = std::min(lowLink[node], lowLink[callee]);
+        } else if (callee->scc < 0) {
+            // 仍在栈上
+            lowLink[node] = std::min(lowLink[node], index[callee]);
+        }
+    }
+
+    if (lowLink[node] == index[node]) {
+        std::vector<Function *> scc;
+        CallGraphNode * member;
+        do {
+            member = stack.back();
+            stack.pop_back();
+            member->scc = (int) sccs.size();
+            scc.push_back(member->func);
+        } while (member != node);
+        sccs.push_back(scc);
+    }
+}
+
+/// @brief 把被调函数的摘要合并到调用点所在函数
+/// @return true：调用函数的摘要有变化
+bool CallGraph::mergeCallee(CallSite & site)
+{
+    FunctionSummary & summary = nodes[site.caller].summary;
+    const FunctionSummary & callee = nodes[site.callee].summary;
+    bool changed = false;
+    for (auto global: callee.readGlobals) {
+        changed |= summary.readGlobals.insert(global).second;
+    }
+    for (auto global: callee.writtenGlobals) {
+        changed |= summary.writtenGlobals.insert(global).second;
+    }
+    for (auto index: callee.readParams) {
+        if (index < (int) site.argLocations.size()) {
+            changed |= addMemoryEffect(summary, site.caller, site.argLocations[index], false);
+        }
+    }
+    for (auto index: callee.writtenParams) {
+        if (index < (int) site.argLocations.size()) {
+            changed |= addMemoryEffect(summary, site.caller, site.argLocations[index], true);
+        }
+    }
+    if (callee.readsUnknown && !summary.readsUnknown) {
+        summary.readsUnknown = changed = true;
+    }
+    if (callee.writesUnknown && !summary.writesUnknown) {
+        summary.writesUnknown = changed = true;
+    }
+    if (callee.hasIO && !summary.hasIO) {
+        summary.hasIO = changed = true;
+    }
+    return changed;
+}
+
+/// @brief 获取函数的结点，内置函数返回nullptr
+CallGraphNode * CallGraph::getNode(Function * func)
+{
+    auto pIter = nodes.find(func);
+    return pIter != nodes.end() ? &pIter->second : nullptr;
+}
+
+/// @brief 函数是否直接或间接递归调用自身
+bool CallGraph::isRecursive(Function * func)
+{
+    CallGraphNode * node = getNode(func);
+    if (node == nullptr) {
+        return false;
+    }
+    if (sccs[node->scc].size() > 1) {
+        return true;
+    }
+    for (auto & site: node->calls) {
+        if (site.callee == func) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 获取函数的副作用摘要
+const FunctionSummary & CallGraph::getSummary(Function * func)
+{
+    return nodes.at(func).summary;
+}
+
+/// @brief 调用的是否是纯函数
+bool CallGraph::isPureCall(IRInst * call)
+{
+    auto pIter = callSites.find(call);
+    return pIter != callSites.end() && getSummary(pIter->second->callee).isPure();
+}
+
+/// @brief 调用是否可能读取全局变量
+bool CallGraph::mayReadGlobal(IRInst * call, Value * global)
+{
+    auto pIter = callSites.find(call);
+    if (pIter == callSites.end()) {
+        // 内置函数不访问全局变量，找不到的函数按任意访问处理
+        Function * callee = symtab.findFunction(static_cast<FuncCallIRInst *>(call)->name);
+        return callee == nullptr || !callee->isBuiltin();
+    }
+    const FunctionSummary & summary = getSummary(pIter->second->callee);
+    return summary.readsUnknown || summary.readGlobals.count(global);
+}
+
+/// @brief 调用是否可能写入全局变量
+bool CallGraph::mayWriteGlobal(IRInst * call, Value * global)
+{
+    auto pIter = callSites.find(call);
+    if (pIter == callSites.end()) {
+        Function * callee = symtab.findFunction(static_cast<FuncCallIRInst *>(call)->name);
+        return callee == nullptr || !callee->isBuiltin();
+    }
+    const FunctionSummary & summary = getSummary(pIter->second->callee);
+    return summary.writesUnknown || summary.writtenGlobals.count(global);
+}
+
+/// @brief 按调用点的实参位置判断被调函数读写的形参是否可能重叠
+bool CallGraph::paramsMayAlias(IRInst * call, const std::set<int> & params, const MemoryLocation & loc)
+{
+    CallSite * site = callSites.at(call);
+    for (auto index: params) {
+        if (index >= (int) site->argLocations.size() ||
+            AliasAnalysis::alias(site->argLocations[index], loc) != AliasResult::NO_ALIAS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 全局数组集合中是否有可能与位置重叠的数组
+bool CallGraph::globalsMayAlias(const std::unordered_set<Value *> & globals, const MemoryLocation & loc)
+{
+    for (auto global: globals) {
+        if (!AliasAnalysis::isArrayObject(global)) {
+            continue;
+        }
+        MemoryLocation globalLoc;
+        globalLoc.base = global;
+        if (AliasAnalysis::alias(globalLoc, loc) != AliasResult::NO_ALIAS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 调用是否可能读取调用函数中的数组位置
+/// @param call 调用指令
+/// @param aa 调用函数的别名分析
+/// @param loc 访存位置
+bool CallGraph::mayRead(IRInst * call, AliasAnalysis & aa, const MemoryLocation & loc)
+{
+    auto pIter = callSites.find(call);
+    if (pIter == callSites.end()) {
+        return aa.mayRead(call, loc);
+    }
+    const FunctionSummary & summary = getSummary(pIter->second->callee);
+    return summary.readsUnknown || globalsMayAlias(summary.readGlobals, loc) ||
+           paramsMayAlias(call, summary.readParams, loc);
+}
+
+/// @brief 调用是否可能写入调用函数中的数组位置
+/// @param call 调用指令
+/// @param aa 调用函数的别名分析
+/// @param loc 访存位置
+bool CallGraph::mayWrite(IRInst * call, AliasAnalysis & aa, const MemoryLocation & loc)
+{
+    auto pIter = callSites.find(call);
+    if (pIter == callSites.end()) {
+        return aa.mayWrite(call, loc);
+    }
+    const FunctionSummary & summary = getSummary(pIter->second->callee);
+    return summary.writesUnknown || globalsMayAlias(summary.writtenGlobals, loc) ||
+           paramsMayAlias(call, summary.writtenParams, loc);
+}
@@ -0,0 +1,159 @@
+/**
+ * @file CallGraph.h
+ * @brief 全程序调用图与函数的副作用摘要：记录调用关系与强连通分量，自底向上汇总每个函数读写的全局变量与数组形参
+ */
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AliasAnalysis.h"
+#include "SymbolTable.h"
+
+/// @brief 函数的副作用摘要，包含其直接与间接调用的函数的副作用
+struct FunctionSummary {
+    /// @brief 读取的全局变量，全局数组按数组变量记录
+    std::unordered_set<Value *> readGlobals;
+
+    /// @brief 写入的全局变量，全局数组按数组变量记录
+    std::unordered_set<Value *> writtenGlobals;
+
+    /// @brief 读取的数组形参下标
+    std::set<int> readParams;
+
+    /// @brief 写入的数组形参下标
+    std::set<int> writtenParams;
+
+    /// @brief 通过无法识别基对象的地址读内存
+    bool readsUnknown = false;
+
+    /// @brief 通过无法识别基对象的地址写内存
+    bool writesUnknown = false;
+
+    /// @brief 调用了输入输出的内置函数
+    bool hasIO = false;
+
+    /// @brief 是否是纯函数：结果只取决于标量实参，且没有副作用
+    bool isPure() const
+    {
+        return readGlobals.empty() && readParams.empty() && !readsUnknown && !hasSideEffects();
+    }
+
+    /// @brief 是否有副作用：写全局变量、写数组实参或有输入输出
+    bool hasSideEffects() const
+    {
+        return !writtenGlobals.empty() || !writtenParams.empty() || writesUnknown || hasIO;
+    }
+};
+
+/// @brief 调用点
+struct CallSite {
+    /// @brief 调用函数
+    Function * caller = nullptr;
+
+    /// @brief 被调函数
+    Function * callee = nullptr;
+
+    /// @brief 调用指令
+    FuncCallIRInst * inst = nullptr;
+
+    /// @brief 各实参数组在调用函数中指向的位置，偏移按非常量处理
+    std::vector<MemoryLocation> argLocations;
+};
+
+/// @brief 调用图的结点
+struct CallGraphNode {
+    /// @brief 函数
+    Function * func = nullptr;
+
+    /// @brief 函数内调用用户函数的调用点
+    std::vector<CallSite> calls;
+
+    /// @brief 调用本函数的调用点
+    std::vector<CallSite *> callers;
+
+    /// @brief 所在强连通分量的编号
+    int scc = -1;
+
+    /// @brief 副作用摘要
+    FunctionSummary summary;
+};
+
+/// @brief 全程序调用图
+class CallGraph {
+
+public:
+    /// @brief 构造函数，建立调用图并计算所有用户函数的副作用摘要
+    /// @param _symtab 符号表
+    CallGraph(SymbolTable & _symtab);
+
+    /// @brief 获取函数的结点，内置函数返回nullptr
+    CallGraphNode * getNode(Function * func);
+
+    /// @brief 自底向上排列的强连通分量，被调函数所在的分量在前
+    std::vector<std::vector<Function *>> & getSCCs()
+    {
+        return sccs;
+    }
+
+    /// @brief 函数是否直接或间接递归调用自身
+    bool isRecursive(Function * func);
+
+    /// @brief 获取函数的副作用摘要
+    const FunctionSummary & getSummary(Function * func);
+
+    /// @brief 调用的是否是纯函数
+    bool isPureCall(IRInst * call);
+
+    /// @brief 调用是否可能读取全局变量
+    bool mayReadGlobal(IRInst * call, Value * global);
+
+    /// @brief 调用是否可能写入全局变量
+    bool mayWriteGlobal(IRInst * call, Value * global);
+
+    /// @brief 调用是否可能读取调用函数中的数组位置
+    /// @param call 调用指令
+    /// @param aa 调用函数的别名分析
+    /// @param loc 访存位置
+    bool mayRead(IRInst * call, AliasAnalysis & aa, const MemoryLocation & loc);
+
+    /// @brief 调用是否可能写入调用函数中的数组位置
+    /// @param call 调用指令
+    /// @param aa 调用函数的别名分析
+    /// @param loc 访存位置
+    bool mayWrite(IRInst * call, AliasAnalysis & aa, const MemoryLocation & loc);
+
+private:
+    /// @brief 收集函数自身的副作用与调用点
+    void collectLocalEffects(CallGraphNode * node);
+
+    /// @brief Tarjan算法求强连通分量
+    void findSCC(CallGraphNode * node,
+                 std::unordered_map<CallGraphNode *, int> & index,
+                 std::unordered_map<CallGraphNode *, int> & lowLink,
+                 std::vector<CallGraphNode *> & stack);
+
+    /// @brief 把被调函数的摘要合并到调用点所在函数
+    /// @return true：调用函数的摘要有变化
+    bool mergeCallee(CallSite & site);
+
+    /// @brief 按调用点的实参位置判断被调函数读写的形参是否可能重叠
+    bool paramsMayAlias(IRInst * call, const std::set<int> & params, const MemoryLocation & loc);
+
+    /// @brief 全局数组集合中是否有可能与位置重叠的数组
+    bool globalsMayAlias(const std::unordered_set<Value *> & globals, const MemoryLocation & loc);
+
+    /// @brief 符号表
+    SymbolTable & symtab;
+
+    /// @brief 用户函数的结点
+    std::unordered_map<Function *, CallGraphNode> nodes;
+
+    /// @brief 调用指令到调用点
+    std::unordered_map<IRInst *, CallSite *> callSites;
+
+    /// @brief 强连通分量
+    std::vector<std::vector<Function *>> sccs;
+};
@@ -0,0 +1,147 @@
+/**
+ * @file DeadGlobalElimination.cpp
+ * @brief 无用函数与无用全局变量删除：从main出发不可达的函数、可达函数中不再读取的全局变量与常量不再输出
+ */
+#include <algorithm>
+
+#include "CallGraph.h"
+#include "DeadGlobalElimination.h"
+#include "FunctionCFG.h"
+
+/// @brief 构造函数
+/// @param _symtab 符号表
+DeadGlobalElimination::DeadGlobalElimination(SymbolTable & _symtab) : symtab(_symtab)
+{}
+
+/// @brief 删除不可达的函数以及不再使用的全局变量
+/// @return true：有函数或全局变量被删除
+bool DeadGlobalElimination::run()
+{
+    // 先删函数，只被无用函数引用的全局变量随之变为无用
+    bool changed = removeDeadFunctions();
+    changed |= removeDeadGlobals();
+    return changed;
+}
+
+/// @brief 删除从main出发经调用图不可达的用户函数
+/// @return true：有函数被删除
+bool DeadGlobalElimination::removeDeadFunctions()
+{
+    Function * mainFunc = symtab.mainFunc != nullptr ? symtab.mainFunc : symtab.findFunction("main");
+    if (mainFunc == nullptr) {
+        return false;
+    }
+
+    CallGraph callGraph(symtab);
+    std::unordered_set<Function *> reachable{mainFunc};
+    std::vector<Function *> worklist{mainFunc};
+
+    // 被外部代码调用的函数，如运行时库回调的函数，同样作为起点
+    for (auto func: symtab.getFunctionList()) {
+        if (!func->isBuiltin() && func->isExternallyUsed() && reachable.insert(func).second) {
+            worklist.push_back(func);
+        }
+    }
+    while (!worklist.empty()) {
+        CallGraphNode * node = callGraph.getNode(worklist.back());
+        worklist.pop_back();
+        for (auto & site: node->calls) {
+            if (reachable.insert(site.callee).second) {
+                worklist.push_back(site.callee);
+            }
+        }
+    }
+
+    std::vector<Function *> dead;
+    for (auto func: symtab.getFunctionList()) {
+        if (!func->isBuiltin() && !reachable.count(func)) {
+            dead.push_back(func);
+        }
+    }
+    for (auto func: dead) {
+        symtab.removeFunction(func);
+    }
+    return !dead.empty();
+}
+
+/// @brief 删除没有被读取的全局变量，只被写入的全局标量连同其赋值指令一起删除
+/// @return true：有全局变量被删除
+bool DeadGlobalElimination::removeDeadGlobals()
+{
+    // 可达函数中被读取的全局变量，以及不能删除的写入（函数调用的返回值）
+    std::unordered_set<Value *> used;
+    std::vector<Value *> uses;
+    for (auto func: symtab.getFunctionList()) {
+        if (func->isBuiltin()) {
+            continue;
+        }
+        for (auto inst: func->getInterCode().getInsts()) {
+            uses.clear();
+            getInstUses(inst, uses);
+            used.insert(uses.begin(), uses.end());
+            Value * def = getInstDef(inst);
+            if (def != nullptr && inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                used.insert(def);
+            }
+        }
+    }
+
+    std::unordered_set<Value *> dead;
+    for (auto val: symtab.getValueVector()) {
+        // 全局数组的元素访问都要先读取数组地址，因此被写入的数组同样在used中
+        if (val->isliteral() || val->isTemp() || val->is_externallyUsed || used.count(val)) {
+            continue;
+        }
+        dead.insert(val);
+    }
+    if (dead.empty()) {
+        return false;
+    }
+
+    // 全局数组的初始值保存在与数组共用np的临时变量中，随数组一起删除
+    std::vector<Value *> removed;
+    for (auto val: symtab.getValueVector()) {
+        if (dead.count(val)) {
+            removed.push_back(val);
+        } else if (val->isTemp() && val->is_issavenp() && val->np != nullptr) {
+            for (auto array: dead) {
+                if (array->is_numpy && array->np == val->np) {
+                    removed.push_back(val);
+                    break;
+                }
+            }
+        }
+    }
+    dead.insert(removed.begin(), removed.end());
+
+    for (auto func: symtab.getFunctionList()) {
+        if (!func->isBuiltin()) {
+            eraseInsts(func->getInterCode().getInsts(), dead);
+        }
+    }
+    eraseInsts(symtab.code.getInsts(), dead);
+
+    for (auto val: removed) {
+        symtab.removeValue(val);
+    }
+    return true;
+}
+
+/// @brief 从指令序列中删除引用了已删除全局变量的指令
+void DeadGlobalElimination::eraseInsts(std::vector<IRInst *> & insts, const std::unordered_set<Value *> & dead)
+{
+    std::vector<Value *> uses;
+    insts.erase(std::remove_if(insts.begin(),
+                               insts.end(),
+                               [&](IRInst * inst) {
+                                   if (dead.count(getInstDef(inst))) {
+                                       return true;
+                                   }
+                                   uses.clear();
+                                   getInstUses(inst, uses);
+                                   return std::any_of(uses.begin(), uses.end(), [&](Value * val) {
+                                       return dead.count(val) > 0;
+                                   });
+                               }),
+                insts.end());
+}
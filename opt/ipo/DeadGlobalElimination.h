@@ -0,0 +1,38 @@
+/**
+ * @file DeadGlobalElimination.h
+ * @brief 无用函数与无用全局变量删除：从main出发不可达的函数、可达函数中不再读取的全局变量与常量不再输出
+ */
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+
+#include "SymbolTable.h"
+
+/// @brief 无用函数与无用全局变量删除
+class DeadGlobalElimination {
+
+public:
+    /// @brief 构造函数
+    /// @param _symtab 符号表
+    DeadGlobalElimination(SymbolTable & _symtab);
+
+    /// @brief 删除不可达的函数以及不再使用的全局变量
+    /// @return true：有函数或全局变量被删除
+    bool run();
+
+private:
+    /// @brief 删除从main出发经调用图不可达的用户函数
+    /// @return true：有函数被删除
+    bool removeDeadFunctions();
+
+    /// @brief 删除没有被读取的全局变量，只被写入的全局标量连同其赋值指令一起删除
+    /// @return true：有全局变量被删除
+    bool removeDeadGlobals();
+
+    /// @brief 从指令序列中删除引用了已删除全局变量的指令
+    void eraseInsts(std::vector<IRInst *> & insts, const std::unordered_set<Value *> & dead);
+
+    /// @brief 符号表
+    SymbolTable & symtab;
+};
@@ -0,0 +1,337 @@
+/**
+ * @file IPConstantPropagation.cpp
+ * @brief 过程间常量传播与函数特化：所有调用点实参相同的形参替换为常量，热调用点的常量实参组合生成特化的函数体
+ *
+ * 特化不新建函数，而是在函数入口比较形参与常量，相等时进入形参已替换为常量的函数体副本，
+ * 调用点与函数的签名都保持不变，递归调用同样进入特化版本。
+ */
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+#include "IPConstantPropagation.h"
+#include "LoopInfo.h"
+
+/// @brief 构造函数
+/// @param _symtab 符号表
+/// @param _maxSpecializeInsts 允许特化的函数的最大指令数
+IPConstantPropagation::IPConstantPropagation(SymbolTable & _symtab, int _maxSpecializeInsts)
+    : symtab(_symtab), maxSpecializeInsts(_maxSpecializeInsts)
+{}
+
+/// @brief 自顶向下传播常量实参，再对剩余的热常量实参进行特化
+/// @return true：有函数被修改
+bool IPConstantPropagation::run()
+{
+    CallGraph callGraph(symtab);
+    std::vector<std::vector<Function *>> & sccs = callGraph.getSCCs();
+
+    // 调用函数在前，调用函数的形参先被替换为常量后，其调用点的实参才能成为常量
+    bool changed = false;
+    for (auto pIter = sccs.rbegin(); pIter != sccs.rend(); ++pIter) {
+        for (auto func: *pIter) {
+            changed |= propagate(callGraph.getNode(func));
+        }
+    }
+
+    // 循环内与递归的调用点才值得特化，在修改函数之前记录
+    for (auto & scc: sccs) {
+        for (auto func: scc) {
+            FunctionCFG cfg(func);
+            cfg.computeDominators();
+            LoopInfo loopInfo(&cfg);
+            for (auto block: cfg.getBlocks()) {
+                if (loopInfo.getLoopFor(block) == nullptr) {
+                    continue;
+                }
+                for (auto inst: block->insts) {
+                    if (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                        hotCalls.insert(inst);
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto pIter = sccs.rbegin(); pIter != sccs.rend(); ++pIter) {
+        for (auto func: *pIter) {
+            CallGraphNode * node = callGraph.getNode(func);
+            ConstArgs args;
+            for (auto site: node->callers) {
+                if (node->scc == callGraph.getNode(site->caller)->scc) {
+                    hotCalls.insert(site->inst);
+                }
+            }
+            if (selectSpecialization(node, args)) {
+                specialize(func, args);
+                // 特化复制了形参的定值，函数作为调用函数时的别名分析需重新计算
+                analyses.erase(func);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/// @brief 所有调用点的实参都是同一个常量的形参替换为该常量
+/// @return true：函数被修改
+bool IPConstantPropagation::propagate(CallGraphNode * node)
+{
+    Function * func = node->func;
+    if (func == symtab.mainFunc || func->getName() == "main" || node->callers.empty()) {
+        return false;
+    }
+
+    bool changed = false;
+    std::vector<FuncFormalParam> & params = func->getParams();
+    for (int i = 0; i < (int) params.size(); ++i) {
+        IRInst * copy = getParamCopy(func, i);
+        if (copy == nullptr) {
+            continue;
+        }
+
+        // 递归调用原样传递形参时与其它调用点一致
+        bool agree = true, found = false;
+        int32_t constant = 0;
+        for (auto site: node->callers) {
+            int32_t value;
+            if (site->caller == func && site->inst->getSrc()[i] == params[i].val) {
+                continue;
+            }
+            if (!getConstantArg(site, i, value) || (found && value != constant)) {
+                agree = false;
+                break;
+            }
+            found = true;
+            constant = value;
+        }
+        if (!agree || !found) {
+            continue;
+        }
+
+        Value * literal = symtab.newConstValue(constant);
+        replaceInstUse(copy, params[i].save_val, literal);
+        for (auto inst: func->getInterCode().getInsts()) {
+            if (inst != copy) {
+                replaceInstUse(inst, params[i].val, literal);
+            }
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+/// @brief 选出热调用点上出现最多的常量实参组合
+/// @param node 被调函数
+/// @param args 选出的形参下标与常量
+/// @return true：存在值得特化的组合
+bool IPConstantPropagation::selectSpecialization(CallGraphNode * node, ConstArgs & args)
+{
+    Function * func = node->func;
+    if (func == symtab.mainFunc || func->getName() == "main" || func->getExitLabel() == nullptr ||
+        (int) func->getInterCode().getInsts().size() > maxSpecializeInsts) {
+        return false;
+    }
+
+    std::vector<FuncFormalParam> & params = func->getParams();
+    std::vector<int> candidates;
+    for (int i = 0; i < (int) params.size(); ++i) {
+        if (getParamCopy(func, i) != nullptr && isProfitableParam(func, params[i].val)) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) {
+        return false;
+    }
+
+    std::map<ConstArgs, int> counts;
+    for (auto site: node->callers) {
+        if (!hotCalls.count(site->inst)) {
+            continue;
+        }
+        ConstArgs combination;
+        for (auto i: candidates) {
+            int32_t value;
+            if (getConstantArg(site, i, value)) {
+                combination.emplace_back(i, value);
+            }
+        }
+        if (!combination.empty()) {
+            counts[combination]++;
+        }
+    }
+
+    int best = 0;
+    for (auto & item: counts) {
+        if (item.second > best) {
+            best = item.second;
+            args = item.first;
+        }
+    }
+    return best > 0;
+}
+
+/// @brief 生成以args为条件的特化函数体
+/// @details 入口块只保留entry指令与比较形参的判断，其余指令移到通用版本的块中；
+/// 除出口块外的所有块复制一份作为特化版本，其中形参的使用替换为常量
+void IPConstantPropagation::specialize(Function * func, const ConstArgs & args)
+{
+    std::vector<FuncFormalParam> & params = func->getParams();
+    std::vector<IRInst *> copies;
+    for (auto & arg: args) {
+        copies.push_back(getParamCopy(func, arg.first));
+    }
+
+    FunctionCFG cfg(func);
+    IRBlock * entry = cfg.getEntry();
+    IRBlock * exit = cfg.getBlockByLabel(func->getExitLabel());
+
+    IRBlock * generic = cfg.createBlock(entry);
+    auto pIter = entry->insts.begin();
+    if (pIter != entry->insts.end() && (*pIter)->getOp() == IRInstOperator::IRINST_OP_ENTRY) {
+        ++pIter;
+    }
+    generic->insts.assign(pIter, entry->insts.end());
+    entry->insts.erase(pIter, entry->insts.end());
+
+    // 入口块与出口块中出现的临时变量两个版本共用，其余临时变量在副本中重命名
+    std::unordered_set<Value *> shared;
+    std::vector<Value *> uses;
+    for (auto block: {entry, exit}) {
+        for (auto inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            shared.insert(uses.begin(), uses.end());
+            shared.insert(getInstDef(inst));
+        }
+    }
+
+    std::vector<IRBlock *> body;
+    std::unordered_map<Value *, Value *> valueMap;
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    for (auto block: cfg.getBlocks()) {
+        if (block == entry || block == exit || block->label == nullptr) {
+            continue;
+        }
+        body.push_back(block);
+        labelMap[block->label] = new LabelIRInst();
+        for (auto inst: block->insts) {
+            Value * def = getInstDef(inst);
+            if (def != nullptr && def->isTemp() && !def->is_FParam() && !shared.count(def) && !valueMap.count(def)) {
+                valueMap[def] = cloneTempValue(func, def);
+            }
+        }
+    }
+
+    // 副本放在出口块之前
+    auto exitIter = std::find(cfg.getBlocks().begin(), cfg.getBlocks().end(), exit);
+    IRBlock * after = exitIter != cfg.getBlocks().begin() ? *(exitIter - 1) : cfg.getBlocks().back();
+    for (auto block: body) {
+        IRBlock * copy = cfg.createBlock(after, labelMap[block->label]);
+        for (auto inst: block->insts) {
+            IRInst * clone = cloneInst(inst, valueMap, labelMap);
+            for (size_t k = 0; k < args.size(); ++k) {
+                Value * literal = symtab.newConstValue(args[k].second);
+                replaceInstUse(clone, inst == copies[k] ? params[args[k].first].save_val : params[args[k].first].val, literal);
+            }
+            copy->insts.push_back(clone);
+        }
+        after = copy;
+    }
+
+    // 依次比较各个形参，全部相等时进入特化版本
+    IRBlock * check = entry;
+    for (size_t k = 0; k < args.size(); ++k) {
+        Value * cond = func->newTempValue(BasicType::TYPE_BOOL);
+        check->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_EQ,
+                                                cond,
+                                                params[args[k].first].save_val,
+                                                symtab.newConstValue(args[k].second)));
+        IRBlock * next = k + 1 < args.size() ? cfg.createBlockBefore(generic) : nullptr;
+        BcIRInst * bc = new BcIRInst();
+        bc->mode = 3;
+        bc->temp = cond;
+        bc->setTrueInst(next != nullptr ? next->label : labelMap[generic->label]);
+        bc->setFalseInst(generic->label);
+        check->insts.push_back(bc);
+        check = next;
+    }
+
+    cfg.buildEdges();
+    cfg.writeBack();
+}
+
+/// @brief 调用点的实参是否是常量
+/// @param site 调用点
+/// @param index 实参下标
+/// @param value 常量值
+bool IPConstantPropagation::getConstantArg(CallSite * site, int index, int32_t & value)
+{
+    std::vector<Value *> & srcs = site->inst->getSrc();
+    if (index >= (int) srcs.size()) {
+        return false;
+    }
+    return getAliasAnalysis(site->caller).getConstant(srcs[index], value);
+}
+
+/// @brief 形参是否只在入口被赋值一次，返回该赋值指令
+IRInst * IPConstantPropagation::getParamCopy(Function * func, int index)
+{
+    FuncFormalParam & param = func->getParams()[index];
+    if (param.val == nullptr || param.save_val == nullptr || param.val->type.type != BasicType::TYPE_INT ||
+        param.val->is_numpy) {
+        return nullptr;
+    }
+
+    IRInst * copy = nullptr;
+    for (auto inst: func->getInterCode().getInsts()) {
+        if (getInstDef(inst) != param.val) {
+            continue;
+        }
+        if (copy != nullptr || inst->getOp() != IRInstOperator::IRINST_OP_ASSIGN ||
+            static_cast<AssignIRInst *>(inst)->_flag != 0 || inst->getSrc()[0] != param.save_val) {
+            return nullptr;
+        }
+        copy = inst;
+    }
+    return copy;
+}
+
+/// @brief 形参是否在函数内用作除数、比较操作数或乘数，替换为常量后能被进一步优化
+bool IPConstantPropagation::isProfitableParam(Function * func, Value * param)
+{
+    for (auto inst: func->getInterCode().getInsts()) {
+        switch (inst->getOp()) {
+            case IRInstOperator::IRINST_OP_DIV_I:
+            case IRInstOperator::IRINST_OP_MOD_I:
+                if (inst->getSrc2() == param) {
+                    return true;
+                }
+                break;
+            case IRInstOperator::IRINST_OP_MULT_I:
+            case IRInstOperator::IRINST_OP_LT:
+            case IRInstOperator::IRINST_OP_BT:
+            case IRInstOperator::IRINST_OP_LE:
+            case IRInstOperator::IRINST_OP_BE:
+            case IRInstOperator::IRINST_OP_EQ:
+            case IRInstOperator::IRINST_OP_NQ:
+                if (inst->getSrc1() == param || inst->getSrc2() == param) {
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+/// @brief 获取函数的别名分析，用于求实参的常量值
+AliasAnalysis & IPConstantPropagation::getAliasAnalysis(Function * func)
+{
+    auto pIter = analyses.find(func);
+    if (pIter == analyses.end()) {
+        pIter = analyses.emplace(func, AliasAnalysis(func)).first;
+    }
+    return pIter->second;
+}
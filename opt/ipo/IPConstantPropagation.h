@@ -0,0 +1,75 @@
+/**
+ * @file IPConstantPropagation.h
+ * @brief 过程间常量传播与函数特化：所有调用点实参相同的形参替换为常量，热调用点的常量实参组合生成特化的函数体
+ *
+ * 特化不新建函数，而是在函数入口比较形参与常量，相等时进入形参已替换为常量的函数体副本，
+ * 调用点与函数的签名都保持不变，递归调用同样进入特化版本。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "CallGraph.h"
+#include "FunctionCFG.h"
+#include "SymbolTable.h"
+
+/// @brief 过程间常量传播与函数特化
+class IPConstantPropagation {
+
+public:
+    /// @brief 构造函数
+    /// @param _symtab 符号表
+    /// @param _maxSpecializeInsts 允许特化的函数的最大指令数
+    IPConstantPropagation(SymbolTable & _symtab, int _maxSpecializeInsts = 300);
+
+    /// @brief 自顶向下传播常量实参，再对剩余的热常量实参进行特化
+    /// @return true：有函数被修改
+    bool run();
+
+private:
+    /// @brief 形参与特化所用的常量
+    using ConstArgs = std::vector<std::pair<int, int32_t>>;
+
+    /// @brief 所有调用点的实参都是同一个常量的形参替换为该常量
+    /// @return true：函数被修改
+    bool propagate(CallGraphNode * node);
+
+    /// @brief 选出热调用点上出现最多的常量实参组合
+    /// @param node 被调函数
+    /// @param args 选出的形参下标与常量
+    /// @return true：存在值得特化的组合
+    bool selectSpecialization(CallGraphNode * node, ConstArgs & args);
+
+    /// @brief 生成以args为条件的特化函数体
+    void specialize(Function * func, const ConstArgs & args);
+
+    /// @brief 调用点的实参是否是常量
+    /// @param site 调用点
+    /// @param index 实参下标
+    /// @param value 常量值
+    bool getConstantArg(CallSite * site, int index, int32_t & value);
+
+    /// @brief 形参是否只在入口被赋值一次，返回该赋值指令
+    IRInst * getParamCopy(Function * func, int index);
+
+    /// @brief 形参是否在函数内用作除数、比较操作数或乘数，替换为常量后能被进一步优化
+    bool isProfitableParam(Function * func, Value * param);
+
+    /// @brief 获取函数的别名分析，用于求实参的常量值
+    AliasAnalysis & getAliasAnalysis(Function * func);
+
+    /// @brief 符号表
+    SymbolTable & symtab;
+
+    /// @brief 允许特化的函数的最大指令数
+    int maxSpecializeInsts;
+
+    /// @brief 各函数的别名分析
+    std::unordered_map<Function *, AliasAnalysis> analyses;
+
+    /// @brief 循环内或递归的调用指令
+    std::unordered_set<IRInst *> hotCalls;
+};
@@ -0,0 +1,200 @@
+/**
+ * @file Memoization.cpp
+ * @brief 纯递归函数的记忆化：对整型参数的纯函数生成直接映射的结果缓存，重复调用直接返回缓存值
+ */
+#include "Memoization.h"
+#include "LoopInfo.h"
+
+/// @brief 记忆化函数的最大参数个数
+static const int MAX_MEMO_PARAMS = 3;
+
+/// @brief 参数散列的乘数，取奇数使低位充分混合
+static const int32_t MEMO_HASH_MULTIPLIERS[MAX_MEMO_PARAMS] = {1, 40503, 19937};
+
+/// @brief 构造函数
+/// @param _symtab 符号表
+/// @param _cacheSize 每个函数的缓存项数
+Memoization::Memoization(SymbolTable & _symtab, int _cacheSize) : symtab(_symtab), cacheSize(_cacheSize)
+{}
+
+/// @brief 分析纯函数并对重复递归调用的函数进行记忆化
+/// @return true：有函数被修改
+bool Memoization::run()
+{
+    CallGraph callGraph(symtab);
+
+    bool changed = false;
+    for (auto func: symtab.getFunctionList()) {
+        if (isCandidate(func, callGraph)) {
+            memoize(func);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/// @brief 函数是否值得记忆化：纯函数、整型参数与返回值、存在多处自递归调用或循环内的自递归调用
+/// @param func 函数
+/// @param callGraph 调用图
+bool Memoization::isCandidate(Function * func, CallGraph & callGraph)
+{
+    if (func->isBuiltin() || !callGraph.getSummary(func).isPure() || func == symtab.mainFunc || func->getName() == "main" ||
+        func->getReturnType().type != BasicType::TYPE_INT || func->getReturnValue() == nullptr ||
+        func->getExitLabel() == nullptr) {
+        return false;
+    }
+    std::vector<FuncFormalParam> & params = func->getParams();
+    if (params.empty() || (int) params.size() > MAX_MEMO_PARAMS) {
+        return false;
+    }
+    for (auto & param: params) {
+        if (param.val == nullptr || param.save_val == nullptr || param.val->type.type != BasicType::TYPE_INT ||
+            param.val->is_numpy) {
+            return false;
+        }
+    }
+
+    FunctionCFG cfg(func);
+    cfg.computeDominators();
+    LoopInfo loopInfo(&cfg);
+    int selfCalls = 0;
+    for (auto block: cfg.getBlocks()) {
+        for (auto inst: block->insts) {
+            if (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL &&
+                static_cast<FuncCallIRInst *>(inst)->name == func->getName()) {
+                // 循环内的递归调用按多次计
+                selfCalls += loopInfo.getLoopFor(block) != nullptr ? 2 : 1;
+            }
+        }
+    }
+    return selfCalls >= 2;
+}
+
+/// @brief 在函数入口查缓存，在函数出口写缓存
+/// @details 每个缓存项依次是有效标志、各个参数与返回值，按参数散列值直接映射，冲突时新结果覆盖旧结果
+void Memoization::memoize(Function * func)
+{
+    std::vector<FuncFormalParam> & params = func->getParams();
+    int entryWords = (int) params.size() + 2;
+
+    // 缓存放在全局数据区，初始全为0即所有项无效
+    std::string cacheName = "__memo_" + func->getName();
+    Value * cache = symtab.newVarValue(cacheName, BasicType::TYPE_INT);
+    cache->creat_np(cacheSize * entryWords, BasicType::TYPE_INT);
+    cache->np->np_sizes.push_back(cacheSize * entryWords);
+    cache->np->np_name = cacheName;
+
+    FunctionCFG cfg(func);
+    IRBlock * entry = cfg.getEntry();
+    IRBlock * exit = cfg.getBlockByLabel(func->getExitLabel());
+    Value * retVal = func->getReturnValue();
+
+    auto newTemp = [&]() { return func->newTempValue(BasicType::TYPE_INT); };
+    auto newAddress = [&]() {
+        Value * addr = func->newTempValue(BasicType::TYPE_INT);
+        addr->set_is_savenp();
+        return addr;
+    };
+
+    // 入口块只保留entry指令，其余指令移到缓存未命中的块
+    IRBlock * miss = cfg.createBlock(entry);
+    auto pIter = entry->insts.begin();
+    if (pIter != entry->insts.end() && (*pIter)->getOp() == IRInstOperator::IRINST_OP_ENTRY) {
+        ++pIter;
+    }
+    miss->insts.assign(pIter, entry->insts.end());
+    entry->insts.erase(pIter, entry->insts.end());
+
+    // 形参在后端可能驻留在参数寄存器中，递归调用会覆盖它们，出口写缓存前先复制一份
+    std::vector<Value *> keys;
+    for (auto & param: params) {
+        Value * key = newTemp();
+        entry->insts.push_back(new AssignIRInst(key, param.save_val, 0));
+        keys.push_back(key);
+    }
+
+    // 散列值取模得到缓存项下标，余数为负时加上缓存项数
+    Value * hash = nullptr;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Value * term = keys[i];
+        if (MEMO_HASH_MULTIPLIERS[i] != 1) {
+            term = newTemp();
+            entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_MULT_I,
+                                                    term,
+                                                    keys[i],
+                                                    symtab.newConstValue(MEMO_HASH_MULTIPLIERS[i])));
+        }
+        if (hash != nullptr) {
+            Value * sum = newTemp();
+            entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, sum, hash, term));
+            term = sum;
+        }
+        hash = term;
+    }
+    Value * size = symtab.newConstValue(cacheSize);
+    Value * index = newTemp();
+    entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_MOD_I, index, hash, size));
+    Value * shifted = newTemp();
+    entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, shifted, index, size));
+    Value * slot = newTemp();
+    entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_MOD_I, slot, shifted, size));
+    Value * offset = newTemp();
+    entry->insts.push_back(
+        new BinaryIRInst(IRInstOperator::IRINST_OP_MULT_I, offset, slot, symtab.newConstValue(entryWords * 4)));
+
+    // 缓存项各个字的地址，出口写缓存时复用
+    std::vector<Value *> fields;
+    Value * base = newAddress();
+    entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, base, cache, offset));
+    fields.push_back(base);
+    for (int i = 1; i < entryWords; ++i) {
+        Value * addr = newAddress();
+        entry->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, addr, base, symtab.newConstValue(i * 4)));
+        fields.push_back(addr);
+    }
+
+    // 依次比较有效标志与各个参数，全部相等时命中
+    IRBlock * check = entry;
+    for (int i = 0; i + 1 < entryWords; ++i) {
+        Value * word = newTemp();
+        check->insts.push_back(new AssignIRInst(word, fields[i], 2));
+        Value * cond = func->newTempValue(BasicType::TYPE_BOOL);
+        if (i == 0) {
+            check->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_NQ, cond, word, symtab.newConstValue(0)));
+        } else {
+            check->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_EQ, cond, word, keys[i - 1]));
+        }
+        IRBlock * next = cfg.createBlockBefore(miss);
+        BcIRInst * bc = new BcIRInst();
+        bc->mode = 3;
+        bc->temp = cond;
+        bc->setTrueInst(next->label);
+        bc->setFalseInst(miss->label);
+        check->insts.push_back(bc);
+        check = next;
+    }
+
+    // 命中时直接返回缓存值
+    Value * cached = newTemp();
+    check->insts.push_back(new AssignIRInst(cached, fields.back(), 2));
+    check->insts.push_back(new AssignIRInst(retVal, cached, 0));
+    check->insts.push_back(new BrIRInst(exit->label));
+
+    // 未命中的路径到达出口前写缓存
+    IRBlock * store = cfg.createBlockBefore(exit);
+    for (auto block: cfg.getBlocks()) {
+        IRInst * term = block->getTerminator();
+        if (block != check && block != store && term != nullptr) {
+            replaceBranchTarget(term, exit->label, store->label);
+        }
+    }
+    store->insts.push_back(new AssignIRInst(fields[0], symtab.newConstValue(1), 3));
+    for (size_t i = 0; i < keys.size(); ++i) {
+        store->insts.push_back(new AssignIRInst(fields[i + 1], keys[i], 3));
+    }
+    store->insts.push_back(new AssignIRInst(fields.back(), retVal, 3));
+    store->insts.push_back(new BrIRInst(exit->label));
+
+    cfg.buildEdges();
+    cfg.writeBack();
+}
@@ -0,0 +1,38 @@
+/**
+ * @file Memoization.h
+ * @brief 纯递归函数的记忆化：对整型参数的纯函数生成直接映射的结果缓存，重复调用直接返回缓存值
+ */
+#pragma once
+
+#include "CallGraph.h"
+#include "FunctionCFG.h"
+#include "SymbolTable.h"
+
+/// @brief 纯递归函数的记忆化
+class Memoization {
+
+public:
+    /// @brief 构造函数
+    /// @param _symtab 符号表
+    /// @param _cacheSize 每个函数的缓存项数
+    Memoization(SymbolTable & _symtab, int _cacheSize = 4096);
+
+    /// @brief 分析纯函数并对重复递归调用的函数进行记忆化
+    /// @return true：有函数被修改
+    bool run();
+
+private:
+    /// @brief 函数是否值得记忆化：纯函数、整型参数与返回值、存在多处自递归调用或循环内的自递归调用
+    /// @param func 函数
+    /// @param callGraph 调用图
+    bool isCandidate(Function * func, CallGraph & callGraph);
+
+    /// @brief 在函数入口查缓存，在函数出口写缓存
+    void memoize(Function * func);
+
+    /// @brief 符号表
+    SymbolTable & symtab;
+
+    /// @brief 缓存项数
+    int cacheSize;
+};
@@ -0,0 +1,162 @@
+/**
+ * @file LoopElimination.cpp
+ * @brief 循环消除：删除没有副作用且结果不被使用的循环，用标量演化求出的闭式替换只计算标量的循环
+ */
+#include <cstdlib>
+
+#include "LoopElimination.h"
+#include "ScalarEvolution.h"
+#include "ValueRange.h"
+
+/// @brief 构造函数
+/// @param _func 函数
+LoopElimination::LoopElimination(Function * _func) : func(_func)
+{}
+
+/// @brief 对函数内的循环由外向内尝试删除或替换为闭式
+/// @return true：函数的IR被修改
+bool LoopElimination::run()
+{
+    bool changed = false;
+
+    // 每次只消除一个循环，消除后重建控制流图与循环信息
+    for (;;) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool eliminated = false;
+        std::vector<Loop *> & loops = loopInfo.getLoops();
+        for (auto pIter = loops.rbegin(); pIter != loops.rend(); ++pIter) {
+            Loop * loop = *pIter;
+            CountedLoop info;
+            if (visited.count(loop->header->label) || loop->header == cfg.getEntry() ||
+                !matchCountedLoop(loop, info)) {
+                continue;
+            }
+            if (isDeadLoop(loop, info)) {
+                deleteLoop(&cfg, loop, info);
+                eliminated = true;
+                break;
+            }
+            if (replaceWithClosedForm(&cfg, loop, info)) {
+                eliminated = true;
+                break;
+            }
+            visited.insert(loop->header->label);
+        }
+        if (!eliminated) {
+            break;
+        }
+
+        cfg.writeBack();
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 计数循环的比较与步长方向一致，循环变量单调趋向边界，循环必然终止
+static bool isMonotone(CountedLoop & info)
+{
+    switch (info.pred) {
+        case IRInstOperator::IRINST_OP_LT:
+        case IRInstOperator::IRINST_OP_LE:
+            return info.step > 0;
+        case IRInstOperator::IRINST_OP_BT:
+        case IRInstOperator::IRINST_OP_BE:
+            return info.step < 0;
+        default:
+            return false;
+    }
+}
+
+/// @brief 循环是否可以直接删除：没有副作用，必然终止，且循环内的定值在出口处都不活跃
+bool LoopElimination::isDeadLoop(Loop * loop, CountedLoop & info)
+{
+    if (!isMonotone(info)) {
+        return false;
+    }
+
+    // 内层循环也必须必然终止
+    std::vector<Loop *> worklist(loop->subLoops);
+    while (!worklist.empty()) {
+        Loop * subLoop = worklist.back();
+        worklist.pop_back();
+        CountedLoop subInfo;
+        if (!matchCountedLoop(subLoop, subInfo) || !isMonotone(subInfo)) {
+            return false;
+        }
+        worklist.insert(worklist.end(), subLoop->subLoops.begin(), subLoop->subLoops.end());
+    }
+
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            IRInstOperator op = inst->getOp();
+            if (op == IRInstOperator::IRINST_OP_FUNC_CALL || op == IRInstOperator::IRINST_OP_EXIT) {
+                return false;
+            }
+            if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+                int flag = static_cast<AssignIRInst *>(inst)->_flag;
+                if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                    return false;
+                }
+            }
+            Value * def = getInstDef(inst);
+            if (def != nullptr && isLiveIn(info.exit, def)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 删除循环，循环头改为直接跳到出口
+void LoopElimination::deleteLoop(FunctionCFG * cfg, Loop * loop, CountedLoop & info)
+{
+    IRBlock * header = loop->header;
+    header->insts.clear();
+    header->insts.push_back(new BrIRInst(info.exit->label));
+
+    for (auto block: loop->blocks) {
+        if (block != header) {
+            cfg->removeBlock(block);
+        }
+    }
+    cfg->buildEdges();
+}
+
+/// @brief 用出口值的闭式替换循环
+/// @details 循环头保留第一次的条件判断，条件成立时执行计算闭式的块再跳到出口
+/// @return true：控制流图被修改
+bool LoopElimination::replaceWithClosedForm(FunctionCFG * cfg, Loop * loop, CountedLoop & info)
+{
+    ScalarEvolution scev(func, cfg);
+    if (!scev.analyze(loop, info)) {
+        return false;
+    }
+
+    // 进入循环时边界与循环变量的距离加上步长不超过INT_MAX时，迭代次数可以按有符号数计算
+    ValueRange valueRange(func);
+    valueRange.run();
+    IRInst * cmp = info.cmpInst;
+    IntRange ivRange = valueRange.getOperandRange(cmp, cmp->getSrc1() == info.iv ? 0 : 1);
+    IntRange boundRange = valueRange.getOperandRange(cmp, cmp->getSrc1() == info.iv ? 1 : 0);
+    bool upward = info.pred == IRInstOperator::IRINST_OP_LT || info.pred == IRInstOperator::IRINST_OP_LE;
+    int64_t maxDistance = upward ? boundRange.hi - ivRange.lo : ivRange.hi - boundRange.lo;
+
+    IRBlock * header = loop->header;
+    IRBlock * closedForm = cfg->createBlock(header);
+    scev.emitExitValues(closedForm->insts, maxDistance <= INT32_MAX - std::abs(info.step));
+    closedForm->insts.push_back(new BrIRInst(info.exit->label));
+
+    replaceBranchTarget(header->getTerminator(), info.body->label, closedForm->label);
+
+    for (auto block: loop->blocks) {
+        if (block != header) {
+            cfg->removeBlock(block);
+        }
+    }
+    cfg->buildEdges();
+    return true;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file LoopElimination.h
+ * @brief 循环消除：删除没有副作用且结果不被使用的循环，用标量演化求出的闭式替换只计算标量的循环
+ */
+#pragma once
+
+#include <unordered_set>
+
+#include "LoopInfo.h"
+
+/// @brief 循环消除
+class LoopElimination {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    LoopElimination(Function * _func);
+
+    /// @brief 对函数内的循环由外向内尝试删除或替换为闭式
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 循环是否可以直接删除：没有副作用，必然终止，且循环内的定值在出口处都不活跃
+    bool isDeadLoop(Loop * loop, CountedLoop & info);
+
+    /// @brief 删除循环，循环头改为直接跳到出口
+    void deleteLoop(FunctionCFG * cfg, Loop * loop, CountedLoop & info);
+
+    /// @brief 用出口值的闭式替换循环
+    /// @return true：控制流图被修改
+    bool replaceWithClosedForm(FunctionCFG * cfg, Loop * loop, CountedLoop & info);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 无法消除的循环头Label
+    std::unordered_set<IRInst *> visited;
+};
@@ -0,0 +1,416 @@
+/**
+ * @file LoopInfo.cpp
+ * @brief 基于回边识别的自然循环信息
+ */
+#include <algorithm>
+
+#include "LoopInfo.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 获取唯一的循环外前驱且其后继只有循环头，不存在返回nullptr
+IRBlock * Loop::getPreheader()
+{
+    IRBlock * preheader = nullptr;
+    for (auto pred: header->preds) {
+        if (contains(pred)) {
+            continue;
+        }
+        if (preheader != nullptr) {
+            // 多个循环外前驱
+            return nullptr;
+        }
+        preheader = pred;
+    }
+    if (preheader == nullptr || preheader->succs.size() != 1) {
+        return nullptr;
+    }
+    return preheader;
+}
+
+/// @brief 获取循环外的出口后继块
+void Loop::getExitBlocks(std::vector<IRBlock *> & exits)
+{
+    for (auto block: blocks) {
+        for (auto succ: block->succs) {
+            if (!contains(succ) && std::find(exits.begin(), exits.end(), succ) == exits.end()) {
+                exits.push_back(succ);
+            }
+        }
+    }
+}
+
+/// @brief 获取存在循环外后继的循环内基本块
+void Loop::getExitingBlocks(std::vector<IRBlock *> & exitings)
+{
+    for (auto block: blocks) {
+        for (auto succ: block->succs) {
+            if (!contains(succ)) {
+                exitings.push_back(block);
+                break;
+            }
+        }
+    }
+}
+
+/// @brief 构造函数，识别回边并建立循环嵌套关系
+/// @param cfg 已计算支配关系的控制流图
+LoopInfo::LoopInfo(FunctionCFG * cfg)
+{
+    // 回边b->h要求h支配b，同一个循环头的回边合并为一个循环
+    std::unordered_map<IRBlock *, Loop *> headerLoop;
+    for (auto block: cfg->getBlocks()) {
+        if (!block->isReachable()) {
+            continue;
+        }
+        for (auto succ: block->succs) {
+            if (!cfg->dominates(succ, block)) {
+                continue;
+            }
+            Loop *& loop = headerLoop[succ];
+            if (loop == nullptr) {
+                loop = new Loop(succ);
+                loops.push_back(loop);
+            }
+            loop->latches.push_back(block);
+        }
+    }
+
+    // 从回边的源结点逆向遍历得到循环体
+    for (auto loop: loops) {
+        loop->blockSet.insert(loop->header);
+        std::vector<IRBlock *> worklist;
+        for (auto latch: loop->latches) {
+            if (loop->blockSet.insert(latch).second) {
+                worklist.push_back(latch);
+            }
+        }
+        while (!worklist.empty()) {
+            IRBlock * block = worklist.back();
+            worklist.pop_back();
+            for (auto pred: block->preds) {
+                if (pred->isReachable() && loop->blockSet.insert(pred).second) {
+                    worklist.push_back(pred);
+                }
+            }
+        }
+        for (auto block: cfg->getBlocks()) {
+            if (loop->blockSet.count(block)) {
+                loop->blocks.push_back(block);
+            }
+        }
+    }
+
+    // 按循环大小排序后，包含本循环头的最小的其它循环就是外层循环
+    std::stable_sort(loops.begin(), loops.end(), [](Loop * a, Loop * b) { return a->blocks.size() < b->blocks.size(); });
+    for (size_t i = 0; i < loops.size(); ++i) {
+        for (size_t k = i + 1; k < loops.size(); ++k) {
+            if (loops[k]->contains(loops[i]->header)) {
+                loops[i]->parent = loops[k];
+                loops[k]->subLoops.push_back(loops[i]);
+                break;
+            }
+        }
+    }
+    for (auto pIter = loops.rbegin(); pIter != loops.rend(); ++pIter) {
+        Loop * loop = *pIter;
+        loop->depth = loop->parent ? loop->parent->depth + 1 : 1;
+    }
+    for (auto loop: loops) {
+        for (auto block: loop->blocks) {
+            blockLoop.emplace(block, loop);
+        }
+    }
+}
+
+/// @brief 析构函数
+LoopInfo::~LoopInfo()
+{
+    for (auto loop: loops) {
+        delete loop;
+    }
+    loops.clear();
+}
+
+/// @brief 获取包含基本块的最内层循环
+/// @return 不在循环内返回nullptr
+Loop * LoopInfo::getLoopFor(IRBlock * block)
+{
+    auto pIter = blockLoop.find(block);
+    if (pIter == blockLoop.end()) {
+        return nullptr;
+    }
+    return pIter->second;
+}
+
+/// @brief 获取基本块的循环嵌套深度，不在循环内为0
+int LoopInfo::getLoopDepth(IRBlock * block)
+{
+    Loop * loop = getLoopFor(block);
+    return loop ? loop->depth : 0;
+}
+
+/// @brief 值在循环内是否不变：字面量、常量，或循环内没有定值的变量（全局变量还要求循环内没有函数调用）
+bool isLoopInvariant(Loop * loop, Value * val)
+{
+    if (val == nullptr) {
+        return false;
+    }
+    if (val->isliteral() || val->isConst()) {
+        return true;
+    }
+    if (val->is_numpy || val->is_issavenp() || val->np != nullptr) {
+        return false;
+    }
+    bool isGlobal = symtab.findSymbolValue(val);
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            if (getInstDef(inst) == val) {
+                return false;
+            }
+            if (isGlobal && inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 交换比较运算的两个操作数后对应的比较运算
+static IRInstOperator swapCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LE;
+        default:
+            return op;
+    }
+}
+
+/// @brief 识别"dst = iv + c"、"dst = c + iv"或"dst = iv - c"形式的指令
+/// @param inst 指令
+/// @param iv 循环变量
+/// @param step 增量
+/// @return true：匹配成功
+static bool matchIncrement(IRInst * inst, Value * iv, int & step)
+{
+    if (inst->getOp() == IRInstOperator::IRINST_OP_ADD_I) {
+        if (inst->getSrc1() == iv && isIntLiteral(inst->getSrc2())) {
+            step = inst->getSrc2()->intVal;
+            return true;
+        }
+        if (inst->getSrc2() == iv && isIntLiteral(inst->getSrc1())) {
+            step = inst->getSrc1()->intVal;
+            return true;
+        }
+    } else if (inst->getOp() == IRInstOperator::IRINST_OP_SUB_I) {
+        if (inst->getSrc1() == iv && isIntLiteral(inst->getSrc2())) {
+            step = -inst->getSrc2()->intVal;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 识别计数循环，只有循环头一个出口
+/// @param loop 循环
+/// @param info 识别结果
+/// @return true：是计数循环
+bool matchCountedLoop(Loop * loop, CountedLoop & info)
+{
+    IRBlock * header = loop->header;
+    if (loop->latches.size() != 1 || loop->latches[0] == header || header->insts.size() != 2) {
+        return false;
+    }
+    std::vector<IRBlock *> exitings;
+    loop->getExitingBlocks(exitings);
+    if (exitings.size() != 1 || exitings[0] != header) {
+        return false;
+    }
+
+    IRInst * cmp = header->insts[0];
+    IRInst * bc = header->insts[1];
+    if (bc->getOp() != IRInstOperator::IRINST_OP_BC || static_cast<BcIRInst *>(bc)->temp != cmp->getDst()) {
+        return false;
+    }
+    IRInstOperator op = cmp->getOp();
+    if (op != IRInstOperator::IRINST_OP_LT && op != IRInstOperator::IRINST_OP_LE &&
+        op != IRInstOperator::IRINST_OP_BT && op != IRInstOperator::IRINST_OP_BE &&
+        op != IRInstOperator::IRINST_OP_NQ) {
+        return false;
+    }
+
+    // 循环头的bc已规范化为mode 3，真出口进入循环体
+    std::vector<IRInst *> targets;
+    getBranchTargets(bc, targets);
+    IRBlock * body = nullptr;
+    IRBlock * exit = nullptr;
+    for (auto succ: header->succs) {
+        if (succ->label == targets[0]) {
+            body = succ;
+        } else if (succ->label == targets[1]) {
+            exit = succ;
+        }
+    }
+    if (body == nullptr || exit == nullptr || !loop->contains(body) || loop->contains(exit)) {
+        return false;
+    }
+
+    // 规范化成iv pred bound
+    Value * iv = cmp->getSrc1();
+    Value * bound = cmp->getSrc2();
+    if (!isScalarVar(iv) || iv->type.type != BasicType::TYPE_INT || !isLoopInvariant(loop, bound)) {
+        iv = cmp->getSrc2();
+        bound = cmp->getSrc1();
+        op = swapCompare(op);
+        if (!isScalarVar(iv) || iv->type.type != BasicType::TYPE_INT || !isLoopInvariant(loop, bound)) {
+            return false;
+        }
+    }
+    if (bound->type.type != BasicType::TYPE_INT) {
+        return false;
+    }
+
+    // 循环变量在循环内只有一个定值，且位于回边块中
+    IRBlock * latch = loop->latches[0];
+    IRInst * update = nullptr;
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            if (getInstDef(inst) != iv) {
+                continue;
+            }
+            if (update != nullptr || block != latch) {
+                return false;
+            }
+            update = inst;
+        }
+    }
+    if (update == nullptr) {
+        return false;
+    }
+
+    int step = 0;
+    IRInst * increment = update;
+    if (!matchIncrement(update, iv, step)) {
+        // iv = t，其中t = iv + c在同一块内先计算
+        if (update->getOp() != IRInstOperator::IRINST_OP_ASSIGN || getInstDef(update) != iv ||
+            static_cast<AssignIRInst *>(update)->_flag != 0 || update->Assign_flag == 6) {
+            return false;
+        }
+        Value * temp = update->getSrc1();
+        IRInst * tempDef = nullptr;
+        for (auto block: loop->blocks) {
+            for (auto inst: block->insts) {
+                if (getInstDef(inst) == temp) {
+                    if (tempDef != nullptr) {
+                        return false;
+                    }
+                    tempDef = inst;
+                }
+            }
+        }
+        if (tempDef == nullptr || !matchIncrement(tempDef, iv, step)) {
+            return false;
+        }
+        auto defIter = std::find(latch->insts.begin(), latch->insts.end(), tempDef);
+        auto updateIter = std::find(latch->insts.begin(), latch->insts.end(), update);
+        if (defIter == latch->insts.end() || defIter > updateIter) {
+            return false;
+        }
+        increment = tempDef;
+    }
+    if (step == 0) {
+        return false;
+    }
+
+    info.iv = iv;
+    info.bound = bound;
+    info.pred = op;
+    info.step = step;
+    info.cmpInst = cmp;
+    info.body = body;
+    info.exit = exit;
+    info.latch = latch;
+    info.updateInst = update;
+    info.incrementInst = increment;
+    return true;
+}
+
+/// @brief 按比较运算求值iv pred bound
+bool evalLoopCompare(IRInstOperator pred, long long iv, long long bound)
+{
+    switch (pred) {
+        case IRInstOperator::IRINST_OP_LT:
+            return iv < bound;
+        case IRInstOperator::IRINST_OP_LE:
+            return iv <= bound;
+        case IRInstOperator::IRINST_OP_BT:
+            return iv > bound;
+        case IRInstOperator::IRINST_OP_BE:
+            return iv >= bound;
+        case IRInstOperator::IRINST_OP_NQ:
+            return iv != bound;
+        default:
+            return false;
+    }
+}
+
+/// @brief 收集所有定值与使用都在循环内的临时变量，复制整个循环时可以统一重命名
+void collectLoopLocalTemps(FunctionCFG * cfg, Loop * loop, std::unordered_set<Value *> & temps)
+{
+    std::unordered_set<Value *> outside;
+    std::vector<Value *> values;
+    for (auto block: cfg->getBlocks()) {
+        bool inLoop = loop->contains(block);
+        for (auto inst: block->insts) {
+            values.clear();
+            getInstUses(inst, values);
+            values.push_back(getInstDef(inst));
+            for (auto val: values) {
+                if (val == nullptr || !val->isTemp() || val->is_FParam()) {
+                    continue;
+                }
+                if (inLoop) {
+                    temps.insert(val);
+                } else {
+                    outside.insert(val);
+                }
+            }
+        }
+    }
+    for (auto val: outside) {
+        temps.erase(val);
+    }
+}
+
+/// @brief 若循环没有preheader，则新建一个并把循环外前驱的跳转重定向到它
+/// @param cfg 控制流图，前驱后继关系会被更新
+/// @param loop 循环
+/// @return preheader基本块
+IRBlock * ensurePreheader(FunctionCFG * cfg, Loop * loop)
+{
+    IRBlock * preheader = loop->getPreheader();
+    if (preheader != nullptr) {
+        return preheader;
+    }
+
+    IRBlock * header = loop->header;
+    preheader = cfg->createBlockBefore(header);
+    preheader->insts.push_back(new BrIRInst(header->label));
+
+    std::vector<IRBlock *> preds = header->preds;
+    for (auto pred: preds) {
+        if (!loop->contains(pred)) {
+            replaceBranchTarget(pred->getTerminator(), header->label, preheader->label);
+        }
+    }
+    cfg->buildEdges();
+    return preheader;
+}
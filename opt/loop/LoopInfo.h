@@ -0,0 +1,149 @@
+/**
+ * @file LoopInfo.h
+ * @brief 基于回边识别的自然循环信息
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FunctionCFG.h"
+
+/// @brief 自然循环
+class Loop {
+
+public:
+    /// @brief 构造函数
+    /// @param _header 循环头
+    Loop(IRBlock * _header) : header(_header)
+    {}
+
+    /// @brief 基本块是否属于本循环（含内层循环）
+    bool contains(IRBlock * block)
+    {
+        return blockSet.count(block) != 0;
+    }
+
+    /// @brief 是否是最内层循环
+    bool isInnermost()
+    {
+        return subLoops.empty();
+    }
+
+    /// @brief 获取唯一的循环外前驱且其后继只有循环头，不存在返回nullptr
+    IRBlock * getPreheader();
+
+    /// @brief 获取循环外的出口后继块
+    void getExitBlocks(std::vector<IRBlock *> & exits);
+
+    /// @brief 获取存在循环外后继的循环内基本块
+    void getExitingBlocks(std::vector<IRBlock *> & exitings);
+
+    /// @brief 循环头
+    IRBlock * header;
+
+    /// @brief 跳回循环头的循环内基本块
+    std::vector<IRBlock *> latches;
+
+    /// @brief 循环内基本块，按函数布局顺序排列
+    std::vector<IRBlock *> blocks;
+
+    /// @brief 循环内基本块集合，便于查询
+    std::unordered_set<IRBlock *> blockSet;
+
+    /// @brief 外层循环
+    Loop * parent = nullptr;
+
+    /// @brief 直接内层循环
+    std::vector<Loop *> subLoops;
+
+    /// @brief 循环嵌套深度，最外层为1
+    int depth = 1;
+};
+
+/// @brief 函数内所有自然循环的信息，要求控制流图已计算支配关系
+class LoopInfo {
+
+public:
+    /// @brief 构造函数，识别回边并建立循环嵌套关系
+    /// @param cfg 已计算支配关系的控制流图
+    LoopInfo(FunctionCFG * cfg);
+
+    /// @brief 析构函数
+    ~LoopInfo();
+
+    /// @brief 获取所有循环，内层循环排在外层循环之前
+    std::vector<Loop *> & getLoops()
+    {
+        return loops;
+    }
+
+    /// @brief 获取包含基本块的最内层循环
+    /// @return 不在循环内返回nullptr
+    Loop * getLoopFor(IRBlock * block);
+
+    /// @brief 获取基本块的循环嵌套深度，不在循环内为0
+    int getLoopDepth(IRBlock * block);
+
+private:
+    /// @brief 所有循环
+    std::vector<Loop *> loops;
+
+    /// @brief 基本块到最内层循环的映射
+    std::unordered_map<IRBlock *, Loop *> blockLoop;
+};
+
+/// @brief 计数循环：循环头只有"t = iv pred bound; bc t, body, exit"，唯一的回边块中执行iv = iv + step
+struct CountedLoop {
+    /// @brief 循环变量
+    Value * iv = nullptr;
+
+    /// @brief 循环不变的边界
+    Value * bound = nullptr;
+
+    /// @brief 规范化为"iv pred bound"后的比较运算
+    IRInstOperator pred = IRInstOperator::IRINST_OP_MAX;
+
+    /// @brief 每次迭代循环变量的增量
+    int step = 0;
+
+    /// @brief 循环头中的比较指令
+    IRInst * cmpInst = nullptr;
+
+    /// @brief 循环体入口，即bc的真出口
+    IRBlock * body = nullptr;
+
+    /// @brief 循环出口，即bc的假出口
+    IRBlock * exit = nullptr;
+
+    /// @brief 唯一的回边块
+    IRBlock * latch = nullptr;
+
+    /// @brief 循环变量在循环内的唯一定值指令
+    IRInst * updateInst = nullptr;
+
+    /// @brief 计算iv + step的指令，与updateInst相同或者是其源操作数的定值指令
+    IRInst * incrementInst = nullptr;
+};
+
+/// @brief 值在循环内是否不变：字面量、常量，或循环内没有定值的变量（全局变量还要求循环内没有函数调用）
+bool isLoopInvariant(Loop * loop, Value * val);
+
+/// @brief 识别计数循环，只有循环头一个出口
+/// @param loop 循环
+/// @param info 识别结果
+/// @return true：是计数循环
+bool matchCountedLoop(Loop * loop, CountedLoop & info);
+
+/// @brief 按比较运算求值iv pred bound
+bool evalLoopCompare(IRInstOperator pred, long long iv, long long bound);
+
+/// @brief 收集所有定值与使用都在循环内的临时变量，复制整个循环时可以统一重命名
+void collectLoopLocalTemps(FunctionCFG * cfg, Loop * loop, std::unordered_set<Value *> & temps);
+
+/// @brief 若循环没有preheader，则新建一个并把循环外前驱的跳转重定向到它
+/// @param cfg 控制流图，前驱后继关系会被更新
+/// @param loop 循环
+/// @return preheader基本块
+IRBlock * ensurePreheader(FunctionCFG * cfg, Loop * loop);
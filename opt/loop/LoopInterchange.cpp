@@ -0,0 +1,632 @@
+/**
+ * @file LoopInterchange.cpp
+ * @brief 两层完美嵌套计数循环的交换与分块，使数组按行优先的内存布局顺序访问
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+#include "LoopInterchange.h"
+
+/// @brief 缓存行字节数，步长超过它的访问每次都缺失
+static const long long CACHE_LINE_BYTES = 64;
+
+/// @brief 数组元素字节数
+static const long long ELEMENT_BYTES = 4;
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _tileSize 分块时内层循环每块的迭代次数
+LoopInterchange::LoopInterchange(Function * _func, int _tileSize) : func(_func), tileSize(_tileSize)
+{}
+
+/// @brief 对函数内的两层完美嵌套循环进行交换与分块
+/// @return true：函数的IR被修改
+bool LoopInterchange::run()
+{
+    bool changed = false;
+    std::unordered_set<IRInst *> interchanged;
+
+    // 每次只变换一个循环嵌套，变换后重建控制流图与循环信息
+    for (;;) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool transformed = false;
+        for (auto loop: loopInfo.getLoops()) {
+            IRInst * label = loop->header->label;
+            if (visited.count(label)) {
+                continue;
+            }
+            LoopNest nest;
+            std::vector<MemAccess> accesses;
+            if (!matchNest(&cfg, loop, nest) || !collectAccesses(&cfg, nest, accesses) || !isLegal(accesses)) {
+                continue;
+            }
+
+            // 按内层循环每次迭代跨越的缓存行估计代价，内层步长更大时交换
+            long long outerCost = 0;
+            long long innerCost = 0;
+            bool strided = false;
+            for (auto & access: accesses) {
+                long long outerStride = std::llabs(access.offset.outerCoef);
+                long long innerStride = std::llabs(access.offset.innerCoef);
+                outerCost += std::min(outerStride, CACHE_LINE_BYTES);
+                innerCost += std::min(innerStride, CACHE_LINE_BYTES);
+                if (innerStride >= CACHE_LINE_BYTES && outerStride > 0 && outerStride < CACHE_LINE_BYTES) {
+                    strided = true;
+                }
+            }
+            if (!interchanged.count(label) && innerCost > outerCost) {
+                interchanged.insert(label);
+                interchange(&cfg, nest);
+                transformed = true;
+                break;
+            }
+            visited.insert(label);
+
+            // 内层仍是大步长访问，且相邻的外层迭代会访问同一缓存行时分块
+            CountedLoop & innerInfo = nest.innerInfo;
+            if (!strided || tileSize < 2 || innerInfo.pred != IRInstOperator::IRINST_OP_LT || innerInfo.step != 1) {
+                continue;
+            }
+            Value * init = nest.initInst->getSrc1();
+            if (isIntLiteral(init) && isIntLiteral(innerInfo.bound) &&
+                innerInfo.bound->intVal - init->intVal <= tileSize) {
+                continue;
+            }
+            tile(&cfg, nest);
+            transformed = true;
+            break;
+        }
+        if (!transformed) {
+            break;
+        }
+
+        cfg.writeBack();
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 识别以outer为外层的两层完美嵌套循环
+bool LoopInterchange::matchNest(FunctionCFG * cfg, Loop * outer, LoopNest & nest)
+{
+    if (outer->subLoops.size() != 1 || !outer->subLoops[0]->isInnermost()) {
+        return false;
+    }
+    Loop * inner = outer->subLoops[0];
+    nest.outer = outer;
+    nest.inner = inner;
+    CountedLoop & outerInfo = nest.outerInfo;
+    CountedLoop & innerInfo = nest.innerInfo;
+    if (!matchCountedLoop(outer, outerInfo) || !matchCountedLoop(inner, innerInfo) ||
+        outerInfo.iv == innerInfo.iv) {
+        return false;
+    }
+
+    // 外层循环体入口到内层循环头之间只有内层循环变量的初始化
+    std::unordered_set<IRBlock *> seen;
+    IRBlock * block = outerInfo.body;
+    while (block != inner->header) {
+        if (!outer->contains(block) || inner->contains(block) || block->succs.size() != 1 ||
+            !seen.insert(block).second) {
+            return false;
+        }
+        for (auto inst: block->insts) {
+            if (inst == block->insts.back()) {
+                break;
+            }
+            if (nest.initInst != nullptr || getInstDef(inst) != innerInfo.iv ||
+                inst->getOp() != IRInstOperator::IRINST_OP_ASSIGN ||
+                (static_cast<AssignIRInst *>(inst)->_flag != 0 && static_cast<AssignIRInst *>(inst)->_flag != 1)) {
+                return false;
+            }
+            nest.initInst = inst;
+            nest.initBlock = block;
+        }
+        block = block->succs[0];
+    }
+    if (nest.initInst == nullptr) {
+        return false;
+    }
+
+    // 内层循环出口到外层回边块之间只有外层循环变量的更新
+    block = innerInfo.exit;
+    for (;;) {
+        if (!outer->contains(block) || inner->contains(block) || block->succs.size() != 1 ||
+            !seen.insert(block).second) {
+            return false;
+        }
+        for (auto inst: block->insts) {
+            if (inst != block->insts.back() && inst != outerInfo.updateInst && inst != outerInfo.incrementInst) {
+                return false;
+            }
+        }
+        if (block == outerInfo.latch) {
+            break;
+        }
+        block = block->succs[0];
+    }
+    if (seen.size() + inner->blocks.size() + 1 != outer->blocks.size()) {
+        return false;
+    }
+    if (!getUpdateInsts(outerInfo, nest.outerUpdate) || !getUpdateInsts(innerInfo, nest.innerUpdate)) {
+        return false;
+    }
+
+    // 内层循环的初值与边界不能依赖外层循环变量
+    Value * init = nest.initInst->getSrc1();
+    if (!isIntLiteral(init) && (init == outerInfo.iv || !isLoopInvariant(outer, init))) {
+        return false;
+    }
+    if (innerInfo.bound == outerInfo.iv || !isLoopInvariant(outer, innerInfo.bound)) {
+        return false;
+    }
+
+    // 交换后循环变量的终值会不同，要求循环结束后不再使用
+    if (isLiveIn(outerInfo.exit, outerInfo.iv) || isLiveIn(outerInfo.exit, innerInfo.iv)) {
+        return false;
+    }
+
+    for (auto loopBlock: outer->blocks) {
+        for (auto inst: loopBlock->insts) {
+            Value * def = getInstDef(inst);
+            if (def != nullptr) {
+                nest.defs[def].push_back(inst);
+            }
+        }
+    }
+    (void) cfg;
+    return true;
+}
+
+/// @brief 获取循环变量在回边块末尾的更新指令
+bool LoopInterchange::getUpdateInsts(CountedLoop & info, std::vector<IRInst *> & update)
+{
+    std::vector<IRInst *> & insts = info.latch->insts;
+    if (insts.back()->getOp() != IRInstOperator::IRINST_OP_BR) {
+        return false;
+    }
+    if (info.incrementInst != info.updateInst) {
+        update.push_back(info.incrementInst);
+    }
+    update.push_back(info.updateInst);
+
+    // 更新指令必须是跳转之前的最后几条指令，这样才能整体移动
+    if (insts.size() < update.size() + 1) {
+        return false;
+    }
+    return std::equal(update.begin(), update.end(), insts.end() - 1 - update.size());
+}
+
+/// @brief 仿射表达式相加，sign为-1时相减
+static void addAffine(AffineExpr & dst, const AffineExpr & src, long long sign)
+{
+    dst.outerCoef += sign * src.outerCoef;
+    dst.innerCoef += sign * src.innerCoef;
+    dst.constant += sign * src.constant;
+    for (auto & pair: src.symbols) {
+        dst.symbols[pair.first] += sign * pair.second;
+        if (dst.symbols[pair.first] == 0) {
+            dst.symbols.erase(pair.first);
+        }
+    }
+}
+
+/// @brief 仿射表达式是否是常数
+static bool isConstantAffine(const AffineExpr & expr)
+{
+    return expr.outerCoef == 0 && expr.innerCoef == 0 && expr.symbols.empty();
+}
+
+/// @brief 仿射表达式乘以常数
+static void scaleAffine(AffineExpr & expr, long long factor)
+{
+    expr.outerCoef *= factor;
+    expr.innerCoef *= factor;
+    expr.constant *= factor;
+    for (auto pIter = expr.symbols.begin(); pIter != expr.symbols.end();) {
+        pIter->second *= factor;
+        if (pIter->second == 0) {
+            pIter = expr.symbols.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+}
+
+/// @brief 把变量表示为两层循环变量的仿射表达式
+bool LoopInterchange::evalAffine(LoopNest & nest, Value * val, AffineExpr & expr, int depth)
+{
+    if (val == nullptr || depth > 32) {
+        return false;
+    }
+    if (val == nest.outerInfo.iv) {
+        expr.outerCoef = 1;
+        return true;
+    }
+    if (val == nest.innerInfo.iv) {
+        expr.innerCoef = 1;
+        return true;
+    }
+    if (isIntLiteral(val)) {
+        expr.constant = val->intVal;
+        return true;
+    }
+
+    auto pIter = nest.defs.find(val);
+    if (pIter == nest.defs.end()) {
+        // 嵌套内没有定值的整型标量作为符号项
+        if (val->type.type != BasicType::TYPE_INT || val->is_numpy || val->np != nullptr) {
+            return false;
+        }
+        expr.symbols[val] = 1;
+        return true;
+    }
+
+    // 只沿块内先定值后使用的临时变量展开，局部变量可能跨迭代传值
+    if (!val->isTemp() || pIter->second.size() != 1) {
+        return false;
+    }
+    IRInst * def = pIter->second[0];
+    AffineExpr lhs, rhs;
+    switch (def->getOp()) {
+        case IRInstOperator::IRINST_OP_ASSIGN:
+            if (static_cast<AssignIRInst *>(def)->_flag != 0 || def->Assign_flag == 6) {
+                return false;
+            }
+            return evalAffine(nest, def->getSrc1(), expr, depth + 1);
+        case IRInstOperator::IRINST_OP_ADD_I:
+        case IRInstOperator::IRINST_OP_SUB_I:
+            if (!evalAffine(nest, def->getSrc1(), lhs, depth + 1) || !evalAffine(nest, def->getSrc2(), rhs, depth + 1)) {
+                return false;
+            }
+            expr = lhs;
+            addAffine(expr, rhs, def->getOp() == IRInstOperator::IRINST_OP_ADD_I ? 1 : -1);
+            return true;
+        case IRInstOperator::IRINST_OP_MULT_I:
+            if (!evalAffine(nest, def->getSrc1(), lhs, depth + 1) || !evalAffine(nest, def->getSrc2(), rhs, depth + 1)) {
+                return false;
+            }
+            if (isConstantAffine(rhs)) {
+                expr = lhs;
+                scaleAffine(expr, rhs.constant);
+                return true;
+            }
+            if (isConstantAffine(lhs)) {
+                expr = rhs;
+                scaleAffine(expr, lhs.constant);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/// @brief 是否是整型的累加归约变量：只以var = var ± y的形式定值与使用，迭代顺序不影响结果
+static bool isReduction(LoopNest & nest, Value * var)
+{
+    if (!isScalarVar(var) || var->type.type != BasicType::TYPE_INT) {
+        return false;
+    }
+
+    // 定值都在内层循环体内
+    std::unordered_set<IRInst *> bodyInsts;
+    for (auto block: nest.inner->blocks) {
+        if (block != nest.inner->header) {
+            bodyInsts.insert(block->insts.begin(), block->insts.end());
+        }
+    }
+
+    std::unordered_set<IRInst *> allowedUses;
+    for (auto def: nest.defs[var]) {
+        if (!bodyInsts.count(def) || def->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL) {
+            return false;
+        }
+        IRInst * arith = def;
+        if (def->getOp() == IRInstOperator::IRINST_OP_ASSIGN) {
+            if (static_cast<AssignIRInst *>(def)->_flag != 0 || def->Assign_flag == 6) {
+                return false;
+            }
+            auto pIter = nest.defs.find(def->getSrc1());
+            if (pIter == nest.defs.end() || pIter->second.size() != 1) {
+                return false;
+            }
+            arith = pIter->second[0];
+        }
+        bool isAdd = arith->getOp() == IRInstOperator::IRINST_OP_ADD_I;
+        bool isSub = arith->getOp() == IRInstOperator::IRINST_OP_SUB_I;
+        if (!isAdd && !isSub) {
+            return false;
+        }
+        Value * src1 = arith->getSrc1();
+        Value * src2 = arith->getSrc2();
+        if (!((src1 == var && src2 != var) || (isAdd && src2 == var && src1 != var))) {
+            return false;
+        }
+        allowedUses.insert(arith);
+    }
+
+    std::vector<Value *> uses;
+    for (auto block: nest.outer->blocks) {
+        for (auto inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            if (std::find(uses.begin(), uses.end(), var) != uses.end() && !allowedUses.count(inst)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 收集内层循环体内的数组访问，并检查其它标量定值是否允许重排迭代
+bool LoopInterchange::collectAccesses(FunctionCFG * cfg, LoopNest & nest, std::vector<MemAccess> & accesses)
+{
+    std::unordered_map<Value *, IRBlock *> blockTemps;
+    collectBlockLocalTemps(cfg, blockTemps);
+
+    // 循环头的比较结果交换后含义不同，只能在循环头内使用
+    for (auto loop: {nest.outer, nest.inner}) {
+        auto pIter = blockTemps.find(loop->header->insts[0]->getDst());
+        if (pIter == blockTemps.end() || pIter->second != loop->header) {
+            return false;
+        }
+    }
+
+    for (auto block: nest.inner->blocks) {
+        if (block == nest.inner->header) {
+            continue;
+        }
+        for (auto inst: block->insts) {
+            IRInstOperator op = inst->getOp();
+            if (op == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                return false;
+            }
+            if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+                int flag = static_cast<AssignIRInst *>(inst)->_flag;
+                if (flag == 2 || flag == 4) {
+                    MemAccess access;
+                    if (!decomposePointer(nest, inst->getSrc1(), access)) {
+                        return false;
+                    }
+                    accesses.push_back(access);
+                }
+                if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                    MemAccess access;
+                    access.isStore = true;
+                    if (!decomposePointer(nest, inst->getDst(), access)) {
+                        return false;
+                    }
+                    accesses.push_back(access);
+                }
+            } else if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_OR &&
+                       static_cast<BinaryIRInst *>(inst)->mode >= 4) {
+                // 二元运算直接访问内存的形式
+                return false;
+            }
+
+            Value * def = getInstDef(inst);
+            if (def == nullptr) {
+                continue;
+            }
+            if (def->isTemp()) {
+                auto pIter = blockTemps.find(def);
+                if (pIter == blockTemps.end() || pIter->second != block) {
+                    return false;
+                }
+            } else if (def == nest.innerInfo.iv) {
+                if (inst != nest.innerInfo.updateInst) {
+                    return false;
+                }
+            } else if (def == nest.outerInfo.iv || !isReduction(nest, def)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 把指针分解为数组基址与仿射的字节偏移
+bool LoopInterchange::decomposePointer(LoopNest & nest, Value * ptr, MemAccess & access)
+{
+    auto pIter = nest.defs.find(ptr);
+    if (pIter == nest.defs.end() || pIter->second.size() != 1) {
+        return false;
+    }
+    IRInst * def = pIter->second[0];
+    if (def->getOp() != IRInstOperator::IRINST_OP_ADD_I || static_cast<BinaryIRInst *>(def)->mode >= 4) {
+        return false;
+    }
+    Value * base = def->getSrc1();
+    if (nest.defs.count(base) || (base->np == nullptr && !base->is_numpy)) {
+        return false;
+    }
+    access.base = base;
+    return evalAffine(nest, def->getSrc2(), access.offset);
+}
+
+/// @brief 同一数组上的两次访问在交换迭代顺序后是否仍保持先后关系
+/// @details 两次访问分别在迭代(u1, v1)与(u2, v2)上访问同一地址时 a * du + b * dv = e，
+/// 只有存在du与dv异号的解时交换才会改变依赖方向
+static bool isSafePair(const MemAccess & first, const MemAccess & second)
+{
+    if (first.offset.symbols != second.offset.symbols || first.offset.outerCoef != second.offset.outerCoef ||
+        first.offset.innerCoef != second.offset.innerCoef) {
+        return false;
+    }
+    long long a = first.offset.outerCoef;
+    long long b = first.offset.innerCoef;
+    long long e = second.offset.constant - first.offset.constant;
+
+    if (a == 0 && b == 0) {
+        return e != 0;
+    }
+    if (a == 0) {
+        return e == 0 || e % b != 0;
+    }
+    if (b == 0) {
+        return e == 0 || e % a != 0;
+    }
+    if (e != 0) {
+        return e % std::gcd(a, b) != 0;
+    }
+    if ((a > 0) != (b > 0)) {
+        return true;
+    }
+
+    // 按行优先布局，列下标不越界时一个循环变量选行、另一个选列的访问只有du = dv = 0的解
+    Value * base = first.base;
+    if (base->is_saveFParam || base->np == nullptr || base->np->np_sizes.size() < 2 || base->np->np_sizes[0] < 2) {
+        return false;
+    }
+    long long rowBytes = ELEMENT_BYTES * base->np->np_sizes[0];
+    return (std::llabs(a) == ELEMENT_BYTES && b % rowBytes == 0) || (std::llabs(b) == ELEMENT_BYTES && a % rowBytes == 0);
+}
+
+/// @brief 依赖测试：不存在方向为(<, >)的依赖时交换或分块是合法的
+bool LoopInterchange::isLegal(std::vector<MemAccess> & accesses)
+{
+    for (size_t i = 0; i < accesses.size(); ++i) {
+        if (!accesses[i].isStore) {
+            continue;
+        }
+        for (size_t j = 0; j < accesses.size(); ++j) {
+            if (j < i && accesses[j].isStore) {
+                continue;
+            }
+            Value * base = accesses[i].base;
+            Value * other = accesses[j].base;
+            if (base != other) {
+                // 形参数组可能与其它数组重叠
+                if (base->is_saveFParam || other->is_saveFParam) {
+                    return false;
+                }
+                continue;
+            }
+            if (!isSafePair(accesses[i], accesses[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 从回边块中取出循环变量的更新指令
+static void removeUpdate(CountedLoop & info, std::vector<IRInst *> & update)
+{
+    std::vector<IRInst *> & insts = info.latch->insts;
+    auto pIter = insts.end() - 1 - update.size();
+    insts.erase(pIter, pIter + update.size());
+}
+
+/// @brief 把循环变量的更新指令放到回边块的跳转之前
+static void insertUpdate(CountedLoop & info, std::vector<IRInst *> & update)
+{
+    std::vector<IRInst *> & insts = info.latch->insts;
+    insts.insert(insts.end() - 1, update.begin(), update.end());
+}
+
+/// @brief 交换内外层循环
+void LoopInterchange::interchange(FunctionCFG * cfg, LoopNest & nest)
+{
+    IRBlock * outerHeader = nest.outer->header;
+    IRBlock * innerHeader = nest.inner->header;
+    IRBlock * preheader = ensurePreheader(cfg, nest.outer);
+
+    // 内层循环变量在进入嵌套前初始化，外层循环变量的初值保存下来，每次进入内层循环时重新开始
+    Value * outerInit = func->newTempValue(BasicType::TYPE_INT);
+    std::unordered_map<Value *, Value *> noValues;
+    std::unordered_map<IRInst *, IRInst *> noLabels;
+    preheader->insts.insert(preheader->insts.end() - 1,
+                            {new AssignIRInst(outerInit, nest.outerInfo.iv, 0),
+                             cloneInst(nest.initInst, noValues, noLabels)});
+    *std::find(nest.initBlock->insts.begin(), nest.initBlock->insts.end(), nest.initInst) =
+        new AssignIRInst(nest.outerInfo.iv, outerInit, 0);
+
+    // 交换两个循环头的比较
+    std::swap(outerHeader->insts[0], innerHeader->insts[0]);
+    static_cast<BcIRInst *>(outerHeader->insts[1])->temp = outerHeader->insts[0]->getDst();
+    static_cast<BcIRInst *>(innerHeader->insts[1])->temp = innerHeader->insts[0]->getDst();
+
+    // 交换两个循环变量的更新
+    removeUpdate(nest.outerInfo, nest.outerUpdate);
+    removeUpdate(nest.innerInfo, nest.innerUpdate);
+    insertUpdate(nest.outerInfo, nest.innerUpdate);
+    insertUpdate(nest.innerInfo, nest.outerUpdate);
+
+    cfg->buildEdges();
+}
+
+/// @brief 内层循环按tileSize分段，段循环移到外层循环之外
+/// @details for (v = v0; v < M; v += T) for (u ...) for (v' = v; v' < min(v + T, M); v'++)
+void LoopInterchange::tile(FunctionCFG * cfg, LoopNest & nest)
+{
+    IRBlock * outerHeader = nest.outer->header;
+    IRBlock * preheader = ensurePreheader(cfg, nest.outer);
+    CountedLoop & outerInfo = nest.outerInfo;
+    CountedLoop & innerInfo = nest.innerInfo;
+    Value * bound = innerInfo.bound;
+    BasicType condType = innerInfo.cmpInst->getDst()->type.type;
+
+    Value * outerInit = func->newTempValue(BasicType::TYPE_INT);
+    Value * tileIv = func->newTempValue(BasicType::TYPE_INT);
+    Value * tileNext = func->newTempValue(BasicType::TYPE_INT);
+    Value * tileEnd = func->newTempValue(BasicType::TYPE_INT);
+    Value * tileCond = func->newTempValue(condType);
+    Value * endCond = func->newTempValue(condType);
+
+    // preheader中保存外层循环变量的初值，段循环变量从内层循环的初值开始
+    std::unordered_map<Value *, Value *> initMap{{innerInfo.iv, tileIv}};
+    std::unordered_map<IRInst *, IRInst *> noLabels;
+    preheader->insts.insert(preheader->insts.end() - 1,
+                            {new AssignIRInst(outerInit, outerInfo.iv, 0),
+                             cloneInst(nest.initInst, initMap, noLabels)});
+
+    // 段循环头
+    IRBlock * tileHeader = cfg->createBlockBefore(outerHeader);
+    tileHeader->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_LT, tileCond, tileIv, bound));
+    BcIRInst * bc = new BcIRInst();
+    bc->mode = 3;
+    bc->temp = tileCond;
+    tileHeader->insts.push_back(bc);
+
+    // 段循环体入口：外层循环变量从初值开始，本段的终值取v + T与M中较小的一个
+    IRBlock * tileBody = cfg->createBlock(tileHeader);
+    tileBody->insts.push_back(new AssignIRInst(outerInfo.iv, outerInit, 0));
+    tileBody->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, tileNext, tileIv, tileSize, 2));
+    tileBody->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_LT, endCond, tileNext, bound));
+    IRBlock * fullTile = cfg->createBlock(tileBody);
+    fullTile->insts.push_back(new AssignIRInst(tileEnd, tileNext, 0));
+    fullTile->insts.push_back(new BrIRInst(outerHeader->label));
+    IRBlock * lastTile = cfg->createBlock(fullTile);
+    lastTile->insts.push_back(new AssignIRInst(tileEnd, bound, 0));
+    lastTile->insts.push_back(new BrIRInst(outerHeader->label));
+    BcIRInst * endBc = new BcIRInst();
+    endBc->mode = 3;
+    endBc->temp = endCond;
+    endBc->setTrueInst(fullTile->label);
+    endBc->setFalseInst(lastTile->label);
+    tileBody->insts.push_back(endBc);
+
+    // 外层循环结束后进入下一段
+    IRBlock * tileLatch = cfg->createBlock(nest.outer->blocks.back());
+    tileLatch->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, tileIv, tileIv, tileSize, 2));
+    tileLatch->insts.push_back(new BrIRInst(tileHeader->label));
+    bc->setTrueInst(tileBody->label);
+    bc->setFalseInst(outerInfo.exit->label);
+    replaceBranchTarget(outerHeader->getTerminator(), outerInfo.exit->label, tileLatch->label);
+    replaceBranchTarget(preheader->getTerminator(), outerHeader->label, tileHeader->label);
+
+    // 内层循环在本段内迭代
+    *std::find(nest.initBlock->insts.begin(), nest.initBlock->insts.end(), nest.initInst) =
+        new AssignIRInst(innerInfo.iv, tileIv, 0);
+    replaceInstUse(innerInfo.cmpInst, bound, tileEnd);
+
+    visited.insert(tileHeader->label);
+    cfg->buildEdges();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file LoopInterchange.h
+ * @brief 两层完美嵌套计数循环的交换与分块，使数组按行优先的内存布局顺序访问
+ */
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "LoopInfo.h"
+
+/// @brief 两层完美嵌套的计数循环：外层循环体只有内层循环变量的初始化、内层循环以及外层循环变量的更新
+struct LoopNest {
+    /// @brief 外层循环
+    Loop * outer = nullptr;
+
+    /// @brief 内层循环
+    Loop * inner = nullptr;
+
+    /// @brief 外层计数循环信息
+    CountedLoop outerInfo;
+
+    /// @brief 内层计数循环信息
+    CountedLoop innerInfo;
+
+    /// @brief 内层循环变量初始化所在的块
+    IRBlock * initBlock = nullptr;
+
+    /// @brief 内层循环变量的初始化指令
+    IRInst * initInst = nullptr;
+
+    /// @brief 外层循环变量的更新指令，按块内顺序
+    std::vector<IRInst *> outerUpdate;
+
+    /// @brief 内层循环变量的更新指令，按块内顺序
+    std::vector<IRInst *> innerUpdate;
+
+    /// @brief 嵌套内每个变量的定值指令
+    std::unordered_map<Value *, std::vector<IRInst *>> defs;
+};
+
+/// @brief 以两层循环变量表示的仿射表达式：outerCoef * u + innerCoef * v + constant + Σ symbols
+struct AffineExpr {
+    /// @brief 外层循环变量的系数
+    long long outerCoef = 0;
+
+    /// @brief 内层循环变量的系数
+    long long innerCoef = 0;
+
+    /// @brief 常数项
+    long long constant = 0;
+
+    /// @brief 循环不变量及其系数
+    std::map<Value *, long long> symbols;
+};
+
+/// @brief 数组访问：基址加上以字节为单位的仿射偏移
+struct MemAccess {
+    /// @brief 数组基址
+    Value * base = nullptr;
+
+    /// @brief 字节偏移
+    AffineExpr offset;
+
+    /// @brief 是否是写
+    bool isStore = false;
+};
+
+/// @brief 循环交换与分块
+class LoopInterchange {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _tileSize 分块时内层循环每块的迭代次数
+    LoopInterchange(Function * _func, int _tileSize = 32);
+
+    /// @brief 对函数内的两层完美嵌套循环进行交换与分块
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 识别以outer为外层的两层完美嵌套循环
+    bool matchNest(FunctionCFG * cfg, Loop * outer, LoopNest & nest);
+
+    /// @brief 获取循环变量在回边块末尾的更新指令
+    bool getUpdateInsts(CountedLoop & info, std::vector<IRInst *> & update);
+
+    /// @brief 把变量表示为两层循环变量的仿射表达式
+    bool evalAffine(LoopNest & nest, Value * val, AffineExpr & expr, int depth = 0);
+
+    /// @brief 把指针分解为数组基址与仿射的字节偏移
+    bool decomposePointer(LoopNest & nest, Value * ptr, MemAccess & access);
+
+    /// @brief 收集内层循环体内的数组访问，并检查其它标量定值是否允许重排迭代
+    bool collectAccesses(FunctionCFG * cfg, LoopNest & nest, std::vector<MemAccess> & accesses);
+
+    /// @brief 依赖测试：不存在方向为(<, >)的依赖时交换或分块是合法的
+    bool isLegal(std::vector<MemAccess> & accesses);
+
+    /// @brief 交换内外层循环
+    void interchange(FunctionCFG * cfg, LoopNest & nest);
+
+    /// @brief 内层循环按tileSize分段，段循环移到外层循环之外
+    void tile(FunctionCFG * cfg, LoopNest & nest);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 分块大小
+    int tileSize;
+
+    /// @brief 已处理过的外层循环头Label
+    std::unordered_set<IRInst *> visited;
+};
@@ -0,0 +1,525 @@
+/**
+ * @file LoopParallelization.cpp
+ * @brief 循环并行化：没有跨迭代依赖的最外层计数循环外提为单独的函数，由运行时库把迭代区间分给多个线程执行
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "LoopParallelization.h"
+
+/// @brief 外提的循环函数名前缀，后跟循环编号
+static const std::string LOOP_FUNC_PREFIX = "__sysy_par_loop";
+
+/// @brief 传递循环内使用的变量的全局变量名前缀，后跟循环编号与变量序号
+static const std::string SLOT_PREFIX = "__par_";
+
+/// @brief 数组元素字节数
+static const long long ELEMENT_BYTES = 4;
+
+/// @brief 是否是全局变量或全局数组
+static bool isGlobalValue(SymbolTable & symtab, Value * val)
+{
+    return !val->isliteral() && symtab.findSymbolValue(val);
+}
+
+/// @brief 仿射表达式相加，sign为-1时相减
+static void addIndex(ParallelIndex & dst, const ParallelIndex & src, long long sign)
+{
+    dst.ivCoef += sign * src.ivCoef;
+    dst.constant += sign * src.constant;
+    for (auto terms: {std::make_pair(&dst.invariants, &src.invariants), std::make_pair(&dst.variants, &src.variants)}) {
+        for (auto & pair: *terms.second) {
+            long long & coef = (*terms.first)[pair.first];
+            coef += sign * pair.second;
+            if (coef == 0) {
+                terms.first->erase(pair.first);
+            }
+        }
+    }
+}
+
+/// @brief 仿射表达式是否是常数
+static bool isConstantIndex(const ParallelIndex & index)
+{
+    return index.ivCoef == 0 && index.invariants.empty() && index.variants.empty();
+}
+
+/// @brief 仿射表达式乘以常数
+static void scaleIndex(ParallelIndex & index, long long factor)
+{
+    index.ivCoef *= factor;
+    index.constant *= factor;
+    for (auto terms: {&index.invariants, &index.variants}) {
+        for (auto pIter = terms->begin(); pIter != terms->end();) {
+            pIter->second *= factor;
+            if (pIter->second == 0) {
+                pIter = terms->erase(pIter);
+            } else {
+                ++pIter;
+            }
+        }
+    }
+}
+
+/// @brief 同一条或两条访问在不同的迭代中是否不会访问同一地址
+/// @details 没有迭代内任意取值的项时，两次访问在迭代i1与i2上访问同一地址当且仅当c * (i1 - i2) = d。
+/// 否则要求两次访问的偏移形式完全相同，循环变量只出现在最高维下标中，
+/// 按行优先布局，低维下标不越界时不同迭代访问的是不同的行
+static bool isIndependent(const ParallelAccess & first, const ParallelAccess & second)
+{
+    if (first.base != second.base) {
+        return true;
+    }
+    if (first.offset.invariants != second.offset.invariants || first.offset.ivCoef != second.offset.ivCoef) {
+        return false;
+    }
+    long long c = first.offset.ivCoef;
+    long long d = second.offset.constant - first.offset.constant;
+
+    if (first.offset.variants.empty() && second.offset.variants.empty()) {
+        if (c == 0) {
+            return d != 0;
+        }
+        return d == 0 || d % c != 0;
+    }
+    if (first.offset.variants != second.offset.variants || c == 0 || d != 0) {
+        return false;
+    }
+
+    // 最高维的一行的字节数
+    Value * base = first.base;
+    if (base->np == nullptr || base->np->np_sizes.size() < 2) {
+        return false;
+    }
+    long long rowBytes = ELEMENT_BYTES;
+    for (size_t i = 0; i + 1 < base->np->np_sizes.size(); ++i) {
+        rowBytes *= base->np->np_sizes[i];
+    }
+    if (rowBytes <= 0 || c % rowBytes != 0) {
+        return false;
+    }
+    for (auto & pair: first.offset.variants) {
+        if (std::llabs(pair.second) >= rowBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 按给定的名字为函数追加整型形参，并在entry之后的code中把形参复制到形参变量
+/// @details 形参变量先于函数内的其它变量创建，保证它们在变量表中的位置与形参顺序一致
+static void addIntParams(Function * func, const std::vector<std::string> & names, std::vector<IRInst *> & code)
+{
+    std::vector<FuncFormalParam> & params = func->getParams();
+    for (auto & name: names) {
+        Value * var = func->newVarValue(name, BasicType::TYPE_INT);
+        var->is_saveFParam = 1;
+        params.emplace_back(name, BasicType::TYPE_INT, var);
+    }
+    for (auto & param: params) {
+        Value * temp = func->newTempValue(param.type.type);
+        temp->set_FParam();
+        param.save_val = temp;
+        code.push_back(new AssignIRInst(param.val, param.save_val));
+    }
+}
+
+/// @brief 新建以val为条件的bc指令
+static BcIRInst * newBranch(Value * cond, IRInst * trueLabel, IRInst * falseLabel)
+{
+    BcIRInst * bc = new BcIRInst();
+    bc->mode = 3;
+    bc->temp = cond;
+    bc->setTrueInst(trueLabel);
+    bc->setFalseInst(falseLabel);
+    return bc;
+}
+
+/// @brief 构造函数
+/// @param _symtab 符号表
+/// @param _minTripCount 边界为常量时并行化所需的最小迭代次数
+LoopParallelization::LoopParallelization(SymbolTable & _symtab, int _minTripCount)
+    : symtab(_symtab), minTripCount(_minTripCount)
+{}
+
+/// @brief 并行化所有函数中可以并行的最外层循环，并生成分发函数
+/// @return true：有循环被并行化
+bool LoopParallelization::run()
+{
+    // 外提的函数会追加到函数列表中，只遍历原有的函数
+    std::vector<Function *> funcs = symtab.getFunctionList();
+    for (auto func: funcs) {
+        if (func->isBuiltin()) {
+            continue;
+        }
+
+        // 每次只外提一个循环，外提后重建控制流图与循环信息
+        for (;;) {
+            FunctionCFG cfg(func);
+            cfg.computeDominators();
+            LoopInfo loopInfo(&cfg);
+
+            bool transformed = false;
+            for (auto loop: loopInfo.getLoops()) {
+                CountedLoop info;
+                std::vector<Value *> liveIns;
+                if (loop->parent != nullptr || !isParallel(loop, info, liveIns)) {
+                    continue;
+                }
+                parallelize(&cfg, loop, info, liveIns);
+                transformed = true;
+                break;
+            }
+            if (!transformed) {
+                break;
+            }
+            cfg.writeBack();
+        }
+    }
+
+    if (loopFuncs.empty()) {
+        return false;
+    }
+    createDispatcher();
+    return true;
+}
+
+/// @brief 循环是否可以并行执行，并收集循环内使用的循环外变量
+bool LoopParallelization::isParallel(Loop * loop, CountedLoop & info, std::vector<Value *> & liveIns)
+{
+    if (!matchCountedLoop(loop, info) || info.pred != IRInstOperator::IRINST_OP_LT || info.step != 1) {
+        return false;
+    }
+    if (isIntLiteral(info.bound) && info.bound->intVal < minTripCount) {
+        return false;
+    }
+
+    // 循环变量的更新是回边块跳转之前的最后一条指令，迭代内的其它指令看到的都是同一个值
+    std::vector<IRInst *> & latchInsts = info.latch->insts;
+    if (latchInsts.size() < 2 || latchInsts.back()->getOp() != IRInstOperator::IRINST_OP_BR ||
+        latchInsts[latchInsts.size() - 2] != info.updateInst) {
+        return false;
+    }
+    // 并行执行后循环变量没有确定的终值
+    if (isLiveIn(info.exit, info.iv)) {
+        return false;
+    }
+
+    iv = info.iv;
+    defs.clear();
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            Value * def = getInstDef(inst);
+            if (def != nullptr) {
+                defs[def].push_back(inst);
+            }
+        }
+    }
+
+    IRBlock * header = loop->header;
+    std::vector<std::pair<Value *, bool>> pointers;
+    std::unordered_set<Value *> checked{iv};
+    std::unordered_set<Value *> seen;
+    std::vector<Value *> uses;
+    for (auto block: loop->blocks) {
+        if (block == header) {
+            continue;
+        }
+        for (auto inst: block->insts) {
+            IRInstOperator op = inst->getOp();
+            if (op == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                return false;
+            }
+            if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+                int flag = static_cast<AssignIRInst *>(inst)->_flag;
+                if (flag == 2 || flag == 4) {
+                    pointers.emplace_back(inst->getSrc1(), false);
+                }
+                if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                    pointers.emplace_back(inst->getDst(), true);
+                }
+            } else if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_OR &&
+                       static_cast<BinaryIRInst *>(inst)->mode >= 4) {
+                // 二元运算直接访问内存的形式
+                return false;
+            }
+
+            // 循环内定值的变量不能跨迭代传值，也不能在循环之后使用；全局变量不能被写
+            Value * def = getInstDef(inst);
+            if (def == iv) {
+                if (inst != info.updateInst && inst != info.incrementInst) {
+                    return false;
+                }
+            } else if (def != nullptr && checked.insert(def).second &&
+                       (isGlobalValue(symtab, def) || isLiveIn(header, def))) {
+                return false;
+            }
+
+            // 循环外定值的整型标量经全局变量传入，数组与浮点数不能传入
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (use == nullptr || use->isliteral() || defs.count(use) || isGlobalValue(symtab, use) ||
+                    !seen.insert(use).second) {
+                    continue;
+                }
+                if (use->type.type != BasicType::TYPE_INT || use->is_numpy || use->np != nullptr ||
+                    use->is_issavenp()) {
+                    return false;
+                }
+                liveIns.push_back(use);
+            }
+        }
+    }
+
+    std::vector<ParallelAccess> accesses;
+    bool hasStore = false;
+    for (auto & pointer: pointers) {
+        ParallelAccess access;
+        access.isStore = pointer.second;
+        if (!decomposePointer(pointer.first, access)) {
+            return false;
+        }
+        accesses.push_back(access);
+        hasStore |= access.isStore;
+    }
+    if (!hasStore) {
+        return false;
+    }
+
+    // 每个写与自身以及其它所有访问在不同迭代中都不能访问同一地址
+    for (size_t i = 0; i < accesses.size(); ++i) {
+        if (!accesses[i].isStore) {
+            continue;
+        }
+        for (size_t j = 0; j < accesses.size(); ++j) {
+            if (j < i && accesses[j].isStore) {
+                continue;
+            }
+            if (!isIndependent(accesses[i], accesses[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 把变量表示为循环变量的仿射表达式
+/// @details 循环内定值的变量不跨迭代传值，唯一定值的变量沿定值展开，其余的作为迭代内任意取值的项
+bool LoopParallelization::evalIndex(Value * val, ParallelIndex & index, int depth)
+{
+    if (val == nullptr || depth > 32) {
+        return false;
+    }
+    if (val == iv) {
+        index.ivCoef = 1;
+        return true;
+    }
+    if (isIntLiteral(val)) {
+        index.constant = val->intVal;
+        return true;
+    }
+    if (val->type.type != BasicType::TYPE_INT || val->is_numpy || val->np != nullptr) {
+        return false;
+    }
+
+    auto pIter = defs.find(val);
+    if (pIter == defs.end()) {
+        index.invariants[val] = 1;
+        return true;
+    }
+
+    if (pIter->second.size() == 1) {
+        IRInst * def = pIter->second[0];
+        ParallelIndex lhs, rhs;
+        switch (def->getOp()) {
+            case IRInstOperator::IRINST_OP_ASSIGN:
+                if (static_cast<AssignIRInst *>(def)->_flag != 0 || def->Assign_flag == 6) {
+                    break;
+                }
+                return evalIndex(def->getSrc1(), index, depth + 1);
+            case IRInstOperator::IRINST_OP_ADD_I:
+            case IRInstOperator::IRINST_OP_SUB_I:
+                if (!evalIndex(def->getSrc1(), lhs, depth + 1) || !evalIndex(def->getSrc2(), rhs, depth + 1)) {
+                    return false;
+                }
+                index = lhs;
+                addIndex(index, rhs, def->getOp() == IRInstOperator::IRINST_OP_ADD_I ? 1 : -1);
+                return true;
+            case IRInstOperator::IRINST_OP_MULT_I:
+                if (!evalIndex(def->getSrc1(), lhs, depth + 1) || !evalIndex(def->getSrc2(), rhs, depth + 1)) {
+                    return false;
+                }
+                if (isConstantIndex(rhs)) {
+                    index = lhs;
+                    scaleIndex(index, rhs.constant);
+                    return true;
+                }
+                if (isConstantIndex(lhs)) {
+                    index = rhs;
+                    scaleIndex(index, lhs.constant);
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    index.variants[val] = 1;
+    return true;
+}
+
+/// @brief 把指针分解为全局数组与仿射的字节偏移
+bool LoopParallelization::decomposePointer(Value * ptr, ParallelAccess & access)
+{
+    auto pIter = defs.find(ptr);
+    if (pIter == defs.end() || pIter->second.size() != 1) {
+        return false;
+    }
+    IRInst * def = pIter->second[0];
+    if (def->getOp() != IRInstOperator::IRINST_OP_ADD_I || static_cast<BinaryIRInst *>(def)->mode >= 4) {
+        return false;
+    }
+
+    // 局部数组与形参数组不能在线程间共享
+    Value * base = def->getSrc1();
+    if (!base->is_numpy || base->np == nullptr || base->is_saveFParam || !isGlobalValue(symtab, base)) {
+        return false;
+    }
+    access.base = base;
+    return evalIndex(def->getSrc2(), access.offset);
+}
+
+/// @brief 把循环外提为函数，原位置改为调用运行时库
+void LoopParallelization::parallelize(FunctionCFG * cfg, Loop * loop, CountedLoop & info, std::vector<Value *> & liveIns)
+{
+    Function * func = cfg->getFunction();
+    int id = (int) loopFuncs.size();
+    Function * loopFunc = symtab.newFunction(LOOP_FUNC_PREFIX + std::to_string(id), BasicType::TYPE_VOID);
+    loopFuncs.push_back(loopFunc);
+
+    InterCode & code = loopFunc->getInterCode();
+    code.addInst(new LabelIRInst());
+    code.addInst(new EntryIRInst());
+    std::vector<IRInst *> paramCopies;
+    addIntParams(loopFunc, {"begin", "end"}, paramCopies);
+    for (auto inst: paramCopies) {
+        code.addInst(inst);
+    }
+    Value * begin = loopFunc->getParams()[0].val;
+    Value * end = loopFunc->getParams()[1].val;
+
+    // 循环内的临时变量与局部变量在新函数中改名
+    std::unordered_map<Value *, Value *> valueMap;
+    std::vector<Value *> values;
+    for (auto block: loop->blocks) {
+        if (block == loop->header) {
+            continue;
+        }
+        for (auto inst: block->insts) {
+            values.clear();
+            getInstUses(inst, values);
+            values.push_back(getInstDef(inst));
+            for (auto val: values) {
+                if (val == nullptr || val->isliteral() || isGlobalValue(symtab, val) || valueMap.count(val)) {
+                    continue;
+                }
+                valueMap[val] = val->isTemp() ? cloneTempValue(loopFunc, val) : loopFunc->newVarValue(val->type.type);
+            }
+        }
+    }
+
+    // 循环外的变量由调用者存入全局变量，进入函数后读出
+    IRBlock * preheader = ensurePreheader(cfg, loop);
+    std::vector<IRInst *> callCode;
+    for (size_t i = 0; i < liveIns.size(); ++i) {
+        std::string slotName = SLOT_PREFIX + std::to_string(id) + "_" + std::to_string(i);
+        Value * slot = symtab.newVarValue(slotName, BasicType::TYPE_INT);
+        slot->is_externallyUsed = true;
+        callCode.push_back(new AssignIRInst(slot, liveIns[i]));
+        code.addInst(new AssignIRInst(valueMap[liveIns[i]], slot));
+    }
+    Value * newIv = valueMap[info.iv];
+    code.addInst(new AssignIRInst(newIv, begin));
+
+    // 新的循环头按形参给出的区间判断
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    for (auto block: loop->blocks) {
+        labelMap[block->label] = new LabelIRInst();
+    }
+    IRInst * exitLabel = new LabelIRInst();
+    loopFunc->setExitLabel(exitLabel);
+    Value * cond = loopFunc->newTempValue(BasicType::TYPE_BOOL);
+    code.addInst(labelMap[loop->header->label]);
+    code.addInst(new BinaryIRInst(IRInstOperator::IRINST_OP_LT, cond, newIv, end));
+    code.addInst(newBranch(cond, labelMap[info.body->label], exitLabel));
+
+    // 循环体按原来的布局复制，出口只在循环头
+    for (auto block: cfg->getBlocks()) {
+        if (block == loop->header || !loop->contains(block)) {
+            continue;
+        }
+        code.addInst(labelMap[block->label]);
+        for (auto inst: block->insts) {
+            code.addInst(cloneInst(inst, valueMap, labelMap));
+        }
+    }
+    code.addInst(exitLabel);
+    code.addInst(new ExitIRInst());
+
+    // 原循环改为调用运行时库，编号与区间作为实参
+    std::vector<Value *> args{symtab.newConstValue(id), info.iv, info.bound};
+    callCode.push_back(new FuncCallIRInst(PARALLEL_FOR_NAME, args, func->newTempValue(BasicType::TYPE_VOID)));
+    preheader->insts.insert(preheader->insts.end() - 1, callCode.begin(), callCode.end());
+    replaceBranchTarget(preheader->getTerminator(), loop->header->label, info.exit->label);
+    func->setExistFuncCall(true);
+    if (func->getMaxFuncCallArgCnt() < (int) args.size()) {
+        func->setMaxFuncCallArgCnt((int) args.size());
+    }
+
+    std::vector<IRBlock *> blocks = loop->blocks;
+    for (auto block: blocks) {
+        cfg->removeBlock(block);
+    }
+    cfg->buildEdges();
+}
+
+/// @brief 生成按循环编号调用外提函数的分发函数
+void LoopParallelization::createDispatcher()
+{
+    Function * body = symtab.newFunction(PARALLEL_BODY_NAME, BasicType::TYPE_VOID);
+    body->setExternallyUsed(true);
+    InterCode & code = body->getInterCode();
+    code.addInst(new LabelIRInst());
+    code.addInst(new EntryIRInst());
+    std::vector<IRInst *> paramCopies;
+    addIntParams(body, {"id", "begin", "end"}, paramCopies);
+    for (auto inst: paramCopies) {
+        code.addInst(inst);
+    }
+    std::vector<FuncFormalParam> & params = body->getParams();
+    Value * id = params[0].val;
+    std::vector<Value *> range{params[1].val, params[2].val};
+
+    IRInst * exitLabel = new LabelIRInst();
+    body->setExitLabel(exitLabel);
+    for (size_t i = 0; i < loopFuncs.size(); ++i) {
+        Value * cond = body->newTempValue(BasicType::TYPE_BOOL);
+        IRInst * callLabel = new LabelIRInst();
+        IRInst * nextLabel = i + 1 < loopFuncs.size() ? new LabelIRInst() : exitLabel;
+        code.addInst(new BinaryIRInst(IRInstOperator::IRINST_OP_EQ, cond, id, symtab.newConstValue((int32_t) i)));
+        code.addInst(newBranch(cond, callLabel, nextLabel));
+        code.addInst(callLabel);
+        code.addInst(new FuncCallIRInst(loopFuncs[i]->getName(), range, body->newTempValue(BasicType::TYPE_VOID)));
+        code.addInst(new BrIRInst(exitLabel));
+        if (nextLabel != exitLabel) {
+            code.addInst(nextLabel);
+        }
+    }
+    code.addInst(exitLabel);
+    code.addInst(new ExitIRInst());
+
+    body->setExistFuncCall(true);
+    body->setMaxFuncCallArgCnt((int) range.size());
+}
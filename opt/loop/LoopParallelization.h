@@ -0,0 +1,102 @@
+/**
+ * @file LoopParallelization.h
+ * @brief 循环并行化：没有跨迭代依赖的最外层计数循环外提为单独的函数，由运行时库把迭代区间分给多个线程执行
+ *
+ * 依赖测试基于数组下标线性化后以字节为单位的仿射偏移，只处理全局数组上的访问。
+ * 生成的代码中没有函数指针，外提的循环函数由统一的分发函数按循环编号调用，
+ * 运行时库runtime/sysy_parallel.c在各个线程中回调分发函数。循环内使用的整型变量经全局变量传入。
+ */
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "LoopInfo.h"
+#include "SymbolTable.h"
+
+/// @brief 以字节为单位的数组偏移：ivCoef * iv + constant + Σ invariants + Σ variants
+struct ParallelIndex {
+    /// @brief 循环变量的系数
+    long long ivCoef = 0;
+
+    /// @brief 常数项
+    long long constant = 0;
+
+    /// @brief 循环不变量及其系数
+    std::map<Value *, long long> invariants;
+
+    /// @brief 迭代内取值任意的变量（内层循环变量、读出的数组元素等）及其系数
+    std::map<Value *, long long> variants;
+};
+
+/// @brief 循环内的一次全局数组访问
+struct ParallelAccess {
+    /// @brief 全局数组
+    Value * base = nullptr;
+
+    /// @brief 字节偏移
+    ParallelIndex offset;
+
+    /// @brief 是否是写
+    bool isStore = false;
+};
+
+/// @brief 计数循环的并行化
+class LoopParallelization {
+
+public:
+    /// @brief 运行时库提供的并行执行入口：void __sysy_parallel_for(int id, int begin, int end)
+    static constexpr const char * PARALLEL_FOR_NAME = "__sysy_parallel_for";
+
+    /// @brief 运行时库在各个线程中回调的分发函数：void __sysy_parallel_body(int id, int begin, int end)
+    static constexpr const char * PARALLEL_BODY_NAME = "__sysy_parallel_body";
+
+    /// @brief 构造函数
+    /// @param _symtab 符号表
+    /// @param _minTripCount 边界为常量时并行化所需的最小迭代次数
+    LoopParallelization(SymbolTable & _symtab, int _minTripCount = 1024);
+
+    /// @brief 并行化所有函数中可以并行的最外层循环，并生成分发函数
+    /// @return true：有循环被并行化
+    bool run();
+
+private:
+    /// @brief 循环是否可以并行执行，并收集循环内使用的循环外变量
+    /// @param loop 最外层循环
+    /// @param info 计数循环信息
+    /// @param liveIns 循环内使用、循环外定值的变量，按第一次出现的顺序
+    /// @return true：不存在跨迭代的依赖
+    bool isParallel(Loop * loop, CountedLoop & info, std::vector<Value *> & liveIns);
+
+    /// @brief 把变量表示为循环变量的仿射表达式
+    bool evalIndex(Value * val, ParallelIndex & index, int depth = 0);
+
+    /// @brief 把指针分解为全局数组与仿射的字节偏移
+    bool decomposePointer(Value * ptr, ParallelAccess & access);
+
+    /// @brief 把循环外提为函数，原位置改为调用运行时库
+    /// @param cfg 循环所在函数的控制流图
+    /// @param loop 循环
+    /// @param info 计数循环信息
+    /// @param liveIns 循环内使用、循环外定值的变量
+    void parallelize(FunctionCFG * cfg, Loop * loop, CountedLoop & info, std::vector<Value *> & liveIns);
+
+    /// @brief 生成按循环编号调用外提函数的分发函数
+    void createDispatcher();
+
+    /// @brief 符号表
+    SymbolTable & symtab;
+
+    /// @brief 边界为常量时并行化所需的最小迭代次数
+    int minTripCount;
+
+    /// @brief 外提的循环函数，下标为循环编号
+    std::vector<Function *> loopFuncs;
+
+    /// @brief 当前循环的循环变量
+    Value * iv = nullptr;
+
+    /// @brief 当前循环内每个变量的定值指令
+    std::unordered_map<Value *, std::vector<IRInst *>> defs;
+};
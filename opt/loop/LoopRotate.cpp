@@ -0,0 +1,137 @@
+/**
+ * @file LoopRotate.cpp
+ * @brief 循环旋转：把先判断后执行的while循环变换为带入口保护的do-while形式
+ */
+#include "LoopRotate.h"
+
+/// @brief 允许复制的循环头指令数上限
+static const int MAX_ROTATE_HEADER_INSTS = 8;
+
+/// @brief 构造函数
+/// @param _func 函数
+LoopRotate::LoopRotate(Function * _func) : func(_func)
+{}
+
+/// @brief 对函数内所有可旋转的循环进行旋转
+/// @return true：函数的IR被修改
+bool LoopRotate::run()
+{
+    bool changed = false;
+
+    // 每次只旋转一个循环，旋转后重建控制流图与循环信息
+    for (;;) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool rotated = false;
+        for (auto loop: loopInfo.getLoops()) {
+            if (isRotated(loop)) {
+                continue;
+            }
+            if (rotateLoop(&cfg, loop)) {
+                rotated = true;
+                break;
+            }
+        }
+        if (!rotated) {
+            break;
+        }
+
+        cfg.writeBack();
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 旋转一个循环
+/// @return true：控制流图被修改
+bool LoopRotate::rotateLoop(FunctionCFG * cfg, Loop * loop)
+{
+    IRBlock * header = loop->header;
+    IRInst * term = header->getTerminator();
+    if (header == cfg->getEntry() || header->label == nullptr || term == nullptr ||
+        term->getOp() != IRInstOperator::IRINST_OP_BC || (int) header->insts.size() > MAX_ROTATE_HEADER_INSTS) {
+        return false;
+    }
+
+    // 循环头的条件跳转一个出口留在循环内，另一个离开循环
+    std::vector<IRInst *> targets;
+    getBranchTargets(term, targets);
+    IRBlock * trueBlock = cfg->getBlockByLabel(targets[0]);
+    IRBlock * falseBlock = cfg->getBlockByLabel(targets[1]);
+    if (trueBlock == nullptr || falseBlock == nullptr || loop->contains(trueBlock) == loop->contains(falseBlock)) {
+        return false;
+    }
+    IRBlock * body = loop->contains(trueBlock) ? trueBlock : falseBlock;
+    if (body == header) {
+        return false;
+    }
+
+    // 循环头的临时变量只能在循环头内使用，否则删除循环头后其它块读不到
+    std::unordered_map<Value *, IRBlock *> blockTemps;
+    collectBlockLocalTemps(cfg, blockTemps);
+    std::unordered_set<Value *> temps;
+    for (auto inst: header->insts) {
+        Value * def = getInstDef(inst);
+        if (def == nullptr || !def->isTemp()) {
+            continue;
+        }
+        auto pIter = blockTemps.find(def);
+        if (pIter == blockTemps.end() || pIter->second != header) {
+            return false;
+        }
+        temps.insert(def);
+    }
+
+    // 循环入口与每条回边都各自执行一次循环条件
+    IRBlock * preheader = ensurePreheader(cfg, loop);
+    appendHeaderCopy(preheader, header, temps);
+    for (auto latch: loop->latches) {
+        IRInst * latchTerm = latch->getTerminator();
+        if (latchTerm != nullptr && latchTerm->getOp() == IRInstOperator::IRINST_OP_BR) {
+            visited.insert(appendHeaderCopy(latch, header, temps));
+        } else {
+            // 条件跳转的回边先拆出一个新块
+            IRBlock * split = cfg->createBlock(latch);
+            split->insts.push_back(new BrIRInst(header->label));
+            replaceBranchTarget(latchTerm, header->label, split->label);
+            visited.insert(appendHeaderCopy(split, header, temps));
+        }
+    }
+
+    cfg->removeBlock(header);
+    cfg->buildEdges();
+    return true;
+}
+
+/// @brief 循环是否已经旋转过，旋转后的循环每条回边都来自复制的循环条件
+/// @return true：已旋转
+bool LoopRotate::isRotated(Loop * loop)
+{
+    for (auto latch: loop->latches) {
+        if (!visited.count(latch->getTerminator())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 把循环头的指令复制到block末尾，替换其中跳到循环头的br
+/// @param temps 循环头内部的临时变量，每个副本需要重命名
+/// @return 复制的条件跳转
+IRInst * LoopRotate::appendHeaderCopy(IRBlock * block, IRBlock * header, std::unordered_set<Value *> & temps)
+{
+    std::unordered_map<Value *, Value *> valueMap;
+    for (auto temp: temps) {
+        valueMap[temp] = cloneTempValue(func, temp);
+    }
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+
+    block->insts.pop_back();
+    for (auto inst: header->insts) {
+        block->insts.push_back(cloneInst(inst, valueMap, labelMap));
+    }
+    return block->insts.back();
+}
@@ -0,0 +1,44 @@
+/**
+ * @file LoopRotate.h
+ * @brief 循环旋转：把先判断后执行的while循环变换为带入口保护的do-while形式
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "LoopInfo.h"
+
+/// @brief 循环旋转，循环条件复制到循环入口与回边块，每次迭代只剩一个条件跳转
+class LoopRotate {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    LoopRotate(Function * _func);
+
+    /// @brief 对函数内所有可旋转的循环进行旋转
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 旋转一个循环
+    /// @return true：控制流图被修改
+    bool rotateLoop(FunctionCFG * cfg, Loop * loop);
+
+    /// @brief 循环是否已经旋转过，旋转后的循环每条回边都来自复制的循环条件
+    /// @return true：已旋转
+    bool isRotated(Loop * loop);
+
+    /// @brief 把循环头的指令复制到block末尾，替换其中跳到循环头的br
+    /// @param temps 循环头内部的临时变量，每个副本需要重命名
+    /// @return 复制的条件跳转
+    IRInst * appendHeaderCopy(IRBlock * block, IRBlock * header, std::unordered_set<Value *> & temps);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 已旋转循环回边块末尾复制的条件跳转，按回边而不是循环头识别已旋转的循环，
+    /// 外层循环旋转后的循环头可能是内层循环头，不能因此跳过内层循环
+    std::unordered_set<IRInst *> visited;
+};
@@ -0,0 +1,503 @@
+/**
+ * @file LoopScalarReplacement.cpp
+ * @brief 跨迭代的数组标量替换：循环内a[i-1]、a[i]、a[i+1]这类相邻迭代读取同一元素的访问，
+ * 只保留最前面的一次读，其余元素通过在迭代间轮转的临时变量传递
+ *
+ * 循环体按执行顺序符号执行一遍，把地址表示为迭代开始时各变量的仿射表达式。每次迭代增加固定值的变量是循环变量，
+ * 地址只差常量偏移的读属于同一组；组内偏移c的元素在下一次迭代中的地址正好是偏移c-d，其中d是地址每次迭代的增量。
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "LoopScalarReplacement.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 仿射表达式中系数与常量的绝对值上限，超过时放弃以免溢出
+static const int64_t MAX_LINEAR_VALUE = 1 << 24;
+
+/// @brief 常量表达式
+static LinearExpr constantExpr(int64_t value)
+{
+    LinearExpr expr;
+    expr.offset = value;
+    return expr;
+}
+
+/// @brief 不能表示为仿射表达式
+static LinearExpr unknownExpr()
+{
+    LinearExpr expr;
+    expr.known = false;
+    return expr;
+}
+
+/// @brief 是否是常量表达式
+static bool isConstantExpr(const LinearExpr & expr)
+{
+    return expr.known && expr.base == nullptr && expr.terms.empty();
+}
+
+/// @brief 检查系数与常量是否超出上限，并删除系数为0的项
+static LinearExpr normalize(LinearExpr expr)
+{
+    if (!expr.known || std::abs(expr.offset) > MAX_LINEAR_VALUE) {
+        return unknownExpr();
+    }
+    for (auto pIter = expr.terms.begin(); pIter != expr.terms.end();) {
+        if (std::abs(pIter->second) > MAX_LINEAR_VALUE) {
+            return unknownExpr();
+        }
+        pIter = pIter->second == 0 ? expr.terms.erase(pIter) : std::next(pIter);
+    }
+    return expr;
+}
+
+/// @brief 两个表达式相加，两个地址相加不是仿射表达式
+static LinearExpr addExpr(const LinearExpr & lhs, const LinearExpr & rhs)
+{
+    if (!lhs.known || !rhs.known || (lhs.base != nullptr && rhs.base != nullptr)) {
+        return unknownExpr();
+    }
+    LinearExpr expr = lhs;
+    expr.base = lhs.base != nullptr ? lhs.base : rhs.base;
+    for (auto & term: rhs.terms) {
+        expr.terms[term.first] += term.second;
+    }
+    expr.offset += rhs.offset;
+    return normalize(expr);
+}
+
+/// @brief 表达式乘以常量，地址只能乘以1
+static LinearExpr scaleExpr(const LinearExpr & expr, int64_t factor)
+{
+    if (!expr.known || (expr.base != nullptr && factor != 1) || std::abs(factor) > MAX_LINEAR_VALUE) {
+        return unknownExpr();
+    }
+    LinearExpr result = expr;
+    for (auto & term: result.terms) {
+        term.second *= factor;
+    }
+    result.offset *= factor;
+    return normalize(result);
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _callGraph 调用图，用于判断循环内的函数调用是否写数组
+/// @param _maxRegisters 循环内可同时驻留寄存器的整型变量个数，与后端分配的s1~s11一致
+LoopScalarReplacement::LoopScalarReplacement(Function * _func, CallGraph & _callGraph, int _maxRegisters)
+    : func(_func), callGraph(_callGraph), maxRegisters(_maxRegisters), aa(_func)
+{}
+
+/// @brief 对函数内的最内层循环进行跨迭代的标量替换
+/// @return true：函数的IR被修改
+bool LoopScalarReplacement::run()
+{
+    FunctionCFG cfg(func);
+    cfg.computeDominators();
+    LoopInfo loopInfo(&cfg);
+
+    // 后端把跨循环的变量分配到整个最外层循环上，轮转临时变量会占用同一嵌套内所有内层循环的寄存器
+    std::vector<Loop *> innermost;
+    std::unordered_map<Loop *, int> pressures;
+    auto getRoot = [](Loop * loop) {
+        while (loop->parent != nullptr) {
+            loop = loop->parent;
+        }
+        return loop;
+    };
+    for (auto loop: loopInfo.getLoops()) {
+        if (loop->isInnermost() && loop->header->isReachable()) {
+            innermost.push_back(loop);
+            int & pressure = pressures[getRoot(loop)];
+            pressure = std::max(pressure, estimatePressure(loop->blocks));
+        }
+    }
+
+    // 最内层循环互不相交，在同一个控制流图上逐个变换
+    bool changed = false;
+    for (auto loop: innermost) {
+        changed |= replaceLoop(&cfg, loop, pressures[getRoot(loop)]);
+    }
+    if (changed) {
+        // 被替换的读原来的地址计算不再使用
+        removeDeadTempDefs(&cfg);
+        cfg.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 循环的基本块是否从循环头到回边块依次相连，且只有回边块退出循环
+/// @param loop 循环
+/// @param chain 按执行顺序排列的基本块
+bool LoopScalarReplacement::getChain(Loop * loop, std::vector<IRBlock *> & chain)
+{
+    if (loop->latches.size() != 1) {
+        return false;
+    }
+    IRBlock * latch = loop->latches[0];
+    IRBlock * block = loop->header;
+    chain.push_back(block);
+    while (block != latch) {
+        if (block->succs.size() != 1) {
+            return false;
+        }
+        block = block->succs[0];
+        if (block == loop->header || !loop->contains(block) || block->preds.size() != 1) {
+            return false;
+        }
+        chain.push_back(block);
+    }
+
+    // 循环体每次迭代都完整执行，preheader中提前读入的元素第一次迭代同样会读取
+    IRInst * terminator = latch->getTerminator();
+    return chain.size() == loop->blocks.size() && latch->succs.size() == 2 && terminator != nullptr &&
+           terminator->getOp() == IRInstOperator::IRINST_OP_BC;
+}
+
+/// @brief 估计循环体需要的寄存器数：跨基本块或跨迭代的变量个数，加上块内临时变量同时活跃的最大个数
+int LoopScalarReplacement::estimatePressure(const std::vector<IRBlock *> & blocks)
+{
+    auto isRegisterCandidate = [](Value * val) {
+        return val != nullptr && isScalarVar(val) && !symtab.findSymbolValue(val) &&
+               (val->type.type == BasicType::TYPE_INT || val->type.type == BasicType::TYPE_BOOL);
+    };
+
+    // 只在一个基本块内先定值后使用的临时变量记录块内区间，其余变量在整个循环内占用寄存器
+    std::unordered_map<Value *, IRBlock *> blockOf;
+    std::unordered_set<Value *> spanning;
+    std::vector<Value *> uses;
+    for (auto block: blocks) {
+        for (auto inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (isRegisterCandidate(use) && (!use->isTemp() || blockOf[use] != block)) {
+                    spanning.insert(use);
+                }
+            }
+            Value * def = getInstDef(inst);
+            if (isRegisterCandidate(def)) {
+                if (!def->isTemp() || (blockOf.count(def) && blockOf[def] != block)) {
+                    spanning.insert(def);
+                }
+                blockOf[def] = block;
+            }
+        }
+    }
+
+    int peak = 0;
+    for (auto block: blocks) {
+        std::unordered_map<Value *, size_t> lastUse;
+        for (size_t i = 0; i < block->insts.size(); ++i) {
+            uses.clear();
+            getInstUses(block->insts[i], uses);
+            for (auto use: uses) {
+                lastUse[use] = i;
+            }
+        }
+        int live = 0;
+        std::vector<int> ends(block->insts.size() + 1, 0);
+        for (size_t i = 0; i < block->insts.size(); ++i) {
+            live -= ends[i];
+            Value * def = getInstDef(block->insts[i]);
+            if (isRegisterCandidate(def) && !spanning.count(def) && lastUse.count(def) && lastUse[def] > i) {
+                ++live;
+                ++ends[lastUse[def] + 1];
+            }
+            peak = std::max(peak, live);
+        }
+    }
+    return (int) spanning.size() + peak;
+}
+
+/// @brief 变量的编号，用于仿射表达式的项
+int LoopScalarReplacement::leafIndex(Value * val)
+{
+    auto pIter = leafIndices.find(val);
+    if (pIter != leafIndices.end()) {
+        return pIter->second;
+    }
+    int index = (int) leaves.size();
+    leaves.push_back(val);
+    leafIndices[val] = index;
+    return index;
+}
+
+/// @brief 变量在迭代内当前位置的仿射表达式
+LinearExpr LoopScalarReplacement::lookup(Loop * loop, Value * val)
+{
+    if (isIntLiteral(val)) {
+        return constantExpr(val->intVal);
+    }
+    auto pIter = current.find(val);
+    if (pIter != current.end()) {
+        return pIter->second;
+    }
+
+    LinearExpr expr;
+    if (loopDefs.count(val)) {
+        // 上一次迭代的值，迭代结束后再检查是否是循环变量
+        if (!isScalarVar(val) || val->type.type != BasicType::TYPE_INT) {
+            return unknownExpr();
+        }
+        carried.insert(val);
+        expr.terms[leafIndex(val)] = 1;
+    } else if (AliasAnalysis::isArrayObject(val) || val->is_issavenp()) {
+        expr.base = val;
+    } else if (val->type.type == BasicType::TYPE_INT && !val->is_numpy && isLoopInvariant(loop, val)) {
+        expr.terms[leafIndex(val)] = 1;
+    } else {
+        return unknownExpr();
+    }
+    return expr;
+}
+
+/// @brief 对一个循环进行替换
+/// @param cfg 控制流图
+/// @param loop 最内层循环
+/// @param pressure 所在最外层循环需要的寄存器数，新增的轮转临时变量计入其中
+/// @return true：循环被修改
+bool LoopScalarReplacement::replaceLoop(FunctionCFG * cfg, Loop * loop, int & pressure)
+{
+    std::vector<IRBlock *> chain;
+    if (!getChain(loop, chain)) {
+        return false;
+    }
+
+    loopDefs.clear();
+    current.clear();
+    carried.clear();
+    for (auto block: chain) {
+        for (auto inst: block->insts) {
+            if (getInstDef(inst) != nullptr) {
+                loopDefs.insert(getInstDef(inst));
+            }
+        }
+    }
+
+    // 按执行顺序求出每个定值与数组读地址的仿射表达式
+    std::vector<ArrayLoad> loads;
+    for (auto block: chain) {
+        for (auto inst: block->insts) {
+            LinearExpr result = unknownExpr();
+            IRInstOperator op = inst->getOp();
+            if ((op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_SUB_I ||
+                 op == IRInstOperator::IRINST_OP_MULT_I) &&
+                static_cast<BinaryIRInst *>(inst)->mode <= 3) {
+                BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+                LinearExpr lhs = lookup(loop, inst->getSrc1());
+                LinearExpr rhs = binary->mode == 2 || binary->mode == 3 ? constantExpr(binary->src)
+                                                                        : lookup(loop, inst->getSrc2());
+                if (op == IRInstOperator::IRINST_OP_ADD_I) {
+                    result = addExpr(lhs, rhs);
+                } else if (op == IRInstOperator::IRINST_OP_SUB_I) {
+                    result = addExpr(lhs, scaleExpr(rhs, -1));
+                } else if (isConstantExpr(lhs)) {
+                    result = scaleExpr(rhs, lhs.offset);
+                } else if (isConstantExpr(rhs)) {
+                    result = scaleExpr(lhs, rhs.offset);
+                }
+            } else if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+                int flag = static_cast<AssignIRInst *>(inst)->_flag;
+                Value * src = inst->getSrc()[0];
+                if (flag == 0 && inst->Assign_flag != 6) {
+                    result = lookup(loop, src);
+                } else if (flag == 2 && !AliasAnalysis::isArrayObject(src)) {
+                    LinearExpr addr = lookup(loop, src);
+                    if (addr.known && addr.base != nullptr) {
+                        loads.push_back({inst, block, addr});
+                    }
+                }
+            }
+            if (getInstDef(inst) != nullptr) {
+                current[getInstDef(inst)] = result;
+            }
+        }
+    }
+
+    // 迭代结束时等于迭代开始时的值加常量的变量是循环变量
+    std::unordered_map<int, int64_t> steps;
+    for (auto val: carried) {
+        const LinearExpr & expr = current[val];
+        if (expr.known && expr.base == nullptr && expr.terms.size() == 1 &&
+            expr.terms.begin()->first == leafIndex(val) && expr.terms.begin()->second == 1) {
+            steps[leafIndex(val)] = expr.offset;
+        }
+    }
+
+    // 地址每次迭代的增量，依赖非循环变量的地址无法确定
+    auto getShift = [&](const LinearExpr & addr, int64_t & shift) {
+        shift = 0;
+        for (auto & term: addr.terms) {
+            if (carried.count(leaves[term.first])) {
+                auto pIter = steps.find(term.first);
+                if (pIter == steps.end()) {
+                    return false;
+                }
+                shift += term.second * pIter->second;
+            }
+        }
+        return shift != 0 && std::abs(shift) <= MAX_LINEAR_VALUE;
+    };
+
+    // 基地址与变量项相同的读分为一组，组内只差常量偏移
+    std::vector<std::vector<ArrayLoad *>> groups;
+    std::vector<int64_t> shifts;
+    for (auto & load: loads) {
+        int64_t shift;
+        if (!getShift(load.addr, shift)) {
+            continue;
+        }
+        auto pIter = std::find_if(groups.begin(), groups.end(), [&](const std::vector<ArrayLoad *> & group) {
+            return group[0]->addr.base == load.addr.base && group[0]->addr.terms == load.addr.terms;
+        });
+        if (pIter == groups.end()) {
+            groups.push_back({&load});
+            shifts.push_back(shift);
+        } else {
+            pIter->push_back(&load);
+        }
+    }
+
+    // 轮转临时变量在整个循环内活跃，寄存器不足时其它变量会被挤到栈中，得不偿失
+    int budget = maxRegisters - pressure;
+    IRBlock * preheader = nullptr;
+    IRBlock * latch = chain.back();
+    bool changed = false;
+    for (size_t g = 0; g < groups.size(); ++g) {
+        std::vector<ArrayLoad *> & group = groups[g];
+        int64_t shift = shifts[g];
+
+        // 循环内不能有写该数组的指令
+        MemoryLocation loc = aa.getLocation(group[0]->addr.base);
+        loc.constOffset = false;
+        bool written = false;
+        for (auto block: chain) {
+            for (auto inst: block->insts) {
+                if (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL ? callGraph.mayWrite(inst, aa, loc)
+                                                                         : aa.mayWrite(inst, loc)) {
+                    written = true;
+                }
+            }
+        }
+        if (written) {
+            continue;
+        }
+
+        // 偏移c的元素在下一次迭代中是偏移c-shift的元素，存在偏移c+shift的读时偏移c的值可由上一次迭代传递
+        std::map<int64_t, std::vector<ArrayLoad *>> slots;
+        for (auto load: group) {
+            slots[load->addr.offset].push_back(load);
+        }
+        int count = 0;
+        int carriedCount = 0;
+        for (auto & slot: slots) {
+            if (slots.count(slot.first + shift)) {
+                ++carriedCount;
+                ++count;
+            } else if (slots.count(slot.first - shift)) {
+                ++count;
+            }
+        }
+        if (carriedCount == 0 || count > budget) {
+            continue;
+        }
+        budget -= count;
+        pressure += count;
+        if (preheader == nullptr) {
+            preheader = ensurePreheader(cfg, loop);
+        }
+
+        auto replaceLoad = [&](ArrayLoad * load, Value * val) {
+            std::vector<IRInst *> & insts = load->block->insts;
+            *std::find(insts.begin(), insts.end(), load->inst) = new AssignIRInst(load->inst->getDst(), val, 0);
+        };
+        std::map<int64_t, Value *> regs;
+        std::map<int64_t, Value *> captures;
+        for (auto & slot: slots) {
+            ArrayLoad * first = slot.second[0];
+            if (slots.count(slot.first + shift)) {
+                // 轮转临时变量，第一次迭代的值在preheader中读入
+                Value * reg = cloneTempValue(func, first->inst->getDst());
+                regs[slot.first] = reg;
+                emitLoad(preheader, first->addr, first->inst->getSrc()[0], reg);
+                for (auto load: slot.second) {
+                    replaceLoad(load, reg);
+                }
+            } else if (slots.count(slot.first - shift)) {
+                // 最前面的元素仍然读内存，读出的值复制一份供迭代末尾轮转
+                Value * capture = cloneTempValue(func, first->inst->getDst());
+                captures[slot.first] = capture;
+                std::vector<IRInst *> & insts = first->block->insts;
+                auto pIter = std::find(insts.begin(), insts.end(), first->inst);
+                insts.insert(pIter + 1, new AssignIRInst(capture, first->inst->getDst(), 0));
+                for (size_t i = 1; i < slot.second.size(); ++i) {
+                    replaceLoad(slot.second[i], capture);
+                }
+            }
+        }
+
+        // 迭代末尾轮转，离最前面元素越远的临时变量越先更新
+        std::vector<std::pair<int, int64_t>> order;
+        for (auto & reg: regs) {
+            int distance = 0;
+            for (int64_t offset = reg.first; regs.count(offset); offset += shift) {
+                ++distance;
+            }
+            order.emplace_back(-distance, reg.first);
+        }
+        std::sort(order.begin(), order.end());
+        for (auto & item: order) {
+            int64_t next = item.second + shift;
+            Value * src = regs.count(next) ? regs[next] : captures[next];
+            latch->insts.insert(latch->insts.end() - 1, new AssignIRInst(regs[item.second], src, 0));
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+/// @brief 在preheader中按仿射表达式计算地址并读入临时变量
+/// @param preheader 循环的preheader
+/// @param addr 迭代开始时的地址
+/// @param ptr 循环内的地址变量，新地址变量按它的属性创建
+/// @param dst 读入的临时变量
+void LoopScalarReplacement::emitLoad(IRBlock * preheader, const LinearExpr & addr, Value * ptr, Value * dst)
+{
+    auto append = [preheader](IRInst * inst) {
+        preheader->insts.insert(preheader->insts.end() - 1, inst);
+    };
+
+    Value * index = nullptr;
+    for (auto & term: addr.terms) {
+        Value * val = leaves[term.first];
+        if (term.second != 1) {
+            Value * scaled = func->newTempValue(BasicType::TYPE_INT);
+            append(new BinaryIRInst(IRInstOperator::IRINST_OP_MULT_I,
+                                    scaled,
+                                    val,
+                                    symtab.newConstValue((int) term.second)));
+            val = scaled;
+        }
+        if (index != nullptr) {
+            Value * sum = func->newTempValue(BasicType::TYPE_INT);
+            append(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, sum, index, val));
+            val = sum;
+        }
+        index = val;
+    }
+    if (index == nullptr) {
+        index = symtab.newConstValue((int) addr.offset);
+    } else if (addr.offset != 0) {
+        Value * sum = func->newTempValue(BasicType::TYPE_INT);
+        append(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, sum, index, symtab.newConstValue((int) addr.offset)));
+        index = sum;
+    }
+
+    Value * elementPtr = cloneTempValue(func, ptr);
+    append(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I, elementPtr, addr.base, index));
+    append(new AssignIRInst(dst, elementPtr, 2));
+}
@@ -0,0 +1,109 @@
+/**
+ * @file LoopScalarReplacement.h
+ * @brief 跨迭代的数组标量替换：循环内a[i-1]、a[i]、a[i+1]这类相邻迭代读取同一元素的访问，
+ * 只保留最前面的一次读，其余元素通过在迭代间轮转的临时变量传递
+ */
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AliasAnalysis.h"
+#include "CallGraph.h"
+#include "LoopInfo.h"
+
+/// @brief 迭代开始时变量值的仿射表达式：基地址 + Σ系数×变量 + 常量，地址以字节为单位
+struct LinearExpr {
+    /// @brief 是否可以表示为仿射表达式
+    bool known = true;
+
+    /// @brief 数组或数组地址，为空时是整数表达式
+    Value * base = nullptr;
+
+    /// @brief 变量编号到系数，变量是循环不变量或循环变量在迭代开始时的值
+    std::map<int, int64_t> terms;
+
+    /// @brief 常量部分
+    int64_t offset = 0;
+};
+
+/// @brief 循环内的数组读
+struct ArrayLoad {
+    /// @brief 读指令
+    IRInst * inst;
+
+    /// @brief 所在的基本块
+    IRBlock * block;
+
+    /// @brief 地址的仿射表达式
+    LinearExpr addr;
+};
+
+/// @brief 循环内跨迭代的数组标量替换
+class LoopScalarReplacement {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _callGraph 调用图，用于判断循环内的函数调用是否写数组
+    /// @param _maxRegisters 循环内可同时驻留寄存器的整型变量个数，与后端分配的s1~s11一致
+    LoopScalarReplacement(Function * _func, CallGraph & _callGraph, int _maxRegisters = 11);
+
+    /// @brief 对函数内的最内层循环进行跨迭代的标量替换
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 循环的基本块是否从循环头到回边块依次相连，且只有回边块退出循环
+    /// @param loop 循环
+    /// @param chain 按执行顺序排列的基本块
+    bool getChain(Loop * loop, std::vector<IRBlock *> & chain);
+
+    /// @brief 对一个循环进行替换
+    /// @param cfg 控制流图
+    /// @param loop 最内层循环
+    /// @param pressure 所在最外层循环需要的寄存器数，新增的轮转临时变量计入其中
+    /// @return true：循环被修改
+    bool replaceLoop(FunctionCFG * cfg, Loop * loop, int & pressure);
+
+    /// @brief 估计循环体需要的寄存器数：跨基本块或跨迭代的变量个数，加上块内临时变量同时活跃的最大个数
+    int estimatePressure(const std::vector<IRBlock *> & blocks);
+
+    /// @brief 变量在迭代内当前位置的仿射表达式
+    LinearExpr lookup(Loop * loop, Value * val);
+
+    /// @brief 变量的编号，用于仿射表达式的项
+    int leafIndex(Value * val);
+
+    /// @brief 在preheader中按仿射表达式计算地址并读入临时变量
+    void emitLoad(IRBlock * preheader, const LinearExpr & addr, Value * ptr, Value * dst);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 调用图
+    CallGraph & callGraph;
+
+    /// @brief 循环内可同时驻留寄存器的整型变量个数
+    int maxRegisters;
+
+    /// @brief 别名分析
+    AliasAnalysis aa;
+
+    /// @brief 当前循环内有定值的变量
+    std::unordered_set<Value *> loopDefs;
+
+    /// @brief 迭代内已定值的变量的当前值
+    std::unordered_map<Value *, LinearExpr> current;
+
+    /// @brief 在迭代开始前定值、迭代内被使用的循环内变量
+    std::unordered_set<Value *> carried;
+
+    /// @brief 仿射表达式中的变量
+    std::vector<Value *> leaves;
+
+    /// @brief 变量到编号
+    std::unordered_map<Value *, int> leafIndices;
+};
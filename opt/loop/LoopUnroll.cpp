@@ -0,0 +1,395 @@
+/**
+ * @file LoopUnroll.cpp
+ * @brief 计数循环展开：迭代次数为常数的小循环完全展开，其余循环按展开因子展开，原循环保留用于剩余迭代
+ */
+#include <climits>
+
+#include "LoopUnroll.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 完全展开允许的最大迭代次数
+static const int MAX_FULL_UNROLL_TRIPS = 16;
+
+/// @brief 完全展开后循环体指令总数的上限
+static const int MAX_FULL_UNROLL_INSTS = 300;
+
+/// @brief 部分展开后循环体指令总数的上限
+static const int MAX_PARTIAL_UNROLL_INSTS = 200;
+
+/// @brief 查找初值时沿前驱向上的最大块数
+static const int MAX_INIT_SEARCH_BLOCKS = 8;
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _factor 部分展开时的展开因子
+LoopUnroll::LoopUnroll(Function * _func, int _factor) : func(_func), factor(_factor)
+{}
+
+/// @brief 对函数内所有最内层计数循环进行展开
+/// @return true：函数的IR被修改
+bool LoopUnroll::run()
+{
+    bool changed = false;
+
+    // 每次只变换一个循环，变换后重建控制流图与循环信息
+    for (;;) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool unrolled = false;
+        for (auto loop: loopInfo.getLoops()) {
+            if (!loop->isInnermost() || !visited.insert(loop->header->label).second) {
+                continue;
+            }
+            if (unrollLoop(&cfg, loop)) {
+                unrolled = true;
+                break;
+            }
+        }
+        if (!unrolled) {
+            break;
+        }
+
+        cfg.writeBack();
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 展开一个循环
+/// @return true：控制流图被修改
+bool LoopUnroll::unrollLoop(FunctionCFG * cfg, Loop * loop)
+{
+    CountedLoop info;
+    if (!matchCountedLoop(loop, info)) {
+        return false;
+    }
+
+    int bodySize = 0;
+    for (auto block: loop->blocks) {
+        if (block->label == nullptr) {
+            return false;
+        }
+        if (block != loop->header) {
+            bodySize += (int) block->insts.size() - 1;
+        }
+    }
+    if (bodySize <= 0) {
+        bodySize = 1;
+    }
+
+    std::unordered_set<Value *> temps;
+    collectLocalTemps(cfg, loop, temps);
+
+    // 循环外唯一的前驱，用于查找循环变量的初值
+    IRBlock * entering = nullptr;
+    int enteringCount = 0;
+    for (auto pred: loop->header->preds) {
+        if (!loop->contains(pred)) {
+            entering = pred;
+            enteringCount++;
+        }
+    }
+
+    // 比较结果在循环外被使用时，删除循环头会改变语义
+    bool cmpUsedOutside = false;
+    std::vector<Value *> uses;
+    for (auto block: cfg->getBlocks()) {
+        if (block == loop->header) {
+            continue;
+        }
+        for (auto inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (use == info.cmpInst->getDst()) {
+                    cmpUsedOutside = true;
+                }
+            }
+        }
+    }
+
+    int init = 0, bound = 0;
+    if (enteringCount == 1 && !cmpUsedOutside && getBoundValue(cfg, info.bound, bound) &&
+        getInitValue(entering, info.iv, init)) {
+        // 模拟循环变量得到迭代次数
+        int tripCount = 0;
+        long long iv = init;
+        while (tripCount <= MAX_FULL_UNROLL_TRIPS && evalLoopCompare(info.pred, iv, bound)) {
+            tripCount++;
+            iv += info.step;
+        }
+        if (tripCount <= MAX_FULL_UNROLL_TRIPS) {
+            if (tripCount * bodySize > MAX_FULL_UNROLL_INSTS) {
+                return false;
+            }
+            fullUnroll(cfg, loop, info, ensurePreheader(cfg, loop), tripCount, temps);
+            return true;
+        }
+    }
+
+    // 部分展开要求循环变量单调趋近边界
+    bool monotone = false;
+    switch (info.pred) {
+        case IRInstOperator::IRINST_OP_LT:
+        case IRInstOperator::IRINST_OP_LE:
+            monotone = info.step > 0;
+            break;
+        case IRInstOperator::IRINST_OP_BT:
+        case IRInstOperator::IRINST_OP_BE:
+            monotone = info.step < 0;
+            break;
+        default:
+            break;
+    }
+    if (!monotone || factor < 2 || bodySize * factor > MAX_PARTIAL_UNROLL_INSTS) {
+        return false;
+    }
+
+    // 边界为常数时limit在编译时求出，越过32位边界时展开的循环不会执行
+    if (isIntLiteral(info.bound)) {
+        long long offset = getLimitOffset(info);
+        long long limit = info.bound->intVal + (info.step > 0 ? -offset : offset);
+        if (limit < INT_MIN || limit > INT_MAX) {
+            return false;
+        }
+    }
+
+    partialUnroll(cfg, loop, info, ensurePreheader(cfg, loop), temps);
+    return true;
+}
+
+/// @brief 部分展开后判断factor次迭代都满足条件时，比较的limit相对边界的偏移。
+/// iv + span < bound即iv < bound - |span|，包含等号时偏移减一，递减的循环为iv > bound + 偏移
+long long LoopUnroll::getLimitOffset(CountedLoop & info)
+{
+    long long span = (long long) (factor - 1) * info.step;
+    bool inclusive = info.pred == IRInstOperator::IRINST_OP_LE || info.pred == IRInstOperator::IRINST_OP_BE;
+    return (span > 0 ? span : -span) - (inclusive ? 1 : 0);
+}
+
+/// @brief 从preheader沿唯一前驱向上查找循环变量的常数初值
+/// @return true：找到常数初值
+bool LoopUnroll::getInitValue(IRBlock * preheader, Value * iv, int & init)
+{
+    IRBlock * block = preheader;
+    for (int count = 0; block != nullptr && count < MAX_INIT_SEARCH_BLOCKS; ++count) {
+        for (auto pIter = block->insts.rbegin(); pIter != block->insts.rend(); ++pIter) {
+            IRInst * inst = *pIter;
+            if (getInstDef(inst) != iv) {
+                continue;
+            }
+            AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+            if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && (assign->_flag == 0 || assign->_flag == 1) &&
+                isIntLiteral(inst->getSrc1())) {
+                init = inst->getSrc1()->intVal;
+                return true;
+            }
+            return false;
+        }
+        block = block->preds.size() == 1 ? block->preds[0] : nullptr;
+    }
+    return false;
+}
+
+/// @brief 求循环边界的常数值：字面量、const全局变量的初值，或只被一个字面量定值的局部变量
+/// @return true：边界是常数
+bool LoopUnroll::getBoundValue(FunctionCFG * cfg, Value * bound, int & value)
+{
+    if (isIntLiteral(bound)) {
+        value = bound->intVal;
+        return true;
+    }
+    int32_t constValue = 0;
+    if (getConstGlobalInt(bound, constValue)) {
+        value = constValue;
+        return true;
+    }
+    if (!isScalarVar(bound)) {
+        return false;
+    }
+
+    // 唯一的定值是字面量时，变量在定值之后总是该常数
+    IRInst * def = nullptr;
+    for (auto block: cfg->getBlocks()) {
+        for (auto inst: block->insts) {
+            if (getInstDef(inst) != bound) {
+                continue;
+            }
+            if (def != nullptr) {
+                return false;
+            }
+            def = inst;
+        }
+    }
+    if (def == nullptr || def->getOp() != IRInstOperator::IRINST_OP_ASSIGN || !isIntLiteral(def->getSrc1())) {
+        return false;
+    }
+    int flag = static_cast<AssignIRInst *>(def)->_flag;
+    if (flag != 0 && flag != 1) {
+        return false;
+    }
+    value = def->getSrc1()->intVal;
+    return true;
+}
+
+/// @brief 收集只在循环体某个块内先定值后使用的临时变量，复制循环体时需要重命名
+void LoopUnroll::collectLocalTemps(FunctionCFG * cfg, Loop * loop, std::unordered_set<Value *> & temps)
+{
+    std::unordered_map<Value *, IRBlock *> blockTemps;
+    collectBlockLocalTemps(cfg, blockTemps);
+    for (auto & pair: blockTemps) {
+        if (pair.second != loop->header && loop->contains(pair.second)) {
+            temps.insert(pair.first);
+        }
+    }
+}
+
+/// @brief 复制一份循环体（不含循环头），放在after之后
+/// @param labelMap 循环内Label到副本Label的映射，循环头映射到本副本结束后的跳转目标
+/// @return 布局上最后一个副本块
+IRBlock * LoopUnroll::cloneBody(FunctionCFG * cfg,
+                                Loop * loop,
+                                IRBlock * after,
+                                std::unordered_map<IRInst *, IRInst *> & labelMap,
+                                std::unordered_set<Value *> & temps)
+{
+    std::unordered_map<Value *, Value *> valueMap;
+    for (auto temp: temps) {
+        valueMap[temp] = cloneTempValue(func, temp);
+    }
+
+    IRBlock * last = after;
+    for (auto block: loop->blocks) {
+        if (block == loop->header) {
+            continue;
+        }
+        IRBlock * copy = cfg->createBlock(last, labelMap[block->label]);
+        for (auto inst: block->insts) {
+            copy->insts.push_back(cloneInst(inst, valueMap, labelMap));
+        }
+        last = copy;
+    }
+    return last;
+}
+
+/// @brief 完全展开，循环头与原循环体被删除
+void LoopUnroll::fullUnroll(FunctionCFG * cfg,
+                            Loop * loop,
+                            CountedLoop & info,
+                            IRBlock * preheader,
+                            int tripCount,
+                            std::unordered_set<Value *> & temps)
+{
+    IRBlock * header = loop->header;
+
+    // 每个副本的Label预先创建，第k个副本的回边跳到第k+1个副本的入口，最后一个跳到循环出口
+    std::vector<std::unordered_map<IRInst *, IRInst *>> labelMaps(tripCount);
+    for (auto & labelMap: labelMaps) {
+        for (auto block: loop->blocks) {
+            if (block != header) {
+                labelMap[block->label] = new LabelIRInst();
+            }
+        }
+    }
+    for (int k = 0; k < tripCount; ++k) {
+        labelMaps[k][header->label] = k + 1 < tripCount ? labelMaps[k + 1][info.body->label] : info.exit->label;
+    }
+
+    IRBlock * after = loop->blocks.back();
+    for (auto & labelMap: labelMaps) {
+        after = cloneBody(cfg, loop, after, labelMap, temps);
+    }
+
+    IRInst * entry = tripCount > 0 ? labelMaps[0][info.body->label] : info.exit->label;
+    replaceBranchTarget(preheader->getTerminator(), header->label, entry);
+
+    std::vector<IRBlock *> oldBlocks = loop->blocks;
+    for (auto block: oldBlocks) {
+        cfg->removeBlock(block);
+    }
+    cfg->buildEdges();
+}
+
+/// @brief 按展开因子部分展开，剩余的迭代由原循环执行
+void LoopUnroll::partialUnroll(FunctionCFG * cfg,
+                               Loop * loop,
+                               CountedLoop & info,
+                               IRBlock * preheader,
+                               std::unordered_set<Value *> & temps)
+{
+    IRBlock * header = loop->header;
+    bool increasing = info.step > 0;
+    long long offset = getLimitOffset(info);
+
+    // 展开循环的循环头：循环变量与limit比较，本轮factor次迭代都满足循环条件才执行展开的循环体
+    IRBlock * guard = cfg->createBlockBefore(header);
+    IRInst * entry = guard->label;
+    Value * limit = nullptr;
+    if (isIntLiteral(info.bound)) {
+        limit = symtab.newConstValue((int32_t) (info.bound->intVal + (increasing ? -offset : offset)));
+    } else {
+        // limit在循环外计算一次，越过32位边界时展开的循环一次也不执行，直接进入原循环
+        IRBlock * setup = cfg->createBlockBefore(guard);
+        IRBlock * check = cfg->createBlockBefore(setup);
+        Value * fits = func->newTempValue(BasicType::TYPE_BOOL);
+        check->insts.push_back(new BinaryIRInst(
+            increasing ? IRInstOperator::IRINST_OP_BE : IRInstOperator::IRINST_OP_LE,
+            fits,
+            info.bound,
+            symtab.newConstValue((int32_t) (increasing ? INT_MIN + offset : INT_MAX - offset))));
+        BcIRInst * checkBc = new BcIRInst();
+        checkBc->mode = 3;
+        checkBc->temp = fits;
+        checkBc->setTrueInst(setup->label);
+        checkBc->setFalseInst(header->label);
+        check->insts.push_back(checkBc);
+
+        limit = func->newTempValue(BasicType::TYPE_INT);
+        setup->insts.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I,
+                                                limit,
+                                                info.bound,
+                                                (int) (increasing ? -offset : offset),
+                                                2));
+        setup->insts.push_back(new BrIRInst(guard->label));
+        entry = check->label;
+    }
+    Value * cond = func->newTempValue(info.cmpInst->getDst()->type.type);
+    guard->insts.push_back(new BinaryIRInst(increasing ? IRInstOperator::IRINST_OP_LT : IRInstOperator::IRINST_OP_BT,
+                                            cond,
+                                            info.iv,
+                                            limit));
+
+    std::vector<std::unordered_map<IRInst *, IRInst *>> labelMaps(factor);
+    for (auto & labelMap: labelMaps) {
+        for (auto block: loop->blocks) {
+            if (block != header) {
+                labelMap[block->label] = new LabelIRInst();
+            }
+        }
+    }
+    for (int k = 0; k < factor; ++k) {
+        labelMaps[k][header->label] = k + 1 < factor ? labelMaps[k + 1][info.body->label] : guard->label;
+    }
+
+    BcIRInst * bc = new BcIRInst();
+    bc->mode = 3;
+    bc->temp = cond;
+    bc->setTrueInst(labelMaps[0][info.body->label]);
+    bc->setFalseInst(header->label);
+    guard->insts.push_back(bc);
+
+    IRBlock * after = guard;
+    for (auto & labelMap: labelMaps) {
+        after = cloneBody(cfg, loop, after, labelMap, temps);
+    }
+
+    // 进入循环时先执行展开后的循环，不满足条件时落入原循环处理剩余迭代
+    replaceBranchTarget(preheader->getTerminator(), header->label, entry);
+    visited.insert(guard->label);
+    cfg->buildEdges();
+}
@@ -0,0 +1,76 @@
+/**
+ * @file LoopUnroll.h
+ * @brief 计数循环展开：迭代次数为常数的小循环完全展开，其余循环按展开因子展开，原循环保留用于剩余迭代
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "LoopInfo.h"
+
+/// @brief 最内层计数循环的展开
+class LoopUnroll {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _factor 部分展开时的展开因子
+    LoopUnroll(Function * _func, int _factor = 4);
+
+    /// @brief 对函数内所有最内层计数循环进行展开
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 展开一个循环
+    /// @return true：控制流图被修改
+    bool unrollLoop(FunctionCFG * cfg, Loop * loop);
+
+    /// @brief 部分展开后判断factor次迭代都满足条件时，比较的limit相对边界的偏移
+    long long getLimitOffset(CountedLoop & info);
+
+    /// @brief 从preheader沿唯一前驱向上查找循环变量的常数初值
+    /// @return true：找到常数初值
+    bool getInitValue(IRBlock * preheader, Value * iv, int & init);
+
+    /// @brief 求循环边界的常数值：字面量、const全局变量的初值，或只被一个字面量定值的局部变量
+    /// @return true：边界是常数
+    bool getBoundValue(FunctionCFG * cfg, Value * bound, int & value);
+
+    /// @brief 收集只在循环体某个块内先定值后使用的临时变量，复制循环体时需要重命名
+    void collectLocalTemps(FunctionCFG * cfg, Loop * loop, std::unordered_set<Value *> & temps);
+
+    /// @brief 复制一份循环体（不含循环头），放在after之后
+    /// @param labelMap 循环内Label到副本Label的映射，循环头映射到本副本结束后的跳转目标
+    /// @return 布局上最后一个副本块
+    IRBlock * cloneBody(FunctionCFG * cfg,
+                        Loop * loop,
+                        IRBlock * after,
+                        std::unordered_map<IRInst *, IRInst *> & labelMap,
+                        std::unordered_set<Value *> & temps);
+
+    /// @brief 完全展开，循环头与原循环体被删除
+    void fullUnroll(FunctionCFG * cfg,
+                    Loop * loop,
+                    CountedLoop & info,
+                    IRBlock * preheader,
+                    int tripCount,
+                    std::unordered_set<Value *> & temps);
+
+    /// @brief 按展开因子部分展开，剩余的迭代由原循环执行
+    void partialUnroll(FunctionCFG * cfg,
+                       Loop * loop,
+                       CountedLoop & info,
+                       IRBlock * preheader,
+                       std::unordered_set<Value *> & temps);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 部分展开的展开因子
+    int factor;
+
+    /// @brief 已经处理过的循环头Label，避免重复展开
+    std::unordered_set<IRInst *> visited;
+};
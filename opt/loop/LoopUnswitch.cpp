@@ -0,0 +1,226 @@
+/**
+ * @file LoopUnswitch.cpp
+ * @brief 循环外提不变条件：循环内条件不变的分支移到循环外，循环按两个分支各复制一份
+ */
+#include <algorithm>
+
+#include "LoopUnswitch.h"
+
+/// @brief 允许复制的循环指令数上限
+static const int MAX_UNSWITCH_LOOP_INSTS = 120;
+
+/// @brief 每个函数最多外提的次数
+static const int MAX_UNSWITCH_PER_FUNCTION = 4;
+
+/// @brief 构造函数
+/// @param _func 函数
+LoopUnswitch::LoopUnswitch(Function * _func) : func(_func)
+{}
+
+/// @brief 对函数内的循环进行外提
+/// @return true：函数的IR被修改
+bool LoopUnswitch::run()
+{
+    bool changed = false;
+
+    // 每次只变换一个循环，变换后重建控制流图、支配关系与循环信息
+    while (unswitchCount < MAX_UNSWITCH_PER_FUNCTION) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool unswitched = false;
+        for (auto loop: loopInfo.getLoops()) {
+            if (unswitchLoop(&cfg, loop)) {
+                unswitched = true;
+                break;
+            }
+        }
+        if (!unswitched) {
+            break;
+        }
+
+        cfg.writeBack();
+        unswitchCount++;
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 是否是可以提前计算的运算，除法与取余可能因除零出错不能外提
+static bool isHoistableOp(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_ADD_I:
+        case IRInstOperator::IRINST_OP_SUB_I:
+        case IRInstOperator::IRINST_OP_MULT_I:
+        case IRInstOperator::IRINST_OP_LT:
+        case IRInstOperator::IRINST_OP_BT:
+        case IRInstOperator::IRINST_OP_LE:
+        case IRInstOperator::IRINST_OP_BE:
+        case IRInstOperator::IRINST_OP_EQ:
+        case IRInstOperator::IRINST_OP_NQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief 查找循环内条件不变的bc并外提
+/// @return true：控制流图被修改
+bool LoopUnswitch::unswitchLoop(FunctionCFG * cfg, Loop * loop)
+{
+    int loopSize = 0;
+    for (auto block: loop->blocks) {
+        if (block->label == nullptr) {
+            return false;
+        }
+        loopSize += (int) block->insts.size();
+    }
+    if (loopSize > MAX_UNSWITCH_LOOP_INSTS) {
+        return false;
+    }
+
+    // 查找两个出口都在循环内、条件在循环内不变的bc
+    IRBlock * condBlock = nullptr;
+    IRInst * condDef = nullptr;
+    IRBlock * trueBlock = nullptr;
+    IRBlock * falseBlock = nullptr;
+    std::vector<IRInst *> targets;
+    for (auto block: loop->blocks) {
+        IRInst * term = block->getTerminator();
+        if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BC) {
+            continue;
+        }
+        targets.clear();
+        getBranchTargets(term, targets);
+        trueBlock = cfg->getBlockByLabel(targets[0]);
+        falseBlock = cfg->getBlockByLabel(targets[1]);
+        if (trueBlock == nullptr || falseBlock == nullptr || trueBlock == falseBlock || !loop->contains(trueBlock) ||
+            !loop->contains(falseBlock)) {
+            continue;
+        }
+
+        Value * cond = static_cast<BcIRInst *>(term)->temp;
+        if (isLoopInvariant(loop, cond)) {
+            condBlock = block;
+            condDef = nullptr;
+            break;
+        }
+
+        // 条件由同一块内操作数都不变的运算得到，且循环内只有这一个定值
+        IRInst * def = nullptr;
+        int defCount = 0;
+        for (auto other: loop->blocks) {
+            for (auto inst: other->insts) {
+                if (getInstDef(inst) == cond) {
+                    def = inst;
+                    defCount++;
+                }
+            }
+        }
+        if (defCount != 1 || !isHoistableOp(def->getOp()) ||
+            std::find(block->insts.begin(), block->insts.end(), def) == block->insts.end() ||
+            !isLoopInvariant(loop, def->getSrc1()) || !isLoopInvariant(loop, def->getSrc2())) {
+            continue;
+        }
+        condBlock = block;
+        condDef = def;
+        break;
+    }
+    if (condBlock == nullptr) {
+        return false;
+    }
+
+    IRBlock * header = loop->header;
+    IRBlock * preheader = ensurePreheader(cfg, loop);
+
+    // 复制整个循环，只在循环内出现的临时变量重命名
+    std::unordered_set<Value *> temps;
+    collectLoopLocalTemps(cfg, loop, temps);
+    std::unordered_map<Value *, Value *> valueMap;
+    for (auto temp: temps) {
+        valueMap[temp] = cloneTempValue(func, temp);
+    }
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    for (auto block: loop->blocks) {
+        labelMap[block->label] = new LabelIRInst();
+    }
+
+    IRBlock * condCopy = nullptr;
+    std::vector<IRBlock *> copies;
+    IRBlock * after = loop->blocks.back();
+    for (auto block: loop->blocks) {
+        IRBlock * copy = cfg->createBlock(after, labelMap[block->label]);
+        for (auto inst: block->insts) {
+            copy->insts.push_back(cloneInst(inst, valueMap, labelMap));
+        }
+        if (block == condBlock) {
+            condCopy = copy;
+        }
+        copies.push_back(copy);
+        after = copy;
+    }
+
+    // 原循环只保留真分支，副本只保留假分支
+    Value * cond = static_cast<BcIRInst *>(condBlock->getTerminator())->temp;
+    condBlock->insts.back() = new BrIRInst(trueBlock->label);
+    condCopy->insts.back() = new BrIRInst(labelMap[falseBlock->label]);
+
+    // 直接以同一个不变值为条件的其它bc在两个版本中同样确定
+    if (condDef == nullptr) {
+        for (size_t i = 0; i < loop->blocks.size(); ++i) {
+            IRInst * term = loop->blocks[i]->getTerminator();
+            if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BC ||
+                static_cast<BcIRInst *>(term)->temp != cond) {
+                continue;
+            }
+            targets.clear();
+            getBranchTargets(term, targets);
+            loop->blocks[i]->insts.back() = new BrIRInst(targets[0]);
+            copies[i]->insts.back() = new BrIRInst(labelMap.count(targets[1]) ? labelMap[targets[1]] : targets[1]);
+        }
+    }
+
+    // 条件只被该bc使用时，循环内的计算可以删除
+    if (condDef != nullptr) {
+        bool usedElsewhere = false;
+        std::vector<Value *> uses;
+        for (auto block: cfg->getBlocks()) {
+            for (auto inst: block->insts) {
+                uses.clear();
+                getInstUses(inst, uses);
+                if (std::find(uses.begin(), uses.end(), cond) != uses.end()) {
+                    usedElsewhere = true;
+                }
+            }
+        }
+        if (!usedElsewhere && temps.count(cond)) {
+            auto pIter = std::find(condBlock->insts.begin(), condBlock->insts.end(), condDef);
+            condCopy->insts.erase(condCopy->insts.begin() + (pIter - condBlock->insts.begin()));
+            condBlock->insts.erase(pIter);
+        }
+    }
+
+    // preheader中计算条件并选择进入哪个版本的循环
+    preheader->insts.pop_back();
+    if (condDef != nullptr) {
+        Value * newCond = cloneTempValue(func, cond);
+        std::unordered_map<Value *, Value *> condMap{{cond, newCond}};
+        std::unordered_map<IRInst *, IRInst *> noLabels;
+        preheader->insts.push_back(cloneInst(condDef, condMap, noLabels));
+        cond = newCond;
+    }
+    BcIRInst * bc = new BcIRInst();
+    bc->mode = 3;
+    bc->temp = cond;
+    bc->setTrueInst(header->label);
+    bc->setFalseInst(labelMap[header->label]);
+    preheader->insts.push_back(bc);
+
+    // 两个版本中被确定不走的分支不再可达
+    cfg->buildEdges();
+    cfg->removeUnreachableBlocks();
+    return true;
+}
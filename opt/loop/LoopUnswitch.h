@@ -0,0 +1,33 @@
+/**
+ * @file LoopUnswitch.h
+ * @brief 循环外提不变条件：循环内条件不变的分支移到循环外，循环按两个分支各复制一份
+ */
+#pragma once
+
+#include <unordered_set>
+
+#include "LoopInfo.h"
+
+/// @brief 循环不变条件分支的外提
+class LoopUnswitch {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    LoopUnswitch(Function * _func);
+
+    /// @brief 对函数内的循环进行外提
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 查找循环内条件不变的bc并外提
+    /// @return true：控制流图被修改
+    bool unswitchLoop(FunctionCFG * cfg, Loop * loop);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 已经外提的次数，用于限制代码膨胀
+    int unswitchCount = 0;
+};
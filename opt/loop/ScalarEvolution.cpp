@@ -0,0 +1,882 @@
+/**
+ * @file ScalarEvolution.cpp
+ * @brief 标量演化分析：把循环内整型变量的值表示为各层循环迭代次数的多项式，求出循环结束时的闭式
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "ScalarEvolution.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 多项式的最高次数，生成代码时C(x, 3)之后的组合数无法用32位回绕运算精确计算
+static const int SCEV_MAX_DEGREE = 3;
+
+/// @brief 3在模2^32下的乘法逆元
+static const uint32_t INVERSE_OF_THREE = 0xAAAAAAABu;
+
+/// @brief 小整数的组合数
+static uint32_t smallBinomial(int n, int k)
+{
+    if (k < 0 || k > n) {
+        return 0;
+    }
+    uint32_t result = 1;
+    for (int i = 1; i <= k; ++i) {
+        result = result * (uint32_t) (n - k + i) / (uint32_t) i;
+    }
+    return result;
+}
+
+/// @brief 按生成代码相同的步骤计算C(x, m)模2^32
+static uint32_t wrapBinomial(uint32_t x, int m)
+{
+    if (m == 0) {
+        return 1;
+    }
+    if (m == 1) {
+        return x;
+    }
+
+    // C(x, 2) = h * (x - 1) + r * ((x - 1) / 2)，其中h = x / 2，r = x - 2h，各步都没有舍入
+    // x的最高位为1时，有符号除法得到的半数比无符号的少2^31，与奇数相乘后结果仍差2^31
+    int32_t half = (int32_t) x / 2;
+    uint32_t rest = x - 2u * (uint32_t) half;
+    int32_t prev = (int32_t) (x - 1u);
+    uint32_t c2 = (uint32_t) half * (uint32_t) prev + rest * (uint32_t) (prev / 2);
+    if ((int32_t) x < 0) {
+        c2 += 0x80000000u;
+    }
+    if (m == 2) {
+        return c2;
+    }
+
+    // C(x, 2) * (x - 2) = 3 * C(x, 3)，3是奇数，模2^32可逆
+    return c2 * (x - 2u) * INVERSE_OF_THREE;
+}
+
+/// @brief 向多项式累加一项
+static void addTerm(SCEVPoly & poly, const SCEVTerm & term, uint32_t coef)
+{
+    if (coef == 0) {
+        return;
+    }
+    uint32_t & sum = poly[term];
+    sum += coef;
+    if (sum == 0) {
+        poly.erase(term);
+    }
+}
+
+/// @brief dst += scale * src
+static void addPoly(SCEVPoly & dst, const SCEVPoly & src, uint32_t scale = 1)
+{
+    for (auto & pair: src) {
+        addTerm(dst, pair.first, pair.second * scale);
+    }
+}
+
+/// @brief 常数多项式
+static SCEVPoly constPoly(uint32_t value)
+{
+    SCEVPoly poly;
+    addTerm(poly, SCEVTerm(), value);
+    return poly;
+}
+
+/// @brief 多项式关于所有迭代次数的总次数
+static int polyDegree(const SCEVPoly & poly)
+{
+    int degree = 0;
+    for (auto & pair: poly) {
+        int sum = 0;
+        for (auto d: pair.first.degrees) {
+            sum += d;
+        }
+        degree = std::max(degree, sum);
+    }
+    return degree;
+}
+
+/// @brief 多项式是否是整数常量
+static bool isConstPoly(const SCEVPoly & poly, uint32_t & value)
+{
+    value = 0;
+    for (auto & pair: poly) {
+        if (!(pair.first == SCEVTerm())) {
+            return false;
+        }
+        value = pair.second;
+    }
+    return true;
+}
+
+/// @brief 多项式各项都不含原子且系数非负，此时对所有非负的迭代次数都非负
+static bool isLiteralNonNegative(const SCEVPoly & poly)
+{
+    for (auto & pair: poly) {
+        if (!pair.first.atoms.empty() || (int32_t) pair.second < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 逐层展开组合数之积：C(k, a) * C(k, b) = Σ C(i, a) * C(a, a + b - i) * C(k, i)
+static void expandProduct(const SCEVTerm & x, const SCEVTerm & y, int level, SCEVTerm & term, uint32_t coef, SCEVPoly & result)
+{
+    if (level == SCEV_MAX_LEVELS) {
+        addTerm(result, term, coef);
+        return;
+    }
+    int a = x.degrees[level];
+    int b = y.degrees[level];
+    for (int i = std::max(a, b); i <= a + b; ++i) {
+        term.degrees[level] = i;
+        expandProduct(x, y, level + 1, term, coef * smallBinomial(i, a) * smallBinomial(a, a + b - i), result);
+    }
+}
+
+/// @brief 多项式乘法
+static SCEVPoly mulPoly(const SCEVPoly & lhs, const SCEVPoly & rhs)
+{
+    SCEVPoly result;
+    for (auto & x: lhs) {
+        for (auto & y: rhs) {
+            SCEVTerm term;
+            term.atoms = x.first.atoms;
+            term.atoms.insert(term.atoms.end(), y.first.atoms.begin(), y.first.atoms.end());
+            std::sort(term.atoms.begin(), term.atoms.end());
+            expandProduct(x.first, y.first, 0, term, x.second * y.second, result);
+        }
+    }
+    return result;
+}
+
+/// @brief 把第level层的迭代次数替换为整数t
+static SCEVPoly evalAt(const SCEVPoly & poly, int level, int t)
+{
+    SCEVPoly result;
+    for (auto & pair: poly) {
+        SCEVTerm term = pair.first;
+        uint32_t factor = smallBinomial(t, term.degrees[level]);
+        term.degrees[level] = 0;
+        addTerm(result, term, pair.second * factor);
+    }
+    return result;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _cfg 控制流图
+ScalarEvolution::ScalarEvolution(Function * _func, FunctionCFG * _cfg) : func(_func), cfg(_cfg)
+{}
+
+/// @brief 获取或新建原子
+int ScalarEvolution::getAtom(SCEVAtom & atom)
+{
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        SCEVAtom & other = atoms[i];
+        if (other.kind == atom.kind && other.val == atom.val && other.level == atom.level && other.m == atom.m &&
+            other.arg == atom.arg) {
+            return (int) i;
+        }
+    }
+    atoms.push_back(atom);
+    return (int) atoms.size() - 1;
+}
+
+/// @brief 只含一个原子的多项式
+SCEVPoly ScalarEvolution::atomPoly(int atom)
+{
+    SCEVTerm term;
+    term.atoms.push_back(atom);
+    SCEVPoly poly;
+    addTerm(poly, term, 1);
+    return poly;
+}
+
+/// @brief 多项式是否含有递推变量的占位原子
+/// @param level 只检查该层的占位原子，为-1时检查所有层
+bool ScalarEvolution::hasPlaceholder(const SCEVPoly & poly, int level)
+{
+    for (auto & pair: poly) {
+        for (auto id: pair.first.atoms) {
+            if (atoms[id].kind == SCEVAtom::PLACEHOLDER && (level < 0 || atoms[id].level == level)) {
+                return true;
+            }
+            if (atoms[id].kind == SCEVAtom::BINOM && hasPlaceholder(atoms[id].arg, level)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// @brief 计算C(poly, m)，poly中的迭代次数变量按插值展开
+/// @details 总次数为D的多项式由单纯形{s | Σ s_l <= D}上的值确定，组合数基下的系数就是这些点上的差分
+bool ScalarEvolution::binomial(const SCEVPoly & poly, int m, SCEVPoly & result)
+{
+    result.clear();
+    if (m == 0) {
+        result = constPoly(1);
+        return true;
+    }
+    int degree = polyDegree(poly);
+    if (degree * m > SCEV_MAX_DEGREE) {
+        return false;
+    }
+
+    if (degree == 0) {
+        uint32_t value;
+        if (isConstPoly(poly, value)) {
+            result = constPoly(wrapBinomial(value, m));
+        } else if (m == 1) {
+            result = poly;
+        } else {
+            SCEVAtom atom;
+            atom.kind = SCEVAtom::BINOM;
+            atom.arg = poly;
+            atom.m = m;
+            result = atomPoly(getAtom(atom));
+        }
+        return true;
+    }
+
+    std::vector<int> levels;
+    for (int level = 0; level < SCEV_MAX_LEVELS; ++level) {
+        for (auto & pair: poly) {
+            if (pair.first.degrees[level] > 0) {
+                levels.push_back(level);
+                break;
+            }
+        }
+    }
+
+    // 枚举总次数不超过degree * m的下标e，系数为Σ_{s <= e} (-1)^{|e|-|s|} Π C(e_l, s_l) C(poly(s), m)
+    int total = degree * m;
+    std::vector<int> e(levels.size(), 0);
+    for (;;) {
+        int sumE = 0;
+        for (auto x: e) {
+            sumE += x;
+        }
+        if (sumE <= total) {
+            SCEVPoly coef;
+            std::vector<int> s(levels.size(), 0);
+            for (;;) {
+                SCEVPoly point = poly;
+                uint32_t factor = 1;
+                int sumS = 0;
+                for (size_t j = 0; j < levels.size(); ++j) {
+                    point = evalAt(point, levels[j], s[j]);
+                    factor *= smallBinomial(e[j], s[j]);
+                    sumS += s[j];
+                }
+                if ((sumE - sumS) % 2 != 0) {
+                    factor = 0u - factor;
+                }
+                SCEVPoly value;
+                if (!binomial(point, m, value)) {
+                    return false;
+                }
+                addPoly(coef, value, factor);
+
+                size_t j = 0;
+                while (j < s.size() && s[j] == e[j]) {
+                    s[j++] = 0;
+                }
+                if (j == s.size()) {
+                    break;
+                }
+                s[j]++;
+            }
+            for (auto & pair: coef) {
+                SCEVTerm term = pair.first;
+                for (size_t j = 0; j < levels.size(); ++j) {
+                    term.degrees[levels[j]] = e[j];
+                }
+                addTerm(result, term, pair.second);
+            }
+        }
+
+        size_t j = 0;
+        while (j < e.size() && e[j] == total) {
+            e[j++] = 0;
+        }
+        if (j == e.size()) {
+            break;
+        }
+        e[j]++;
+    }
+    return true;
+}
+
+/// @brief 把第level层的迭代次数替换为多项式value
+bool ScalarEvolution::substitute(const SCEVPoly & poly, int level, const SCEVPoly & value, SCEVPoly & result)
+{
+    result.clear();
+    for (auto & pair: poly) {
+        SCEVTerm term = pair.first;
+        int degree = term.degrees[level];
+        term.degrees[level] = 0;
+        SCEVPoly rest;
+        addTerm(rest, term, pair.second);
+
+        SCEVPoly factor;
+        if (!binomial(value, degree, factor)) {
+            return false;
+        }
+        addPoly(result, mulPoly(rest, factor));
+    }
+    return polyDegree(result) <= SCEV_MAX_DEGREE;
+}
+
+/// @brief 多项式是否在所有迭代中都非负，可以借助外层循环条件
+bool ScalarEvolution::isNonNegative(const SCEVPoly & poly)
+{
+    if (isLiteralNonNegative(poly)) {
+        return true;
+    }
+    for (auto & fact: facts) {
+        SCEVPoly diff = poly;
+        addPoly(diff, fact, 0u - 1u);
+        if (isLiteralNonNegative(diff)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 读取变量的值，同时记录被读取的递推变量
+bool ScalarEvolution::readValue(Value * val, SCEVEnv & env, SCEVPoly & poly)
+{
+    if (val->isliteral()) {
+        if (val->type.type != BasicType::TYPE_INT) {
+            return false;
+        }
+        poly = constPoly((uint32_t) val->intVal);
+        return true;
+    }
+    if (env.opaque.count(val)) {
+        return false;
+    }
+
+    auto pIter = env.vals.find(val);
+    if (pIter != env.vals.end()) {
+        poly = pIter->second;
+        for (auto & pair: poly) {
+            for (auto id: pair.first.atoms) {
+                if (atoms[id].kind == SCEVAtom::PLACEHOLDER) {
+                    readPlaceholders.insert(id);
+                }
+            }
+        }
+        return true;
+    }
+
+    // 整型标量取进入最外层循环时的值，循环内没有函数调用，全局变量也不会被修改
+    bool isGlobalScalar =
+        symtab.findSymbolValue(val) && !(val->is_numpy || val->is_issavenp() || val->np != nullptr);
+    if (!(isScalarVar(val) || isGlobalScalar) || val->type.type != BasicType::TYPE_INT) {
+        return false;
+    }
+    SCEVAtom atom;
+    atom.kind = SCEVAtom::VALUE;
+    atom.val = val;
+    poly = atomPoly(getAtom(atom));
+    return true;
+}
+
+/// @brief 变量的值未知
+static void setOpaque(SCEVEnv & env, Value * val)
+{
+    env.vals.erase(val);
+    env.opaque.insert(val);
+}
+
+/// @brief 设置变量的值，非整型变量的值视为未知
+static void setValue(SCEVEnv & env, Value * val, SCEVPoly & poly)
+{
+    if (val->type.type != BasicType::TYPE_INT || polyDegree(poly) > SCEV_MAX_DEGREE) {
+        setOpaque(env, val);
+        return;
+    }
+    env.vals[val] = poly;
+    env.opaque.erase(val);
+}
+
+/// @brief 求值一条指令，更新其定值变量
+/// @return false：指令有副作用或者是函数调用
+bool ScalarEvolution::evalInst(IRInst * inst, SCEVEnv & env)
+{
+    Value * dst = inst->getDst();
+    SCEVPoly lhs, rhs;
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_ASSIGN: {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                return false;
+            }
+            if (flag == 2) {
+                setOpaque(env, dst);
+            } else if ((flag == 0 || flag == 1 || flag == 5) && readValue(inst->getSrc1(), env, lhs)) {
+                if (flag == 5) {
+                    SCEVPoly neg;
+                    addPoly(neg, lhs, 0u - 1u);
+                    lhs = neg;
+                }
+                setValue(env, dst, lhs);
+            } else {
+                setOpaque(env, dst);
+            }
+            return true;
+        }
+        case IRInstOperator::IRINST_OP_ADD_I:
+        case IRInstOperator::IRINST_OP_SUB_I:
+        case IRInstOperator::IRINST_OP_MULT_I:
+            if (static_cast<BinaryIRInst *>(inst)->mode >= 4 || !readValue(inst->getSrc1(), env, lhs) ||
+                !readValue(inst->getSrc2(), env, rhs)) {
+                setOpaque(env, dst);
+            } else if (inst->getOp() == IRInstOperator::IRINST_OP_MULT_I) {
+                if (polyDegree(lhs) + polyDegree(rhs) > SCEV_MAX_DEGREE) {
+                    setOpaque(env, dst);
+                } else {
+                    SCEVPoly product = mulPoly(lhs, rhs);
+                    setValue(env, dst, product);
+                }
+            } else {
+                addPoly(lhs, rhs, inst->getOp() == IRInstOperator::IRINST_OP_ADD_I ? 1u : 0u - 1u);
+                setValue(env, dst, lhs);
+            }
+            return true;
+        case IRInstOperator::IRINST_OP_DIV_I:
+        case IRInstOperator::IRINST_OP_MOD_I:
+        case IRInstOperator::IRINST_OP_LT:
+        case IRInstOperator::IRINST_OP_BT:
+        case IRInstOperator::IRINST_OP_LE:
+        case IRInstOperator::IRINST_OP_BE:
+        case IRInstOperator::IRINST_OP_EQ:
+        case IRInstOperator::IRINST_OP_NQ:
+        case IRInstOperator::IRINST_OP_AND:
+        case IRInstOperator::IRINST_OP_OR:
+            setOpaque(env, dst);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief 按布局执行一次循环体，内层循环整体求值
+/// @return false：循环体不是顺序执行的基本块与内层计数循环
+bool ScalarEvolution::evalBody(Loop * loop, CountedLoop & info, int level, SCEVEnv & env)
+{
+    std::unordered_set<IRBlock *> seen;
+    IRBlock * block = info.body;
+    while (block != loop->header) {
+        if (!loop->contains(block) || !seen.insert(block).second) {
+            return false;
+        }
+
+        Loop * subLoop = nullptr;
+        for (auto child: loop->subLoops) {
+            if (child->contains(block)) {
+                subLoop = child;
+            }
+        }
+        if (subLoop != nullptr) {
+            CountedLoop subInfo;
+            if (subLoop->header != block || !matchCountedLoop(subLoop, subInfo) ||
+                !evalLoop(subLoop, subInfo, level + 1, env)) {
+                return false;
+            }
+            block = subInfo.exit;
+            continue;
+        }
+
+        IRInst * term = block->getTerminator();
+        if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BR || block->succs.size() != 1) {
+            return false;
+        }
+        for (auto inst: block->insts) {
+            if (inst != term && !evalInst(inst, env)) {
+                return false;
+            }
+        }
+        block = block->succs[0];
+    }
+    return true;
+}
+
+/// @brief 分析一层计数循环，env由进入循环时的值更新为循环结束时的值
+/// @details 循环内定值的变量先以占位原子表示本次迭代开始时的值，执行一次循环体后，
+/// 结束值等于占位原子加上不含本层占位原子的增量时，该变量是加法递推，逐轮求解直到没有未解的递推
+bool ScalarEvolution::evalLoop(Loop * loop, CountedLoop & info, int level, SCEVEnv & env)
+{
+    if (level >= SCEV_MAX_LEVELS) {
+        return false;
+    }
+    bool upward = info.pred == IRInstOperator::IRINST_OP_LT || info.pred == IRInstOperator::IRINST_OP_LE;
+    bool downward = info.pred == IRInstOperator::IRINST_OP_BT || info.pred == IRInstOperator::IRINST_OP_BE;
+    if (!(upward && info.step > 0) && !(downward && info.step < 0)) {
+        return false;
+    }
+    // 内层循环的迭代次数要表示为多项式，不能有除法
+    if (level > 0 && std::abs(info.step) != 1) {
+        return false;
+    }
+    auto pIter = blockTemps.find(info.cmpInst->getDst());
+    if (pIter == blockTemps.end() || pIter->second != loop->header) {
+        return false;
+    }
+
+    SCEVPoly init, bound;
+    if (!readValue(info.iv, env, init) || !readValue(info.bound, env, bound)) {
+        return false;
+    }
+    SCEVTerm kTerm;
+    kTerm.degrees[level] = 1;
+    SCEVPoly ivPoly = init;
+    addTerm(ivPoly, kTerm, (uint32_t) info.step);
+
+    // 迭代次数与循环体内成立的条件fact >= 0
+    SCEVPoly trip, fact;
+    bool strict = info.pred == IRInstOperator::IRINST_OP_LT || info.pred == IRInstOperator::IRINST_OP_BT;
+    if (upward) {
+        trip = bound;
+        addPoly(trip, init, 0u - 1u);
+        fact = bound;
+        addPoly(fact, ivPoly, 0u - 1u);
+    } else {
+        trip = init;
+        addPoly(trip, bound, 0u - 1u);
+        fact = ivPoly;
+        addPoly(fact, bound, 0u - 1u);
+    }
+    if (!strict) {
+        addPoly(trip, constPoly(1));
+    } else {
+        addPoly(fact, constPoly(0u - 1u));
+    }
+    if (level == 0) {
+        SCEVAtom atom;
+        atom.kind = SCEVAtom::TRIP;
+        trip = atomPoly(getAtom(atom));
+    } else if (!isNonNegative(trip)) {
+        return false;
+    }
+    SCEVPoly tripMinusOne = trip;
+    addPoly(tripMinusOne, constPoly(0u - 1u));
+    bool atLeastOnce = level == 0 || isNonNegative(tripMinusOne);
+
+    // 循环内定值的变量，循环头中的比较结果只在循环头内使用
+    std::vector<Value *> defs;
+    std::unordered_set<Value *> defSet;
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            Value * def = getInstDef(inst);
+            if (def != nullptr && defSet.insert(def).second) {
+                defs.push_back(def);
+            }
+        }
+    }
+
+    std::unordered_map<Value *, SCEVPoly> resolved;
+    resolved[info.iv] = ivPoly;
+    std::unordered_set<Value *> unknownStart;
+    std::unordered_map<Value *, int> placeholders;
+    SCEVEnv iter;
+    facts.push_back(fact);
+    bool done = false;
+    for (size_t round = 0; round <= defs.size() && !done; ++round) {
+        iter = env;
+        placeholders.clear();
+        for (auto def: defs) {
+            if (resolved.count(def)) {
+                setValue(iter, def, resolved[def]);
+            } else if (unknownStart.count(def)) {
+                setOpaque(iter, def);
+            } else {
+                SCEVAtom atom;
+                atom.kind = SCEVAtom::PLACEHOLDER;
+                atom.val = def;
+                atom.level = level;
+                int id = getAtom(atom);
+                placeholders[def] = id;
+                readPlaceholders.erase(id);
+                SCEVPoly poly = atomPoly(id);
+                setValue(iter, def, poly);
+            }
+        }
+        if (!evalBody(loop, info, level, iter)) {
+            facts.pop_back();
+            return false;
+        }
+
+        // 开始时的值被读取过的变量必须是加法递推
+        done = true;
+        bool progress = false;
+        std::vector<Value *> pending;
+        for (auto def: defs) {
+            if (!placeholders.count(def) || !readPlaceholders.count(placeholders[def])) {
+                continue;
+            }
+            done = false;
+            SCEVPoly start;
+            auto valIter = iter.vals.find(def);
+            if (valIter != iter.vals.end()) {
+                SCEVPoly delta = valIter->second;
+                addPoly(delta, atomPoly(placeholders[def]), 0u - 1u);
+                if (!hasPlaceholder(delta, level) && readValue(def, env, start)) {
+                    for (auto & pair: delta) {
+                        SCEVTerm term = pair.first;
+                        term.degrees[level]++;
+                        addTerm(start, term, pair.second);
+                    }
+                    if (polyDegree(start) <= SCEV_MAX_DEGREE) {
+                        resolved[def] = start;
+                        progress = true;
+                        continue;
+                    }
+                }
+            }
+            pending.push_back(def);
+        }
+        if (!done && !progress) {
+            unknownStart.insert(pending.begin(), pending.end());
+        }
+    }
+    facts.pop_back();
+    if (!done) {
+        return false;
+    }
+
+    // 递推变量取第trip次迭代开始时的值，其余变量取最后一次迭代结束时的值
+    for (auto def: defs) {
+        SCEVPoly value;
+        bool known;
+        if (resolved.count(def)) {
+            known = substitute(resolved[def], level, trip, value);
+        } else {
+            auto valIter = iter.vals.find(def);
+            known = atLeastOnce && !unknownStart.count(def) && valIter != iter.vals.end() &&
+                    !hasPlaceholder(valIter->second, level) &&
+                    substitute(valIter->second, level, tripMinusOne, value);
+        }
+        if (known) {
+            setValue(env, def, value);
+        } else {
+            setOpaque(env, def);
+        }
+    }
+    return true;
+}
+
+/// @brief 分析循环，求出循环出口处活跃的变量在循环结束时的值
+/// @details 循环内只能有整型标量运算与读内存，内层循环也必须是计数循环，且不能有break、continue
+/// @param loop 最外层循环
+/// @param info 循环的计数信息
+/// @return true：所有出口活跃的变量都有闭式
+bool ScalarEvolution::analyze(Loop * loop, CountedLoop & info)
+{
+    topLoop = loop;
+    topInfo = info;
+    collectBlockLocalTemps(cfg, blockTemps);
+
+    SCEVEnv env;
+    if (!evalLoop(loop, info, 0, env)) {
+        return false;
+    }
+
+    std::unordered_set<Value *> defSet;
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            Value * def = getInstDef(inst);
+            if (def == nullptr || !defSet.insert(def).second || !isLiveIn(info.exit, def)) {
+                continue;
+            }
+            auto pIter = env.vals.find(def);
+            if (pIter == env.vals.end() || hasPlaceholder(pIter->second, -1)) {
+                return false;
+            }
+            exitValues.emplace_back(def, pIter->second);
+        }
+    }
+    return true;
+}
+
+/// @brief 生成一条二元运算指令，结果为新的整型临时变量
+Value * ScalarEvolution::emitBinary(IRInstOperator op, Value * src1, Value * src2, std::vector<IRInst *> & insts)
+{
+    Value * result = func->newTempValue(BasicType::TYPE_INT);
+    insts.push_back(new BinaryIRInst(op, result, src1, src2));
+    return result;
+}
+
+/// @brief 生成一条比较指令，结果为新的布尔临时变量
+Value * ScalarEvolution::emitCompare(IRInstOperator op, Value * src1, Value * src2, std::vector<IRInst *> & insts)
+{
+    Value * result = func->newTempValue(BasicType::TYPE_BOOL);
+    insts.push_back(new BinaryIRInst(op, result, src1, src2));
+    return result;
+}
+
+/// @brief 生成按条件在两个整数中选取的指令
+Value * ScalarEvolution::emitSelect(Value * cond, int32_t trueVal, int32_t falseVal, std::vector<IRInst *> & insts)
+{
+    Value * result = func->newTempValue(BasicType::TYPE_INT);
+    insts.push_back(
+        new SelectIRInst(result, cond, symtab.newConstValue(trueVal), symtab.newConstValue(falseVal)));
+    return result;
+}
+
+/// @brief 生成把x当作无符号数除以正的常量divisor的指令，IR只有有符号的除法
+/// @details x为负数时无符号值为v + 2^31，其中v = x + 2^31非负，
+/// 记2^31 = Q * divisor + R，则商为Q + v / divisor + (v % divisor + R) / divisor，各步都不溢出
+Value * ScalarEvolution::emitUnsignedDiv(Value * x, int32_t divisor, std::vector<IRInst *> & insts)
+{
+    int32_t quotient = (int32_t) (0x80000000u / (uint32_t) divisor);
+    int32_t remainder = (int32_t) (0x80000000u % (uint32_t) divisor);
+    Value * divisorValue = symtab.newConstValue(divisor);
+
+    Value * negative = emitCompare(IRInstOperator::IRINST_OP_LT, x, symtab.newConstValue(0), insts);
+    Value * v = emitBinary(IRInstOperator::IRINST_OP_ADD_I, x, emitSelect(negative, INT32_MIN, 0, insts), insts);
+    Value * result = emitBinary(IRInstOperator::IRINST_OP_DIV_I, v, divisorValue, insts);
+    Value * rest = emitBinary(IRInstOperator::IRINST_OP_MOD_I, v, divisorValue, insts);
+    if (remainder != 0) {
+        rest = emitBinary(IRInstOperator::IRINST_OP_ADD_I, rest, emitSelect(negative, remainder, 0, insts), insts);
+    }
+    Value * carry = emitBinary(IRInstOperator::IRINST_OP_DIV_I, rest, divisorValue, insts);
+    result = emitBinary(IRInstOperator::IRINST_OP_ADD_I, result, carry, insts);
+    return emitBinary(IRInstOperator::IRINST_OP_ADD_I, result, emitSelect(negative, quotient, 0, insts), insts);
+}
+
+/// @brief 生成计算原子值的指令
+Value * ScalarEvolution::emitAtom(int atom, std::vector<IRInst *> & insts)
+{
+    auto pIter = atomValues.find(atom);
+    if (pIter != atomValues.end()) {
+        return pIter->second;
+    }
+
+    Value * result = nullptr;
+    SCEVAtom info = atoms[atom];
+    switch (info.kind) {
+        case SCEVAtom::VALUE:
+            result = info.val;
+            break;
+        case SCEVAtom::TRIP:
+            result = tripValue;
+            break;
+        case SCEVAtom::BINOM:
+            if (info.m == 2) {
+                // 与wrapBinomial的计算步骤相同
+                Value * x = emitPoly(info.arg, insts);
+                Value * half = emitBinary(IRInstOperator::IRINST_OP_DIV_I, x, symtab.newConstValue(2), insts);
+                Value * twice = emitBinary(IRInstOperator::IRINST_OP_ADD_I, half, half, insts);
+                Value * rest = emitBinary(IRInstOperator::IRINST_OP_SUB_I, x, twice, insts);
+                Value * prev = emitBinary(IRInstOperator::IRINST_OP_SUB_I, x, symtab.newConstValue(1), insts);
+                Value * prevHalf = emitBinary(IRInstOperator::IRINST_OP_DIV_I, prev, symtab.newConstValue(2), insts);
+                Value * product = emitBinary(IRInstOperator::IRINST_OP_ADD_I,
+                                             emitBinary(IRInstOperator::IRINST_OP_MULT_I, half, prev, insts),
+                                             emitBinary(IRInstOperator::IRINST_OP_MULT_I, rest, prevHalf, insts),
+                                             insts);
+                if (signedTrip && x == tripValue) {
+                    result = product;
+                } else {
+                    Value * negative = emitCompare(IRInstOperator::IRINST_OP_LT, x, symtab.newConstValue(0), insts);
+                    result = emitBinary(IRInstOperator::IRINST_OP_ADD_I,
+                                        product,
+                                        emitSelect(negative, INT32_MIN, 0, insts),
+                                        insts);
+                }
+            } else {
+                // C(x, 3) = C(x, 2) * (x - 2) / 3，复用C(x, 2)
+                SCEVAtom square = info;
+                square.m = 2;
+                Value * c2 = emitAtom(getAtom(square), insts);
+                Value * x = emitPoly(info.arg, insts);
+                Value * next = emitBinary(IRInstOperator::IRINST_OP_SUB_I, x, symtab.newConstValue(2), insts);
+                result = emitBinary(IRInstOperator::IRINST_OP_MULT_I,
+                                    emitBinary(IRInstOperator::IRINST_OP_MULT_I, c2, next, insts),
+                                    symtab.newConstValue((int32_t) INVERSE_OF_THREE),
+                                    insts);
+            }
+            break;
+        default:
+            break;
+    }
+    atomValues[atom] = result;
+    return result;
+}
+
+/// @brief 生成计算多项式值的指令，要求多项式不含迭代次数
+Value * ScalarEvolution::emitPoly(const SCEVPoly & poly, std::vector<IRInst *> & insts)
+{
+    Value * sum = nullptr;
+    for (auto & pair: poly) {
+        Value * product = nullptr;
+        for (auto atom: pair.first.atoms) {
+            Value * val = emitAtom(atom, insts);
+            product = product ? emitBinary(IRInstOperator::IRINST_OP_MULT_I, product, val, insts) : val;
+        }
+        Value * coef = symtab.newConstValue((int32_t) pair.second);
+        if (product == nullptr) {
+            product = coef;
+        } else if (pair.second != 1) {
+            product = emitBinary(IRInstOperator::IRINST_OP_MULT_I, product, coef, insts);
+        }
+        sum = sum ? emitBinary(IRInstOperator::IRINST_OP_ADD_I, sum, product, insts) : product;
+    }
+    return sum ? sum : symtab.newConstValue(0);
+}
+
+/// @brief 生成计算迭代次数与所有出口值的指令，并把结果赋给对应变量，要求循环至少执行一次
+/// @param insts 生成的指令追加到这里
+/// @param _signedTrip 进入循环时边界与循环变量的距离加上步长不超过INT_MAX，迭代次数按有符号数计算
+void ScalarEvolution::emitExitValues(std::vector<IRInst *> & insts, bool _signedTrip)
+{
+    signedTrip = _signedTrip;
+
+    // 循环至少执行一次时，迭代次数为(bound - iv + step - 1) / step，<=与>=时为(bound - iv) / step + 1，
+    // 距离可能超过INT_MAX时按32位无符号数计算(bound - iv - 1) / step + 1，加上step - 1可能超出32位
+    bool upward = topInfo.pred == IRInstOperator::IRINST_OP_LT || topInfo.pred == IRInstOperator::IRINST_OP_LE;
+    bool strict = topInfo.pred == IRInstOperator::IRINST_OP_LT || topInfo.pred == IRInstOperator::IRINST_OP_BT;
+    int step = std::abs(topInfo.step);
+    Value * distance = upward ? emitBinary(IRInstOperator::IRINST_OP_SUB_I, topInfo.bound, topInfo.iv, insts)
+                              : emitBinary(IRInstOperator::IRINST_OP_SUB_I, topInfo.iv, topInfo.bound, insts);
+    if (step > 1 && !signedTrip) {
+        if (strict) {
+            distance = emitBinary(IRInstOperator::IRINST_OP_SUB_I, distance, symtab.newConstValue(1), insts);
+        }
+        distance = emitUnsignedDiv(distance, step, insts);
+        distance = emitBinary(IRInstOperator::IRINST_OP_ADD_I, distance, symtab.newConstValue(1), insts);
+    } else if (strict) {
+        if (step > 1) {
+            distance = emitBinary(IRInstOperator::IRINST_OP_ADD_I, distance, symtab.newConstValue(step - 1), insts);
+            distance = emitBinary(IRInstOperator::IRINST_OP_DIV_I, distance, symtab.newConstValue(step), insts);
+        }
+    } else {
+        if (step > 1) {
+            distance = emitBinary(IRInstOperator::IRINST_OP_DIV_I, distance, symtab.newConstValue(step), insts);
+        }
+        distance = emitBinary(IRInstOperator::IRINST_OP_ADD_I, distance, symtab.newConstValue(1), insts);
+    }
+    tripValue = distance;
+
+    // 出口值都用进入循环时的变量值计算，先存入临时变量，最后统一赋值
+    std::vector<Value *> results;
+    for (auto & pair: exitValues) {
+        Value * result = emitPoly(pair.second, insts);
+        if (!result->isTemp() || result == tripValue) {
+            Value * copy = func->newTempValue(BasicType::TYPE_INT);
+            insts.push_back(new AssignIRInst(copy, result, 0));
+            result = copy;
+        }
+        results.push_back(result);
+    }
+    for (size_t i = 0; i < exitValues.size(); ++i) {
+        insts.push_back(new AssignIRInst(exitValues[i].first, results[i], 0));
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file ScalarEvolution.h
+ * @brief 标量演化分析：把循环内整型变量的值表示为各层循环迭代次数的多项式，求出循环结束时的闭式
+ *
+ * 多项式以组合数C(k, d)为基，k为某一层循环已执行的迭代次数，系数是进入循环前已知的值之积。
+ * 加法递推s = s + delta(k)的第k次迭代开始时的值为s0 + Σ C(k, d + 1)，系数全部是整数，
+ * 生成的代码按32位回绕运算与原循环的结果一致。
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "LoopInfo.h"
+
+/// @brief 分析的最大循环嵌套层数
+static const int SCEV_MAX_LEVELS = 4;
+
+/// @brief 多项式的一项：各层循环迭代次数的组合数之积与原子之积
+struct SCEVTerm {
+    /// @brief 第l层循环迭代次数k_l的组合数C(k_l, degrees[l])
+    std::vector<int> degrees = std::vector<int>(SCEV_MAX_LEVELS, 0);
+
+    /// @brief 原子编号，升序排列
+    std::vector<int> atoms;
+
+    bool operator<(const SCEVTerm & other) const
+    {
+        return degrees != other.degrees ? degrees < other.degrees : atoms < other.atoms;
+    }
+
+    bool operator==(const SCEVTerm & other) const
+    {
+        return degrees == other.degrees && atoms == other.atoms;
+    }
+};
+
+/// @brief 多项式：项到系数的映射，系数按32位整数回绕，为0的项不保存
+using SCEVPoly = std::map<SCEVTerm, uint32_t>;
+
+/// @brief 多项式中的符号原子
+struct SCEVAtom {
+    enum Kind {
+        /// @brief 进入最外层循环时变量的值
+        VALUE,
+
+        /// @brief 某层循环的递推变量在本次迭代开始时的值，求解递推时使用
+        PLACEHOLDER,
+
+        /// @brief 最外层循环的迭代次数
+        TRIP,
+
+        /// @brief 组合数C(arg, m)，arg不含迭代次数
+        BINOM,
+    };
+
+    /// @brief 类别
+    Kind kind = VALUE;
+
+    /// @brief VALUE与PLACEHOLDER对应的变量
+    Value * val = nullptr;
+
+    /// @brief PLACEHOLDER所属的循环层
+    int level = 0;
+
+    /// @brief BINOM的参数
+    SCEVPoly arg;
+
+    /// @brief BINOM的下标
+    int m = 0;
+};
+
+/// @brief 分析过程中变量的取值，不在vals中且在opaque中的变量值未知
+struct SCEVEnv {
+    /// @brief 变量的多项式值
+    std::unordered_map<Value *, SCEVPoly> vals;
+
+    /// @brief 值不能表示为多项式的变量
+    std::unordered_set<Value *> opaque;
+};
+
+/// @brief 以一个计数循环为最外层的标量演化分析
+class ScalarEvolution {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _cfg 控制流图
+    ScalarEvolution(Function * _func, FunctionCFG * _cfg);
+
+    /// @brief 分析循环，求出循环出口处活跃的变量在循环结束时的值
+    /// @details 循环内只能有整型标量运算与读内存，内层循环也必须是计数循环，且不能有break、continue
+    /// @param loop 最外层循环
+    /// @param info 循环的计数信息
+    /// @return true：所有出口活跃的变量都有闭式
+    bool analyze(Loop * loop, CountedLoop & info);
+
+    /// @brief 生成计算迭代次数与所有出口值的指令，并把结果赋给对应变量，要求循环至少执行一次
+    /// @param insts 生成的指令追加到这里
+    /// @param _signedTrip 进入循环时边界与循环变量的距离加上步长不超过INT_MAX，迭代次数按有符号数计算
+    void emitExitValues(std::vector<IRInst *> & insts, bool _signedTrip = false);
+
+private:
+    /// @brief 分析一层计数循环，env由进入循环时的值更新为循环结束时的值
+    bool evalLoop(Loop * loop, CountedLoop & info, int level, SCEVEnv & env);
+
+    /// @brief 按布局执行一次循环体，内层循环整体求值
+    bool evalBody(Loop * loop, CountedLoop & info, int level, SCEVEnv & env);
+
+    /// @brief 求值一条指令，更新其定值变量
+    bool evalInst(IRInst * inst, SCEVEnv & env);
+
+    /// @brief 读取变量的值，同时记录被读取的递推变量
+    bool readValue(Value * val, SCEVEnv & env, SCEVPoly & poly);
+
+    /// @brief 获取或新建原子
+    int getAtom(SCEVAtom & atom);
+
+    /// @brief 只含一个原子的多项式
+    SCEVPoly atomPoly(int atom);
+
+    /// @brief 多项式是否含有递推变量的占位原子
+    /// @param level 只检查该层的占位原子，为-1时检查所有层
+    bool hasPlaceholder(const SCEVPoly & poly, int level);
+
+    /// @brief 计算C(poly, m)，poly中的迭代次数变量按插值展开
+    bool binomial(const SCEVPoly & poly, int m, SCEVPoly & result);
+
+    /// @brief 把第level层的迭代次数替换为多项式value
+    bool substitute(const SCEVPoly & poly, int level, const SCEVPoly & value, SCEVPoly & result);
+
+    /// @brief 多项式是否在所有迭代中都非负，可以借助外层循环条件
+    bool isNonNegative(const SCEVPoly & poly);
+
+    /// @brief 生成计算多项式值的指令，要求多项式不含迭代次数
+    Value * emitPoly(const SCEVPoly & poly, std::vector<IRInst *> & insts);
+
+    /// @brief 生成计算原子值的指令
+    Value * emitAtom(int atom, std::vector<IRInst *> & insts);
+
+    /// @brief 生成一条二元运算指令，结果为新的整型临时变量
+    Value * emitBinary(IRInstOperator op, Value * src1, Value * src2, std::vector<IRInst *> & insts);
+
+    /// @brief 生成一条比较指令，结果为新的布尔临时变量
+    Value * emitCompare(IRInstOperator op, Value * src1, Value * src2, std::vector<IRInst *> & insts);
+
+    /// @brief 生成按条件在两个整数中选取的指令
+    Value * emitSelect(Value * cond, int32_t trueVal, int32_t falseVal, std::vector<IRInst *> & insts);
+
+    /// @brief 生成把x当作无符号数除以正的常量divisor的指令，IR只有有符号的除法
+    Value * emitUnsignedDiv(Value * x, int32_t divisor, std::vector<IRInst *> & insts);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg;
+
+    /// @brief 最外层循环
+    Loop * topLoop = nullptr;
+
+    /// @brief 最外层循环的计数信息
+    CountedLoop topInfo;
+
+    /// @brief 只在单个基本块内使用的临时变量
+    std::unordered_map<Value *, IRBlock *> blockTemps;
+
+    /// @brief 所有原子
+    std::vector<SCEVAtom> atoms;
+
+    /// @brief 外层循环条件给出的非负多项式，内层循环判断迭代次数非负时使用
+    std::vector<SCEVPoly> facts;
+
+    /// @brief 本轮求值中被读取的占位原子
+    std::unordered_set<int> readPlaceholders;
+
+    /// @brief 出口活跃变量在循环结束时的值
+    std::vector<std::pair<Value *, SCEVPoly>> exitValues;
+
+    /// @brief 已生成的原子值
+    std::unordered_map<int, Value *> atomValues;
+
+    /// @brief 最外层循环的迭代次数
+    Value * tripValue = nullptr;
+
+    /// @brief 迭代次数不超过INT_MAX，按有符号数计算
+    bool signedTrip = false;
+};
@@ -0,0 +1,171 @@
+/**
+ * @file ScalarPromotion.cpp
+ * @brief 循环内全局标量的提升：循环前读入临时变量，循环内只访问临时变量，循环出口处写回全局变量
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "ScalarPromotion.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 是否是全局标量变量
+static bool isGlobalScalar(Value * val)
+{
+    return val != nullptr && !val->is_numpy && !val->isliteral() && !val->isConst() &&
+           (val->type.type == BasicType::TYPE_INT || val->type.type == BasicType::TYPE_FLOAT) &&
+           symtab.findSymbolValue(val);
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _callGraph 调用图，用于判断循环内的函数调用是否访问全局变量
+ScalarPromotion::ScalarPromotion(Function * _func, CallGraph & _callGraph) : func(_func), callGraph(_callGraph)
+{}
+
+/// @brief 对函数内的循环进行全局变量提升
+/// @return true：函数的IR被修改
+bool ScalarPromotion::run()
+{
+    bool changed = false;
+
+    // 每次提升一个循环，变换后重建控制流图与循环信息；外层循环优先，提升后内层循环不再访问这些全局变量
+    while (true) {
+        FunctionCFG cfg(func);
+        cfg.computeDominators();
+        LoopInfo loopInfo(&cfg);
+
+        bool promoted = false;
+        std::vector<Loop *> & loops = loopInfo.getLoops();
+        for (auto pIter = loops.rbegin(); pIter != loops.rend(); ++pIter) {
+            Loop * loop = *pIter;
+            if (!loop->header->isReachable()) {
+                continue;
+            }
+            std::vector<Value *> globals;
+            collectCandidates(loop, globals);
+            if (!globals.empty()) {
+                promoteLoop(&cfg, loop, globals);
+                promoted = true;
+                break;
+            }
+        }
+        if (!promoted) {
+            break;
+        }
+
+        cfg.writeBack();
+        changed = true;
+    }
+
+    return changed;
+}
+
+/// @brief 收集循环内访问、且循环内的函数调用不会读写的全局标量
+void ScalarPromotion::collectCandidates(Loop * loop, std::vector<Value *> & globals)
+{
+    std::unordered_set<Value *> seen;
+    std::vector<IRInst *> calls;
+    std::vector<Value *> uses;
+    for (auto block: loop->blocks) {
+        for (auto inst: block->insts) {
+            if (inst->getOp() == IRInstOperator::IRINST_OP_FUNC_CALL) {
+                calls.push_back(inst);
+            }
+            uses.clear();
+            getInstUses(inst, uses);
+            uses.push_back(getInstDef(inst));
+            for (auto val: uses) {
+                if (isGlobalScalar(val) && seen.insert(val).second) {
+                    globals.push_back(val);
+                }
+            }
+        }
+    }
+
+    globals.erase(std::remove_if(globals.begin(),
+                                 globals.end(),
+                                 [&](Value * global) {
+                                     for (auto call: calls) {
+                                         if (callGraph.mayReadGlobal(call, global) ||
+                                             callGraph.mayWriteGlobal(call, global)) {
+                                             return true;
+                                         }
+                                     }
+                                     return false;
+                                 }),
+                  globals.end());
+}
+
+/// @brief 把循环内对全局变量的访问替换为临时变量
+/// @param cfg 控制流图
+/// @param loop 循环
+/// @param globals 要提升的全局变量
+void ScalarPromotion::promoteLoop(FunctionCFG * cfg, Loop * loop, const std::vector<Value *> & globals)
+{
+    IRBlock * preheader = ensurePreheader(cfg, loop);
+
+    // preheader中读入全局变量
+    std::unordered_map<Value *, Value *> valueMap;
+    for (auto global: globals) {
+        Value * temp = func->newTempValue(global->type.type);
+        valueMap[global] = temp;
+        preheader->insts.insert(preheader->insts.end() - 1, new AssignIRInst(temp, global, 0));
+    }
+
+    // 循环内的读写改为访问临时变量
+    std::unordered_set<Value *> written;
+    std::unordered_map<IRInst *, IRInst *> noLabels;
+    std::vector<Value *> uses;
+    for (auto block: loop->blocks) {
+        for (auto & inst: block->insts) {
+            uses.clear();
+            getInstUses(inst, uses);
+            Value * def = getInstDef(inst);
+            bool accessed = valueMap.count(def) > 0;
+            for (auto use: uses) {
+                accessed |= valueMap.count(use) > 0;
+            }
+            if (!accessed) {
+                continue;
+            }
+            if (valueMap.count(def)) {
+                written.insert(def);
+            }
+            inst = cloneInst(inst, valueMap, noLabels);
+        }
+    }
+    if (written.empty()) {
+        return;
+    }
+
+    // 被写入的全局变量在每条出口边上写回，出口块还有循环外前驱时在出口边上插入新块
+    std::vector<IRBlock *> exits;
+    loop->getExitBlocks(exits);
+    for (auto exit: exits) {
+        std::vector<IRInst *> stores;
+        for (auto global: globals) {
+            if (written.count(global)) {
+                stores.push_back(new AssignIRInst(global, valueMap[global], 0));
+            }
+        }
+
+        bool dedicated = std::all_of(exit->preds.begin(), exit->preds.end(), [&](IRBlock * pred) {
+            return loop->contains(pred);
+        });
+        if (dedicated) {
+            exit->insts.insert(exit->insts.begin(), stores.begin(), stores.end());
+            continue;
+        }
+        IRBlock * landing = cfg->createBlockBefore(exit);
+        landing->insts = stores;
+        landing->insts.push_back(new BrIRInst(exit->label));
+        for (auto pred: exit->preds) {
+            if (loop->contains(pred)) {
+                replaceBranchTarget(pred->getTerminator(), exit->label, landing->label);
+            }
+        }
+    }
+    cfg->buildEdges();
+}
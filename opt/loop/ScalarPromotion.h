@@ -0,0 +1,40 @@
+/**
+ * @file ScalarPromotion.h
+ * @brief 循环内全局标量的提升：循环前读入临时变量，循环内只访问临时变量，循环出口处写回全局变量
+ */
+#pragma once
+
+#include <vector>
+
+#include "CallGraph.h"
+#include "LoopInfo.h"
+
+/// @brief 循环内全局标量变量的寄存器提升
+class ScalarPromotion {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _callGraph 调用图，用于判断循环内的函数调用是否访问全局变量
+    ScalarPromotion(Function * _func, CallGraph & _callGraph);
+
+    /// @brief 对函数内的循环进行全局变量提升
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 收集循环内访问、且循环内的函数调用不会读写的全局标量
+    void collectCandidates(Loop * loop, std::vector<Value *> & globals);
+
+    /// @brief 把循环内对全局变量的访问替换为临时变量
+    /// @param cfg 控制流图
+    /// @param loop 循环
+    /// @param globals 要提升的全局变量
+    void promoteLoop(FunctionCFG * cfg, Loop * loop, const std::vector<Value *> & globals);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 调用图
+    CallGraph & callGraph;
+};
@@ -0,0 +1,238 @@
+/**
+ * @file AliasAnalysis.cpp
+ * @brief 数组访存的别名分析：识别地址所属的基对象（全局数组、局部数组、数组形参）与相对基对象的常量字节偏移
+ */
+#include "AliasAnalysis.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 回溯单一定值变量的最大深度
+static const int ALIAS_MAX_DEPTH = 16;
+
+/// @brief 构造函数，收集只有一处定值的变量
+/// @param _func 函数
+AliasAnalysis::AliasAnalysis(Function * _func) : func(_func)
+{
+    std::unordered_map<Value *, int> defCount;
+    for (auto inst: func->getInterCode().getInsts()) {
+        Value * def = getInstDef(inst);
+        if (def != nullptr && ++defCount[def] == 1) {
+            defs[def] = inst;
+        }
+    }
+    for (auto & item: defCount) {
+        if (item.second > 1 || symtab.findSymbolValue(item.first)) {
+            defs.erase(item.first);
+        }
+    }
+}
+
+/// @brief 是否是数组变量，包括全局数组、局部数组与数组形参
+bool AliasAnalysis::isArrayObject(Value * val)
+{
+    return val->is_numpy && val->np != nullptr && !val->isliteral() && !val->is_issavenp();
+}
+
+/// @brief 获取基对象的类别
+MemoryObjectKind AliasAnalysis::getObjectKind(Value * base)
+{
+    if (base->np->_flag) {
+        return MemoryObjectKind::PARAM_ARRAY;
+    }
+    return symtab.findSymbolValue(base) ? MemoryObjectKind::GLOBAL_ARRAY : MemoryObjectKind::LOCAL_ARRAY;
+}
+
+/// @brief 判断两个访存位置是否重叠
+/// @details 不同的全局数组、局部数组互不重叠，数组形参不会指向本函数的局部数组；
+/// 同一基对象上常量偏移不同的位置不重叠，相同则是同一位置
+AliasResult AliasAnalysis::alias(const MemoryLocation & loc1, const MemoryLocation & loc2)
+{
+    if (loc1.base == nullptr || loc2.base == nullptr) {
+        return AliasResult::MAY_ALIAS;
+    }
+
+    if (loc1.base != loc2.base) {
+        MemoryObjectKind kind1 = getObjectKind(loc1.base);
+        MemoryObjectKind kind2 = getObjectKind(loc2.base);
+        if (kind1 == MemoryObjectKind::PARAM_ARRAY || kind2 == MemoryObjectKind::PARAM_ARRAY) {
+            return kind1 == MemoryObjectKind::LOCAL_ARRAY || kind2 == MemoryObjectKind::LOCAL_ARRAY
+                       ? AliasResult::NO_ALIAS
+                       : AliasResult::MAY_ALIAS;
+        }
+        return AliasResult::NO_ALIAS;
+    }
+
+    if (loc1.constOffset && loc2.constOffset) {
+        return loc1.offset == loc2.offset ? AliasResult::MUST_ALIAS : AliasResult::NO_ALIAS;
+    }
+    return AliasResult::MAY_ALIAS;
+}
+
+/// @brief 获取地址变量指向的位置
+/// @param ptr 数组变量或数组元素地址
+MemoryLocation AliasAnalysis::getLocation(Value * ptr)
+{
+    if (isArrayObject(ptr)) {
+        MemoryLocation loc;
+        loc.base = ptr;
+        loc.constOffset = true;
+        return loc;
+    }
+
+    auto pIter = locations.find(ptr);
+    if (pIter != locations.end()) {
+        return pIter->second;
+    }
+    // 先记为未知，防止定值成环时无限回溯
+    locations[ptr] = MemoryLocation();
+
+    MemoryLocation loc;
+    auto defIter = defs.find(ptr);
+    if (defIter != defs.end()) {
+        IRInst * inst = defIter->second;
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0) {
+            loc = getLocation(inst->getSrc()[0]);
+        } else if (inst->getOp() == IRInstOperator::IRINST_OP_ADD_I &&
+                   static_cast<BinaryIRInst *>(inst)->mode <= 3) {
+            BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+            Value * base = inst->getSrc1();
+            Value * index = inst->getSrc2();
+            if (!isArrayObject(base) && !base->is_issavenp()) {
+                std::swap(base, index);
+            }
+            loc = getLocation(base);
+
+            int32_t offset;
+            if (binary->mode == 2 || binary->mode == 3) {
+                offset = binary->src;
+            } else if (!getConstant(index, offset)) {
+                loc.constOffset = false;
+            }
+            if (loc.constOffset) {
+                loc.offset += offset;
+            }
+        }
+    }
+
+    locations[ptr] = loc;
+    return loc;
+}
+
+/// @brief 判断两个地址是否重叠
+AliasResult AliasAnalysis::alias(Value * ptr1, Value * ptr2)
+{
+    if (ptr1 == ptr2) {
+        return AliasResult::MUST_ALIAS;
+    }
+    return alias(getLocation(ptr1), getLocation(ptr2));
+}
+
+/// @brief 指令是否可能读取该位置
+bool AliasAnalysis::mayRead(IRInst * inst, const MemoryLocation & loc)
+{
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_ASSIGN: {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if (flag == 2 || flag == 4) {
+                return alias(getLocation(inst->getSrc()[0]), loc) != AliasResult::NO_ALIAS;
+            }
+            return false;
+        }
+        case IRInstOperator::IRINST_OP_FUNC_CALL: {
+            Function * callee = symtab.findFunction(static_cast<FuncCallIRInst *>(inst)->name);
+            if (callee == nullptr || !callee->isBuiltin()) {
+                return true;
+            }
+            // 内置函数只有putarray读实参数组
+            if (callee->getName() != "putarray") {
+                return false;
+            }
+            MemoryLocation arg = getLocation(inst->getSrc().back());
+            arg.constOffset = false;
+            return alias(arg, loc) != AliasResult::NO_ALIAS;
+        }
+        default:
+            // 内存操作数形式的运算
+            if (inst->getOp() >= IRInstOperator::IRINST_OP_ADD_I && inst->getOp() <= IRInstOperator::IRINST_OP_OR) {
+                return static_cast<BinaryIRInst *>(inst)->mode > 3;
+            }
+            return false;
+    }
+}
+
+/// @brief 指令是否可能写入该位置
+bool AliasAnalysis::mayWrite(IRInst * inst, const MemoryLocation & loc)
+{
+    switch (inst->getOp()) {
+        case IRInstOperator::IRINST_OP_ASSIGN: {
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if (flag == 3 || flag == 4 || flag == 6 || inst->Assign_flag == 6) {
+                return alias(getLocation(inst->getDst()), loc) != AliasResult::NO_ALIAS;
+            }
+            return false;
+        }
+        case IRInstOperator::IRINST_OP_FUNC_CALL: {
+            Function * callee = symtab.findFunction(static_cast<FuncCallIRInst *>(inst)->name);
+            if (callee == nullptr || !callee->isBuiltin()) {
+                return true;
+            }
+            // 内置函数只有getarray写实参数组
+            if (callee->getName() != "getarray") {
+                return false;
+            }
+            MemoryLocation arg = getLocation(inst->getSrc().back());
+            arg.constOffset = false;
+            return alias(arg, loc) != AliasResult::NO_ALIAS;
+        }
+        default:
+            return false;
+    }
+}
+
+/// @brief 变量是否在所有使用处都等于同一个整型常量
+/// @param val 变量
+/// @param result 常量值
+bool AliasAnalysis::getConstant(Value * val, int32_t & result)
+{
+    return getConstant(val, result, 0);
+}
+
+/// @brief 回溯定值求常量，depth限制回溯深度
+bool AliasAnalysis::getConstant(Value * val, int32_t & result, int depth)
+{
+    if (isIntLiteral(val)) {
+        result = val->intVal;
+        return true;
+    }
+    auto defIter = defs.find(val);
+    if (depth >= ALIAS_MAX_DEPTH || defIter == defs.end() || val->type.type != BasicType::TYPE_INT) {
+        return false;
+    }
+
+    IRInst * inst = defIter->second;
+    IRInstOperator op = inst->getOp();
+    if (op == IRInstOperator::IRINST_OP_ASSIGN) {
+        return static_cast<AssignIRInst *>(inst)->_flag == 0 && getConstant(inst->getSrc()[0], result, depth + 1);
+    }
+    if (op != IRInstOperator::IRINST_OP_ADD_I && op != IRInstOperator::IRINST_OP_SUB_I &&
+        op != IRInstOperator::IRINST_OP_MULT_I) {
+        return false;
+    }
+
+    BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+    int32_t a, b;
+    if (binary->mode > 3 || !getConstant(inst->getSrc1(), a, depth + 1)) {
+        return false;
+    }
+    if (binary->mode == 2 || binary->mode == 3) {
+        b = binary->src;
+    } else if (!getConstant(inst->getSrc2(), b, depth + 1)) {
+        return false;
+    }
+
+    // 按32位回绕计算
+    uint32_t x = a, y = b;
+    result = op == IRInstOperator::IRINST_OP_ADD_I ? x + y : op == IRInstOperator::IRINST_OP_SUB_I ? x - y : x * y;
+    return true;
+}
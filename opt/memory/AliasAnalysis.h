@@ -0,0 +1,98 @@
+/**
+ * @file AliasAnalysis.h
+ * @brief 数组访存的别名分析：识别地址所属的基对象（全局数组、局部数组、数组形参）与相对基对象的常量字节偏移
+ *
+ * 数组元素地址由add base, offset逐层计算，沿只有一处定值的变量回溯即可找到基对象与偏移。
+ * 初始化列表生成的地址临时变量以立即数形式加上4 * indexLinear，同样按常量偏移识别。
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "FunctionCFG.h"
+
+/// @brief 基对象的类别
+enum class MemoryObjectKind {
+    /// @brief 全局数组
+    GLOBAL_ARRAY,
+
+    /// @brief 本函数的局部数组
+    LOCAL_ARRAY,
+
+    /// @brief 数组形参，指向全局数组或调用者的数组
+    PARAM_ARRAY,
+};
+
+/// @brief 别名查询的结果
+enum class AliasResult {
+    /// @brief 一定不重叠
+    NO_ALIAS,
+
+    /// @brief 可能重叠
+    MAY_ALIAS,
+
+    /// @brief 一定是同一位置
+    MUST_ALIAS,
+};
+
+/// @brief 访存位置：基对象加字节偏移
+struct MemoryLocation {
+    /// @brief 基对象，为空时表示位置未知
+    Value * base = nullptr;
+
+    /// @brief 相对基对象的字节偏移是否是常量
+    bool constOffset = false;
+
+    /// @brief 常量字节偏移
+    int32_t offset = 0;
+};
+
+/// @brief 函数内数组访存的别名分析
+class AliasAnalysis {
+
+public:
+    /// @brief 构造函数，收集只有一处定值的变量
+    /// @param _func 函数
+    AliasAnalysis(Function * _func);
+
+    /// @brief 是否是数组变量，包括全局数组、局部数组与数组形参
+    static bool isArrayObject(Value * val);
+
+    /// @brief 获取基对象的类别
+    static MemoryObjectKind getObjectKind(Value * base);
+
+    /// @brief 判断两个访存位置是否重叠
+    static AliasResult alias(const MemoryLocation & loc1, const MemoryLocation & loc2);
+
+    /// @brief 获取地址变量指向的位置
+    /// @param ptr 数组变量或数组元素地址
+    MemoryLocation getLocation(Value * ptr);
+
+    /// @brief 判断两个地址是否重叠
+    AliasResult alias(Value * ptr1, Value * ptr2);
+
+    /// @brief 指令是否可能读取该位置
+    bool mayRead(IRInst * inst, const MemoryLocation & loc);
+
+    /// @brief 指令是否可能写入该位置
+    bool mayWrite(IRInst * inst, const MemoryLocation & loc);
+
+    /// @brief 变量是否在所有使用处都等于同一个整型常量
+    /// @param val 变量
+    /// @param result 常量值
+    bool getConstant(Value * val, int32_t & result);
+
+private:
+    /// @brief 回溯定值求常量，depth限制回溯深度
+    bool getConstant(Value * val, int32_t & result, int depth);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 只有一处定值的变量到其定值指令
+    std::unordered_map<Value *, IRInst *> defs;
+
+    /// @brief 已求出的地址位置
+    std::unordered_map<Value *, MemoryLocation> locations;
+};
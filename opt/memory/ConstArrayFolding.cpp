@@ -0,0 +1,201 @@
+/**
+ * @file ConstArrayFolding.cpp
+ * @brief const数组读取的编译期折叠：数组的初值在编译时已知，下标为常量或取值区间内元素都相同的读改为常量，
+ * 区间内的元素构成等差数列时改为下标的线性运算，只有两个元素时改为select
+ */
+#include <algorithm>
+
+#include "ConstArrayFolding.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 数组元素字节数
+static const int64_t ELEMENT_BYTES = 4;
+
+/// @brief 是否是初值在编译时已知的const整型数组
+static bool isConstIntArray(Value * val)
+{
+    return val != nullptr && val->is_numpy && val->isConst() && !val->isliteral() && !val->is_saveFParam &&
+           val->np != nullptr && val->np->is_int && val->np->numpy_int != nullptr && val->np->len > 0;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _maxSelectElements 改为select链时下标区间内元素的最大个数
+ConstArrayFolding::ConstArrayFolding(Function * _func, int _maxSelectElements)
+    : func(_func), maxSelectElements(_maxSelectElements)
+{}
+
+/// @brief 折叠函数内const数组的读取
+/// @return true：函数的IR被修改
+bool ConstArrayFolding::run()
+{
+    defs.clear();
+    bool hasLoad = false;
+    for (auto inst: func->getInterCode().getInsts()) {
+        Value * def = getInstDef(inst);
+        if (def != nullptr) {
+            auto result = defs.emplace(def, inst);
+            if (!result.second) {
+                result.first->second = nullptr;
+            }
+        }
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 2) {
+            hasLoad = true;
+        }
+    }
+    if (!hasLoad) {
+        return false;
+    }
+
+    ValueRange valueRange(func);
+    valueRange.run();
+    ranges = &valueRange;
+
+    FunctionCFG cfg(func);
+    bool changed = false;
+    for (auto block: cfg.getBlocks()) {
+        std::vector<IRInst *> insts;
+        for (size_t i = 0; i < block->insts.size(); ++i) {
+            IRInst * inst = block->insts[i];
+            std::vector<IRInst *> code;
+            if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 2 &&
+                inst->Assign_flag != 6 && fold(block, i, code)) {
+                insts.insert(insts.end(), code.begin(), code.end());
+                changed = true;
+                continue;
+            }
+            insts.push_back(inst);
+        }
+        block->insts.swap(insts);
+    }
+    ranges = nullptr;
+
+    if (changed) {
+        // 只用于计算地址的下标运算不再需要
+        removeDeadTempDefs(&cfg);
+        cfg.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 获取变量唯一的定值指令，没有或有多个定值时返回nullptr
+IRInst * ConstArrayFolding::getUniqueDef(Value * val)
+{
+    auto pIter = defs.find(val);
+    return pIter == defs.end() ? nullptr : pIter->second;
+}
+
+/// @brief 把读const数组元素的指令改为不访问内存的指令序列
+/// @param block 读内存指令所在的基本块
+/// @param pos 读内存指令在块内的位置
+/// @param code 替换后的指令序列
+/// @return true：可以替换
+bool ConstArrayFolding::fold(IRBlock * block, size_t pos, std::vector<IRInst *> & code)
+{
+    IRInst * load = block->insts[pos];
+    IRInst * addr = getUniqueDef(load->getSrc1());
+    if (addr == nullptr || addr->getOp() != IRInstOperator::IRINST_OP_ADD_I ||
+        static_cast<BinaryIRInst *>(addr)->mode > 3 || !isConstIntArray(addr->getSrc1())) {
+        return false;
+    }
+    _numpy_ * np = addr->getSrc1()->np;
+
+    // 字节偏移的区间，偏移是临时变量时在读内存处的值就是唯一定值处的值
+    Value * offset = addr->getSrc2();
+    IRInst * offsetDef = nullptr;
+    IntRange range;
+    if (isIntLiteral(offset)) {
+        range = IntRange(offset->intVal, offset->intVal);
+    } else {
+        offsetDef = getUniqueDef(offset);
+        if (offsetDef == nullptr || !offset->isTemp() || !ranges->getResultRange(offsetDef, range) ||
+            !range.fitsInt32()) {
+            return false;
+        }
+    }
+
+    // 下标区间，越界的读是未定义行为，不予考虑
+    if (range.hi < 0) {
+        return false;
+    }
+    int64_t lo = (std::max<int64_t>(range.lo, 0) + ELEMENT_BYTES - 1) / ELEMENT_BYTES;
+    int64_t hi = std::min<int64_t>(range.hi / ELEMENT_BYTES, np->len - 1);
+    if (lo > hi) {
+        return false;
+    }
+    const int * values = np->numpy_int;
+    Value * dst = load->getDst();
+
+    bool same = std::all_of(values + lo, values + hi + 1, [&](int val) { return val == values[lo]; });
+    if (same) {
+        code.push_back(new AssignIRInst(dst, symtab.newConstValue((int32_t) values[lo]), 0));
+        return true;
+    }
+
+    // 等差数列：value = step * k + base，k为偏移除以元素字节数的下标
+    int64_t step = (int64_t) values[lo + 1] - values[lo];
+    bool arithmetic = true;
+    for (int64_t k = lo + 1; k <= hi && arithmetic; ++k) {
+        arithmetic = (int64_t) values[k] - values[k - 1] == step;
+    }
+    int64_t first = values[lo] - step * lo;
+    Value * index = nullptr;
+    if (arithmetic && first >= INT32_MIN && first <= INT32_MAX && offsetDef != nullptr &&
+        offsetDef->getOp() == IRInstOperator::IRINST_OP_MULT_I && static_cast<BinaryIRInst *>(offsetDef)->mode <= 3) {
+        if (isIntLiteral(offsetDef->getSrc2()) && offsetDef->getSrc2()->intVal == ELEMENT_BYTES) {
+            index = offsetDef->getSrc1();
+        } else if (isIntLiteral(offsetDef->getSrc1()) && offsetDef->getSrc1()->intVal == ELEMENT_BYTES) {
+            index = offsetDef->getSrc2();
+        }
+    }
+    if (index != nullptr && !isIntLiteral(index)) {
+        // 下标在计算偏移之后到读内存之前不能被重新定值
+        auto defIter = std::find(block->insts.begin(), block->insts.begin() + pos, offsetDef);
+        if (defIter == block->insts.begin() + pos) {
+            index = nullptr;
+        }
+        for (; index != nullptr && defIter != block->insts.begin() + pos; ++defIter) {
+            if (getInstDef(*defIter) == index) {
+                index = nullptr;
+            }
+        }
+    }
+    if (index != nullptr) {
+        Value * scaled = index;
+        if (step != 1) {
+            scaled = func->newTempValue(BasicType::TYPE_INT);
+            code.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_MULT_I,
+                                            scaled,
+                                            index,
+                                            symtab.newConstValue((int32_t) step)));
+        }
+        if (first != 0) {
+            code.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_ADD_I,
+                                            dst,
+                                            scaled,
+                                            symtab.newConstValue((int32_t) first)));
+        } else {
+            code.push_back(new AssignIRInst(dst, scaled, 0));
+        }
+        return true;
+    }
+
+    // 元素很少时按偏移逐个比较选取，最后一个元素作为缺省值
+    if (hi - lo + 1 > maxSelectElements) {
+        return false;
+    }
+    Value * result = symtab.newConstValue((int32_t) values[hi]);
+    for (int64_t k = hi - 1; k >= lo; --k) {
+        Value * cond = func->newTempValue(BasicType::TYPE_BOOL);
+        Value * target = k == lo ? dst : func->newTempValue(BasicType::TYPE_INT);
+        code.push_back(new BinaryIRInst(IRInstOperator::IRINST_OP_EQ,
+                                        cond,
+                                        offset,
+                                        symtab.newConstValue((int32_t) (k * ELEMENT_BYTES))));
+        code.push_back(new SelectIRInst(target, cond, symtab.newConstValue((int32_t) values[k]), result));
+        result = target;
+    }
+    return true;
+}
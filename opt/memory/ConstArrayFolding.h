@@ -0,0 +1,49 @@
+/**
+ * @file ConstArrayFolding.h
+ * @brief const数组读取的编译期折叠：数组的初值在编译时已知，下标为常量或取值区间内元素都相同的读改为常量，
+ * 区间内的元素构成等差数列时改为下标的线性运算，只有两个元素时改为select
+ *
+ * 元素的值取自数组Value的np->numpy_int，下标的区间来自整型值域分析，越界的部分不予考虑。
+ */
+#pragma once
+
+#include <unordered_map>
+
+#include "ValueRange.h"
+
+/// @brief const数组读取的折叠
+class ConstArrayFolding {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _maxSelectElements 改为select链时下标区间内元素的最大个数
+    ConstArrayFolding(Function * _func, int _maxSelectElements = 2);
+
+    /// @brief 折叠函数内const数组的读取
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 把读const数组元素的指令改为不访问内存的指令序列
+    /// @param block 读内存指令所在的基本块
+    /// @param pos 读内存指令在块内的位置
+    /// @param code 替换后的指令序列
+    /// @return true：可以替换
+    bool fold(IRBlock * block, size_t pos, std::vector<IRInst *> & code);
+
+    /// @brief 获取变量唯一的定值指令，没有或有多个定值时返回nullptr
+    IRInst * getUniqueDef(Value * val);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 改为select链时下标区间内元素的最大个数
+    int maxSelectElements;
+
+    /// @brief 整型值域分析
+    ValueRange * ranges = nullptr;
+
+    /// @brief 函数内每个变量的定值指令，有多个定值时为nullptr
+    std::unordered_map<Value *, IRInst *> defs;
+};
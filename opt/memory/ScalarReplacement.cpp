@@ -0,0 +1,190 @@
+/**
+ * @file ScalarReplacement.cpp
+ * @brief 小局部数组的标量替换：只用常量下标访问且地址不逃逸的整型局部数组拆分为每个元素一个临时变量
+ *
+ * 后端在函数入口把局部数组清零，因此拆出的临时变量同样在入口处初始化为0。
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "ScalarReplacement.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _maxElements 允许拆分的数组的最大元素个数
+ScalarReplacement::ScalarReplacement(Function * _func, int _maxElements)
+    : func(_func), maxElements(_maxElements), aa(_func)
+{}
+
+/// @brief 拆分函数内所有符合条件的局部数组
+/// @return true：函数被修改
+bool ScalarReplacement::run()
+{
+    std::vector<Value *> arrays;
+    for (auto val: func->getVarValues()) {
+        if (AliasAnalysis::isArrayObject(val) && AliasAnalysis::getObjectKind(val) == MemoryObjectKind::LOCAL_ARRAY &&
+            val->np->is_int && val->np->len > 0 && val->np->len <= maxElements) {
+            arrays.push_back(val);
+        }
+    }
+
+    bool changed = false;
+    for (auto array: arrays) {
+        std::vector<Value *> pointers;
+        if (isPromotable(array, pointers)) {
+            replaceArray(array, pointers);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/// @brief 地址指向的元素下标，非常量或越界时返回-1
+int ScalarReplacement::elementIndex(Value * array, Value * ptr)
+{
+    MemoryLocation loc = aa.getLocation(ptr);
+    if (loc.base != array || !loc.constOffset || loc.offset % 4 != 0 || loc.offset < 0 ||
+        loc.offset / 4 >= array->np->len) {
+        return -1;
+    }
+    return loc.offset / 4;
+}
+
+/// @brief 检查数组的所有访问是否都是常量下标的读写
+/// @param array 局部数组
+/// @param pointers 数组本身以及指向数组的地址变量
+/// @return true：可以拆分
+bool ScalarReplacement::isPromotable(Value * array, std::vector<Value *> & pointers)
+{
+    auto pointsTo = [&](Value * val) {
+        return val != nullptr && !val->isliteral() && (val == array || aa.getLocation(val).base == array);
+    };
+
+    pointers.push_back(array);
+    std::vector<Value *> uses;
+    for (auto inst: func->getInterCode().getInsts()) {
+        uses.clear();
+        getInstUses(inst, uses);
+        bool accessed = pointsTo(inst->getDst());
+        for (auto use: uses) {
+            accessed |= pointsTo(use);
+        }
+        if (!accessed) {
+            continue;
+        }
+
+        IRInstOperator op = inst->getOp();
+        if (op == IRInstOperator::IRINST_OP_ADD_I && static_cast<BinaryIRInst *>(inst)->mode <= 3) {
+            // 地址计算，结果必须是常量下标的元素地址
+            if (elementIndex(array, inst->getDst()) < 0) {
+                return false;
+            }
+            pointers.push_back(inst->getDst());
+            continue;
+        }
+        if (op != IRInstOperator::IRINST_OP_ASSIGN) {
+            return false;
+        }
+
+        AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+        Value * dst = inst->getDst();
+        Value * src = inst->getSrc()[0];
+        if (assign->_flag == 6 || inst->Assign_flag == 6) {
+            if (elementIndex(array, dst) < 0) {
+                return false;
+            }
+        } else if (assign->_flag == 0) {
+            // 地址的复制
+            if (elementIndex(array, dst) < 0) {
+                return false;
+            }
+            pointers.push_back(dst);
+        } else if (assign->_flag == 2) {
+            if (pointsTo(dst) || elementIndex(array, src) < 0) {
+                return false;
+            }
+        } else if (assign->_flag == 3) {
+            // 存入的值本身是数组地址时地址逃逸
+            if (pointsTo(src) || elementIndex(array, dst) < 0) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 把数组的读写改为对元素临时变量的赋值，删除地址计算
+void ScalarReplacement::replaceArray(Value * array, const std::vector<Value *> & pointers)
+{
+    std::unordered_set<Value *> pointerSet(pointers.begin(), pointers.end());
+    std::vector<Value *> elements(array->np->len, nullptr);
+    auto elementOf = [&](Value * ptr) {
+        Value *& element = elements[elementIndex(array, ptr)];
+        if (element == nullptr) {
+            element = func->newTempValue(BasicType::TYPE_INT);
+        }
+        return element;
+    };
+
+    std::vector<IRInst *> & insts = func->getInterCode().getInsts();
+    std::vector<IRInst *> result;
+    result.reserve(insts.size());
+    for (auto inst: insts) {
+        Value * dst = inst->getDst();
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ADD_I && pointerSet.count(dst)) {
+            continue;
+        }
+        if (inst->getOp() != IRInstOperator::IRINST_OP_ASSIGN) {
+            result.push_back(inst);
+            continue;
+        }
+
+        AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+        Value * src = inst->getSrc()[0];
+        if (assign->_flag == 6 || inst->Assign_flag == 6) {
+            if (pointerSet.count(dst)) {
+                inst = new AssignIRInst(elementOf(dst), symtab.newConstValue(src->intVal), 0);
+            }
+        } else if (assign->_flag == 0) {
+            if (pointerSet.count(dst)) {
+                continue;
+            }
+        } else if (assign->_flag == 2) {
+            if (pointerSet.count(src)) {
+                inst = new AssignIRInst(dst, elementOf(src), 0);
+            }
+        } else if (assign->_flag == 3) {
+            if (pointerSet.count(dst)) {
+                inst = new AssignIRInst(elementOf(dst), src, 0);
+            }
+        }
+        result.push_back(inst);
+    }
+
+    // 与后端对局部数组的清零一致，所有元素在函数入口初始化为0
+    auto pIter = std::find_if(result.begin(), result.end(), [](IRInst * inst) {
+        return inst->getOp() == IRInstOperator::IRINST_OP_ENTRY;
+    });
+    pIter = pIter != result.end() ? pIter + 1 : result.begin();
+    std::vector<IRInst *> inits;
+    for (auto element: elements) {
+        if (element != nullptr) {
+            inits.push_back(new AssignIRInst(element, symtab.newConstValue(0), 0));
+        }
+    }
+    result.insert(pIter, inits.begin(), inits.end());
+    insts.swap(result);
+
+    // 数组与地址变量不再被引用，不再分配栈空间
+    std::vector<Value *> & vars = func->getVarValues();
+    for (auto ptr: pointers) {
+        if (std::find(vars.begin(), vars.end(), ptr) != vars.end()) {
+            func->deleteVarValue(ptr);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file ScalarReplacement.h
+ * @brief 小局部数组的标量替换：只用常量下标访问且地址不逃逸的整型局部数组拆分为每个元素一个临时变量
+ *
+ * 后端在函数入口把局部数组清零，因此拆出的临时变量同样在入口处初始化为0。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "AliasAnalysis.h"
+
+/// @brief 局部数组的标量替换
+class ScalarReplacement {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _maxElements 允许拆分的数组的最大元素个数
+    ScalarReplacement(Function * _func, int _maxElements = 16);
+
+    /// @brief 拆分函数内所有符合条件的局部数组
+    /// @return true：函数被修改
+    bool run();
+
+private:
+    /// @brief 检查数组的所有访问是否都是常量下标的读写
+    /// @param array 局部数组
+    /// @param pointers 数组本身以及指向数组的地址变量
+    /// @return true：可以拆分
+    bool isPromotable(Value * array, std::vector<Value *> & pointers);
+
+    /// @brief 地址指向的元素下标，非常量或越界时返回-1
+    int elementIndex(Value * array, Value * ptr);
+
+    /// @brief 把数组的读写改为对元素临时变量的赋值，删除地址计算
+    void replaceArray(Value * array, const std::vector<Value *> & pointers);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 允许拆分的数组的最大元素个数
+    int maxElements;
+
+    /// @brief 别名分析，用于识别地址的基对象与常量偏移
+    AliasAnalysis aa;
+};
@@ -0,0 +1,400 @@
+/**
+ * @file StoreForwarding.cpp
+ * @brief 存储到加载的转发与死存储删除：数组元素与全局变量的读写在基本块内及单前驱的后继块中复用
+ */
+#include <algorithm>
+
+#include "StoreForwarding.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 是否是全局标量变量
+static bool isGlobalScalar(Value * val)
+{
+    return !val->is_numpy && !val->isliteral() && !val->isConst() && symtab.findSymbolValue(val);
+}
+
+/// @brief 是否是写内存的赋值，即*dst = src
+static bool isStoreAssign(IRInst * inst)
+{
+    AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+    return assign->_flag == 3 || assign->_flag == 4 || assign->_flag == 6 || inst->Assign_flag == 6;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _callGraph 调用图，用于判断函数调用修改的内存
+StoreForwarding::StoreForwarding(Function * _func, CallGraph & _callGraph)
+    : func(_func), aa(_func), callGraph(_callGraph)
+{}
+
+/// @brief 按逆后序处理基本块，只有一个前驱的块继承前驱出口的状态
+/// @return true：函数被修改
+bool StoreForwarding::run()
+{
+    FunctionCFG cfg(func);
+    cfg.computeDominators();
+
+    bool changed = false;
+    std::unordered_map<IRBlock *, State> outStates;
+    for (auto block: cfg.getRPO()) {
+        State state;
+        if (block->preds.size() == 1 && block->preds[0] != block) {
+            auto pIter = outStates.find(block->preds[0]);
+            if (pIter != outStates.end()) {
+                state = pIter->second;
+            }
+        }
+        changed |= processBlock(block, state);
+
+        // 只有单前驱的后继才会使用出口状态
+        bool needed = false;
+        for (auto succ: block->succs) {
+            needed |= succ->preds.size() == 1;
+        }
+        if (needed) {
+            outStates[block] = std::move(state);
+        }
+    }
+
+    if (changed) {
+        cfg.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 分配新的值编号
+int StoreForwarding::newNumber()
+{
+    return nextNumber++;
+}
+
+/// @brief 获取变量的值编号，字面量按值编号，数组变量的编号同时是偏移为0的地址
+int StoreForwarding::numberOf(State & state, Value * val)
+{
+    if (isIntLiteral(val)) {
+        auto pIter = literalNumbers.find(val->intVal);
+        if (pIter != literalNumbers.end()) {
+            return pIter->second;
+        }
+        int number = newNumber();
+        literalNumbers[val->intVal] = number;
+        constants[number] = val->intVal;
+        return number;
+    }
+
+    auto pIter = state.numbers.find(val);
+    if (pIter != state.numbers.end()) {
+        return pIter->second;
+    }
+    int number = newNumber();
+    state.numbers[val] = number;
+    if (AliasAnalysis::isArrayObject(val) || val->is_issavenp()) {
+        addresses[number] = aa.getLocation(val);
+    }
+    return number;
+}
+
+/// @brief 为算术运算的结果编号，相同运算与相同操作数编号的结果编号相同
+/// @details 地址计算base + offset的结果记录访存位置，供别名判断使用
+int StoreForwarding::numberOfBinary(State & state, IRInst * inst)
+{
+    BinaryIRInst * binary = static_cast<BinaryIRInst *>(inst);
+    IRInstOperator op = inst->getOp();
+    Value * src1 = inst->getSrc1();
+    Value * src2 = inst->getSrc2();
+    if (binary->mode > 3 || op < IRInstOperator::IRINST_OP_ADD_I || op > IRInstOperator::IRINST_OP_MULT_I ||
+        src1->type.type == BasicType::TYPE_FLOAT || src2->type.type == BasicType::TYPE_FLOAT) {
+        return newNumber();
+    }
+
+    int number1 = numberOf(state, src1);
+    int number2 = numberOf(state, src2);
+    if (binary->mode == 2 || binary->mode == 3) {
+        number2 = numberOf(state, symtab.newConstValue(binary->src));
+    }
+    // 交换律运算的操作数按编号排序，地址加偏移时基地址在前
+    if (op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_MULT_I) {
+        bool isAddr1 = addresses.count(number1), isAddr2 = addresses.count(number2);
+        if (isAddr1 != isAddr2 ? isAddr2 : number1 > number2) {
+            std::swap(number1, number2);
+        }
+    }
+
+    // 常量折叠与x + 0、x * 1化简，除法与取余的除数为0时不折叠
+    auto const1 = constants.find(number1);
+    auto const2 = constants.find(number2);
+    if (const1 != constants.end() && const2 != constants.end()) {
+        uint32_t a = const1->second, b = const2->second;
+        int32_t result;
+        switch (op) {
+            case IRInstOperator::IRINST_OP_ADD_I:
+                result = a + b;
+                break;
+            case IRInstOperator::IRINST_OP_SUB_I:
+                result = a - b;
+                break;
+            case IRInstOperator::IRINST_OP_MULT_I:
+                result = a * b;
+                break;
+            default:
+                if (b == 0 || (const1->second == INT32_MIN && const2->second == -1)) {
+                    return newNumber();
+                }
+                result = op == IRInstOperator::IRINST_OP_DIV_I ? const1->second / const2->second
+                                                                : const1->second % const2->second;
+                break;
+        }
+        return numberOf(state, symtab.newConstValue(result));
+    }
+    if (const2 != constants.end() &&
+        ((const2->second == 0 && (op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_SUB_I)) ||
+         (const2->second == 1 && (op == IRInstOperator::IRINST_OP_MULT_I || op == IRInstOperator::IRINST_OP_DIV_I)))) {
+        return number1;
+    }
+
+    auto key = std::make_tuple(static_cast<int>(op), number1, number2);
+    auto pIter = expressions.find(key);
+    if (pIter != expressions.end()) {
+        return pIter->second;
+    }
+    int number = newNumber();
+    expressions[key] = number;
+
+    // 数组地址加字节偏移，偏移的常量性按值编号判断，比别名分析只看单一定值更精确
+    auto baseIter = addresses.find(number1);
+    if (op == IRInstOperator::IRINST_OP_ADD_I && baseIter != addresses.end()) {
+        MemoryLocation loc = baseIter->second;
+        loc.constOffset = loc.constOffset && const2 != constants.end();
+        if (loc.constOffset) {
+            loc.offset += const2->second;
+        }
+        addresses[number] = loc;
+    }
+    return number;
+}
+
+/// @brief 内容记录是否仍然有效，即记录的值没有被重新定值
+bool StoreForwarding::isValid(State & state, const Content & fact)
+{
+    return numberOf(state, fact.content) == fact.contentNumber;
+}
+
+/// @brief 两个地址值编号表示的地址是否可能重叠
+bool StoreForwarding::mayAlias(int addr1, int addr2)
+{
+    return addr1 == addr2 || AliasAnalysis::alias(locationOf(addr1), locationOf(addr2)) != AliasResult::NO_ALIAS;
+}
+
+/// @brief 地址值编号对应的访存位置，未知时基对象为空
+MemoryLocation StoreForwarding::locationOf(int addrNumber)
+{
+    auto pIter = addresses.find(addrNumber);
+    return pIter != addresses.end() ? pIter->second : MemoryLocation();
+}
+
+/// @brief 删除可能与地址重叠的内容记录
+void StoreForwarding::invalidate(State & state, int addrNumber)
+{
+    for (auto pIter = state.memory.begin(); pIter != state.memory.end();) {
+        if (mayAlias(pIter->first, addrNumber)) {
+            pIter = state.memory.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+}
+
+/// @brief 删除被调函数可能修改的全局变量与数组内容
+void StoreForwarding::clobberCall(State & state, IRInst * call)
+{
+    for (auto pIter = state.memory.begin(); pIter != state.memory.end();) {
+        if (callGraph.mayWrite(call, aa, locationOf(pIter->first))) {
+            pIter = state.memory.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+
+    // 被修改的全局变量重新编号，以其为内容的记录随之失效
+    for (auto pIter = state.numbers.begin(); pIter != state.numbers.end();) {
+        if (isGlobalScalar(pIter->first) && callGraph.mayWriteGlobal(call, pIter->first)) {
+            state.globals.erase(pIter->first);
+            pIter = state.numbers.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+    for (auto pIter = state.globals.begin(); pIter != state.globals.end();) {
+        if (callGraph.mayWriteGlobal(call, pIter->first)) {
+            pIter = state.globals.erase(pIter);
+        } else {
+            ++pIter;
+        }
+    }
+}
+
+/// @brief 处理一个基本块：读内存时使用已知内容，写内存时删除此前未被读取的同一位置的存储
+/// @return true：基本块被修改
+bool StoreForwarding::processBlock(IRBlock * block, State & state)
+{
+    bool changed = false;
+    std::vector<PendingStore> pending;
+    std::vector<IRInst *> deadStores;
+
+    // 可能读取addrNumber的访存使尚未读取的数组存储不再是死存储，addrNumber为-1表示任意数组元素
+    auto observeMemory = [&](int addrNumber) {
+        pending.erase(std::remove_if(pending.begin(),
+                                     pending.end(),
+                                     [&](const PendingStore & store) {
+                                         return store.global == nullptr &&
+                                                (addrNumber < 0 || mayAlias(store.addrNumber, addrNumber));
+                                     }),
+                      pending.end());
+    };
+    auto observeGlobal = [&](Value * global) {
+        pending.erase(std::remove_if(pending.begin(),
+                                     pending.end(),
+                                     [&](const PendingStore & store) { return store.global == global; }),
+                      pending.end());
+    };
+    auto killStore = [&](int addrNumber, Value * global) {
+        for (auto pIter = pending.begin(); pIter != pending.end(); ++pIter) {
+            if (pIter->global == global && (global != nullptr || pIter->addrNumber == addrNumber)) {
+                deadStores.push_back(pIter->inst);
+                pending.erase(pIter);
+                return;
+            }
+        }
+    };
+
+    std::vector<Value *> uses;
+    for (auto & inst: block->insts) {
+        IRInstOperator op = inst->getOp();
+
+        // 全局变量的读取使用已知的值
+        uses.clear();
+        getInstUses(inst, uses);
+        for (auto use: uses) {
+            if (use == nullptr || !isGlobalScalar(use)) {
+                continue;
+            }
+            auto pIter = state.globals.find(use);
+            if (pIter != state.globals.end() && isValid(state, pIter->second) &&
+                pIter->second.content->type.type == use->type.type) {
+                replaceInstUse(inst, use, pIter->second.content);
+                changed = true;
+            } else {
+                observeGlobal(use);
+            }
+        }
+
+        if (op == IRInstOperator::IRINST_OP_FUNC_CALL) {
+            // 被调函数可能读取的存储不再是死存储
+            pending.erase(std::remove_if(pending.begin(),
+                                         pending.end(),
+                                         [&](const PendingStore & store) {
+                                             return store.global != nullptr
+                                                        ? callGraph.mayReadGlobal(inst, store.global)
+                                                        : callGraph.mayRead(inst, aa, locationOf(store.addrNumber));
+                                         }),
+                          pending.end());
+            clobberCall(state, inst);
+            Value * def = getInstDef(inst);
+            if (def != nullptr) {
+                state.numbers[def] = newNumber();
+                state.globals.erase(def);
+            }
+            continue;
+        }
+
+        if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_OR) {
+            // 内存操作数形式的运算直接读内存
+            if (static_cast<BinaryIRInst *>(inst)->mode > 3) {
+                observeMemory(-1);
+            }
+            state.numbers[inst->getDst()] = numberOfBinary(state, inst);
+            state.globals.erase(inst->getDst());
+            continue;
+        }
+
+        if (op != IRInstOperator::IRINST_OP_ASSIGN) {
+            continue;
+        }
+
+        AssignIRInst * assign = static_cast<AssignIRInst *>(inst);
+        Value * dst = inst->getDst();
+        Value * src = inst->getSrc()[0];
+        if (isStoreAssign(inst)) {
+            // *p = x，*p = *q
+            int addrNumber = numberOf(state, dst);
+            if (assign->_flag == 4) {
+                observeMemory(numberOf(state, src));
+            }
+            killStore(addrNumber, nullptr);
+            invalidate(state, addrNumber);
+            pending.push_back(PendingStore{inst, addrNumber, nullptr});
+
+            Value * content = nullptr;
+            if (assign->_flag == 3) {
+                content = src;
+            } else if (assign->_flag != 4 && src->type.type == BasicType::TYPE_INT) {
+                content = symtab.newConstValue(src->intVal);
+            }
+            if (content != nullptr) {
+                state.memory[addrNumber] = Content{content, numberOf(state, content)};
+            }
+            continue;
+        }
+
+        // 定值的变量与其值，copied非空时表示dst = copied
+        Value * copied = assign->_flag == 0 ? src : nullptr;
+        if (assign->_flag == 2) {
+            // %t = *p
+            int addrNumber = numberOf(state, src);
+            auto pIter = state.memory.find(addrNumber);
+            if (pIter != state.memory.end() && isValid(state, pIter->second) &&
+                pIter->second.content->type.type == dst->type.type) {
+                copied = pIter->second.content;
+                inst = new AssignIRInst(dst, copied);
+                changed = true;
+            } else {
+                observeMemory(addrNumber);
+                state.numbers[dst] = newNumber();
+                state.memory[addrNumber] = Content{dst, state.numbers[dst]};
+            }
+        }
+        if (copied != nullptr) {
+            state.numbers[dst] = numberOf(state, copied);
+        } else if (assign->_flag != 2) {
+            state.numbers[dst] = newNumber();
+        }
+
+        if (isGlobalScalar(dst)) {
+            // 写全局变量，此前未被读取的写入是死存储
+            killStore(-1, dst);
+            pending.push_back(PendingStore{inst, -1, dst});
+            if (copied != nullptr) {
+                state.globals[dst] = Content{copied, state.numbers[dst]};
+            } else {
+                state.globals.erase(dst);
+            }
+        } else if (copied != nullptr && isGlobalScalar(copied)) {
+            // 读取全局变量之后，后续的读取可以使用这次读到的值
+            state.globals[copied] = Content{dst, state.numbers[dst]};
+        }
+    }
+
+    if (!deadStores.empty()) {
+        block->insts.erase(std::remove_if(block->insts.begin(),
+                                          block->insts.end(),
+                                          [&](IRInst * inst) {
+                                              return std::find(deadStores.begin(), deadStores.end(), inst) !=
+                                                     deadStores.end();
+                                          }),
+                           block->insts.end());
+        changed = true;
+    }
+    return changed;
+}
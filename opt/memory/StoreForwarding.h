@@ -0,0 +1,118 @@
+/**
+ * @file StoreForwarding.h
+ * @brief 存储到加载的转发与死存储删除：数组元素与全局变量的读写在基本块内及单前驱的后继块中复用
+ *
+ * 地址按局部值编号识别，相同编号的地址必然相同；编号不同的地址是否重叠由别名分析判断。
+ * 存入的值在下一次读同一地址时直接使用，被再次写入之前没有被读过的存储删除。
+ * 函数调用按调用图的副作用摘要只使被调函数可能访问的内容失效。
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "AliasAnalysis.h"
+#include "CallGraph.h"
+
+/// @brief 存储转发与死存储删除
+class StoreForwarding {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _callGraph 调用图，用于判断函数调用修改的内存
+    StoreForwarding(Function * _func, CallGraph & _callGraph);
+
+    /// @brief 执行存储转发与死存储删除
+    /// @return true：函数被修改
+    bool run();
+
+private:
+    /// @brief 内存位置当前保存的值，只有content的值编号仍为contentNumber时才有效
+    struct Content {
+        /// @brief 保存的值
+        Value * content = nullptr;
+
+        /// @brief 记录时content的值编号
+        int contentNumber = -1;
+    };
+
+    /// @brief 尚未被读取的存储
+    struct PendingStore {
+        /// @brief 存储指令
+        IRInst * inst = nullptr;
+
+        /// @brief 写入数组元素时的地址值编号，写全局变量时为-1
+        int addrNumber = -1;
+
+        /// @brief 写入的全局变量
+        Value * global = nullptr;
+    };
+
+    /// @brief 沿单前驱路径传递的分析状态
+    struct State {
+        /// @brief 变量当前的值编号
+        std::unordered_map<Value *, int> numbers;
+
+        /// @brief 数组元素地址值编号到其内容
+        std::map<int, Content> memory;
+
+        /// @brief 全局变量到其内容
+        std::unordered_map<Value *, Content> globals;
+    };
+
+    /// @brief 处理一个基本块，state为进入基本块时的状态，处理后为出口状态
+    /// @return true：基本块被修改
+    bool processBlock(IRBlock * block, State & state);
+
+    /// @brief 获取变量的值编号，字面量按值编号
+    int numberOf(State & state, Value * val);
+
+    /// @brief 分配新的值编号
+    int newNumber();
+
+    /// @brief 为算术运算的结果编号，相同运算与相同操作数编号的结果编号相同
+    int numberOfBinary(State & state, IRInst * inst);
+
+    /// @brief 内容记录是否仍然有效
+    bool isValid(State & state, const Content & fact);
+
+    /// @brief 地址值编号对应的访存位置，未知时基对象为空
+    MemoryLocation locationOf(int addrNumber);
+
+    /// @brief 两个地址值编号表示的地址是否可能重叠
+    bool mayAlias(int addr1, int addr2);
+
+    /// @brief 删除可能与地址重叠的内容记录
+    void invalidate(State & state, int addrNumber);
+
+    /// @brief 删除被调函数可能修改的全局变量与数组内容
+    void clobberCall(State & state, IRInst * call);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 别名分析
+    AliasAnalysis aa;
+
+    /// @brief 调用图
+    CallGraph & callGraph;
+
+    /// @brief 下一个值编号
+    int nextNumber = 0;
+
+    /// @brief 字面量的值编号
+    std::unordered_map<int32_t, int> literalNumbers;
+
+    /// @brief 值编号对应的常量
+    std::unordered_map<int, int32_t> constants;
+
+    /// @brief 运算(操作符, 操作数1编号, 操作数2编号)到结果编号
+    std::map<std::tuple<int, int, int>, int> expressions;
+
+    /// @brief 地址值编号对应的访存位置
+    std::unordered_map<int, MemoryLocation> addresses;
+};
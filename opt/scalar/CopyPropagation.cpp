@@ -0,0 +1,226 @@
+/**
+ * @file CopyPropagation.cpp
+ * @brief 复制传播与合并：x = y形式的复制的使用改为直接使用源操作数，结果只被复制到变量的运算直接定值该变量
+ */
+#include <algorithm>
+#include <unordered_set>
+
+#include "CopyPropagation.h"
+
+/// @brief 是否是标量的复制，不含数组元素的读写
+static bool isCopyInst(IRInst * inst)
+{
+    return inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0 &&
+           inst->Assign_flag != 6;
+}
+
+/// @brief 复制dst = src的使用能否替换为src，类型不同的复制是int与float之间的转换
+static bool isPropagatable(Value * dst, Value * src)
+{
+    if (!isScalarVar(dst) || dst == src) {
+        return false;
+    }
+    if (isIntLiteral(src)) {
+        return dst->type.type == BasicType::TYPE_INT;
+    }
+    return isScalarVar(src) && src->type.type == dst->type.type;
+}
+
+/// @brief 结果变量能否改为其它变量的指令：运算、select、复制、读内存、取负以及函数调用
+static bool isRenamableDef(IRInst * inst)
+{
+    IRInstOperator op = inst->getOp();
+    if ((op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_OR) ||
+        op == IRInstOperator::IRINST_OP_SELECT || op == IRInstOperator::IRINST_OP_FUNC_CALL) {
+        return true;
+    }
+    int flag = static_cast<AssignIRInst *>(inst)->_flag;
+    return op == IRInstOperator::IRINST_OP_ASSIGN && inst->Assign_flag != 6 && (flag == 0 || flag == 2 || flag == 5);
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+CopyPropagation::CopyPropagation(Function * _func) : func(_func)
+{}
+
+/// @brief 传播并删除函数内的复制
+/// @return true：函数的IR被修改
+bool CopyPropagation::run()
+{
+    FunctionCFG functionCFG(func);
+    cfg = &functionCFG;
+    globalCopies.clear();
+
+    countDefUses();
+    bool changed = false;
+    for (auto block: cfg->getBlocks()) {
+        changed |= propagateBlock(block);
+    }
+
+    // 复制所在块之外的使用，块内复制之后的使用已在块内替换，之前的使用是上一次执行的值
+    std::vector<Value *> uses;
+    if (!globalCopies.empty()) {
+        for (auto block: cfg->getBlocks()) {
+            for (auto inst: block->insts) {
+                uses.clear();
+                getInstUses(inst, uses);
+                for (auto use: uses) {
+                    auto pIter = globalCopies.find(use);
+                    if (pIter != globalCopies.end() && pIter->second.second != block) {
+                        replaceInstUse(inst, use, pIter->second.first);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // 传播之后只剩一次使用的运算结果再与复制合并
+    changed |= removeDeadTempDefs(cfg);
+    countDefUses();
+    for (auto block: cfg->getBlocks()) {
+        changed |= coalesceBlock(block);
+    }
+
+    if (changed) {
+        cfg->writeBack();
+    }
+    cfg = nullptr;
+    return changed;
+}
+
+/// @brief 统计每个变量的定值次数与使用次数
+void CopyPropagation::countDefUses()
+{
+    defCounts.clear();
+    useCounts.clear();
+    std::vector<Value *> uses;
+    for (auto block: cfg->getBlocks()) {
+        for (auto inst: block->insts) {
+            Value * def = getInstDef(inst);
+            if (def != nullptr) {
+                ++defCounts[def];
+            }
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                ++useCounts[use];
+            }
+        }
+    }
+}
+
+/// @brief 在基本块内沿复制链替换使用，并收集可以在全函数替换的复制
+/// @return true：基本块被修改
+bool CopyPropagation::propagateBlock(IRBlock * block)
+{
+    bool changed = false;
+
+    // 当前有效的复制：目的变量到源操作数，以及源操作数到以它为源的目的变量
+    std::unordered_map<Value *, Value *> copies;
+    std::unordered_map<Value *, std::vector<Value *>> dependents;
+
+    // 块内已经定值的变量
+    std::unordered_set<Value *> defined;
+
+    std::vector<Value *> uses;
+    for (auto inst: block->insts) {
+        uses.clear();
+        getInstUses(inst, uses);
+        for (auto use: uses) {
+            auto pIter = copies.find(use);
+            if (pIter != copies.end()) {
+                replaceInstUse(inst, use, pIter->second);
+                changed = true;
+            }
+        }
+
+        Value * def = getInstDef(inst);
+        if (def == nullptr) {
+            continue;
+        }
+
+        // 重新定值后以它为目的或源的复制失效
+        copies.erase(def);
+        auto depIter = dependents.find(def);
+        if (depIter != dependents.end()) {
+            for (auto dst: depIter->second) {
+                auto pIter = copies.find(dst);
+                if (pIter != copies.end() && pIter->second == def) {
+                    copies.erase(pIter);
+                }
+            }
+            dependents.erase(depIter);
+        }
+
+        // 复制到局部变量的临时变量留给合并，传播会延长临时变量的活跃区间
+        if (isCopyInst(inst) && def->isTemp() && isPropagatable(def, inst->getSrc1())) {
+            Value * src = inst->getSrc1();
+            copies[def] = src;
+            if (!isIntLiteral(src)) {
+                dependents[src].push_back(def);
+            }
+
+            // 源操作数在块内先于复制唯一定值，之后每次改变都紧接着这次复制，目的变量总是等于源操作数
+            if (!def->is_FParam() && defCounts[def] == 1 &&
+                (isIntLiteral(src) || (defCounts[src] == 1 && defined.count(src)))) {
+                globalCopies[def] = std::make_pair(src, block);
+            }
+        }
+        defined.insert(def);
+    }
+    return changed;
+}
+
+/// @brief 把基本块内结果只用于复制的运算改为直接定值复制的目的变量
+/// @return true：基本块被修改
+bool CopyPropagation::coalesceBlock(IRBlock * block)
+{
+    bool changed = false;
+    std::vector<Value *> uses;
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    std::vector<IRInst *> & insts = block->insts;
+    for (size_t j = 0; j < insts.size(); ++j) {
+        IRInst * copy = insts[j];
+        if (!isCopyInst(copy)) {
+            continue;
+        }
+        Value * dst = copy->getDst();
+        Value * temp = copy->getSrc1();
+        if (!temp->isTemp() || temp->is_FParam() || !isPropagatable(dst, temp) || !isScalarVar(temp) ||
+            defCounts[temp] != 1 || useCounts[temp] != 1) {
+            continue;
+        }
+
+        // 向前找到临时变量的定值，中间不能使用或定值目的变量
+        size_t i = j;
+        bool found = false;
+        while (i > 0) {
+            IRInst * inst = insts[--i];
+            if (getInstDef(inst) == temp) {
+                found = true;
+                break;
+            }
+            uses.clear();
+            getInstUses(inst, uses);
+            if (getInstDef(inst) == dst || std::find(uses.begin(), uses.end(), dst) != uses.end()) {
+                break;
+            }
+        }
+        if (!found || !isRenamableDef(insts[i])) {
+            continue;
+        }
+        uses.clear();
+        getInstUses(insts[i], uses);
+        if (std::find(uses.begin(), uses.end(), temp) != uses.end()) {
+            continue;
+        }
+
+        std::unordered_map<Value *, Value *> valueMap{{temp, dst}};
+        insts[i] = cloneInst(insts[i], valueMap, labelMap);
+        insts.erase(insts.begin() + j);
+        --j;
+        changed = true;
+    }
+    return changed;
+}
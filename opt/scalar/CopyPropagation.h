@@ -0,0 +1,54 @@
+/**
+ * @file CopyPropagation.h
+ * @brief 复制传播与合并：x = y形式的复制的使用改为直接使用源操作数，结果只被复制到变量的运算直接定值该变量
+ *
+ * 只处理标量的复制（_flag为0），数组元素的读写以及int与float之间的转换保持不变。
+ * 目的为临时变量的复制在基本块内沿复制链传播到源操作数被重新定值为止；唯一定值的临时变量在其源操作数的定值所在块内被复制时，
+ * 源操作数之后不会再改变，全函数的使用都可以替换。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "FunctionCFG.h"
+
+/// @brief 复制传播与合并
+class CopyPropagation {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    CopyPropagation(Function * _func);
+
+    /// @brief 传播并删除函数内的复制
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 在基本块内沿复制链替换使用，并收集可以在全函数替换的复制
+    /// @return true：基本块被修改
+    bool propagateBlock(IRBlock * block);
+
+    /// @brief 把基本块内结果只用于复制的运算改为直接定值复制的目的变量
+    /// @return true：基本块被修改
+    bool coalesceBlock(IRBlock * block);
+
+    /// @brief 统计每个变量的定值次数与使用次数
+    void countDefUses();
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg = nullptr;
+
+    /// @brief 变量的定值次数
+    std::unordered_map<Value *, int> defCounts;
+
+    /// @brief 变量的使用次数
+    std::unordered_map<Value *, int> useCounts;
+
+    /// @brief 全函数可替换的复制：目的变量到源操作数以及复制所在的基本块
+    std::unordered_map<Value *, std::pair<Value *, IRBlock *>> globalCopies;
+};
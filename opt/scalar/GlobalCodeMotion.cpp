@@ -0,0 +1,222 @@
+/**
+ * @file GlobalCodeMotion.cpp
+ * @brief 全局代码移动（Click算法）：纯运算先按操作数的定值位置求出最早可放置的块，
+ * 再按使用位置求出最晚的块，在两者之间的支配树路径上选取循环嵌套最浅、位置最靠后的块
+ */
+#include <algorithm>
+
+#include "GlobalCodeMotion.h"
+
+/// @brief 构造函数
+/// @param _func 函数
+GlobalCodeMotion::GlobalCodeMotion(Function * _func) : func(_func)
+{}
+
+/// @brief 调度函数内的纯运算
+/// @return true：函数的IR被修改
+bool GlobalCodeMotion::run()
+{
+    FunctionCFG graph(func);
+    graph.computeDominators();
+    LoopInfo loops(&graph);
+    cfg = &graph;
+    loopInfo = &loops;
+
+    std::vector<IRBlock *> & rpo = graph.getRPO();
+    for (auto block: rpo) {
+        domDepths[block] = block->idom == nullptr ? 0 : domDepths[block->idom] + 1;
+    }
+    collectDefUses();
+
+    // 最早位置：按逆后序处理，操作数的最早位置先于使用者确定，取其中支配树上最深的块
+    std::vector<IRInst *> movables;
+    for (auto block: rpo) {
+        for (auto inst: block->insts) {
+            if (!isMovable(inst)) {
+                continue;
+            }
+            IRBlock * early = graph.getEntry();
+            for (auto src: inst->getSrc()) {
+                IRBlock * srcBlock = getEarlyBlock(src);
+                if (domDepths[srcBlock] > domDepths[early]) {
+                    early = srcBlock;
+                }
+            }
+            earlyBlocks[inst] = early;
+            movables.push_back(inst);
+        }
+    }
+
+    // 最晚位置：逆序处理，使用者先被放到最终位置，取所有使用所在块的最近公共支配者
+    bool changed = false;
+    for (auto pIter = movables.rbegin(); pIter != movables.rend(); ++pIter) {
+        IRInst * inst = *pIter;
+        IRBlock * late = nullptr;
+        for (auto use: useInsts[inst->getDst()]) {
+            late = late == nullptr ? instBlocks[use] : commonDominator(late, instBlocks[use]);
+        }
+        // 结果没有被使用的运算留给死代码删除
+        if (late == nullptr) {
+            continue;
+        }
+
+        // 沿支配树从最晚位置向上到最早位置，循环深度相同时保留更靠后的块
+        IRBlock * early = earlyBlocks[inst];
+        IRBlock * best = late;
+        IRBlock * block = late;
+        for (; block != nullptr; block = block->idom) {
+            if (loopInfo->getLoopDepth(block) < loopInfo->getLoopDepth(best)) {
+                best = block;
+            }
+            if (block == early) {
+                break;
+            }
+        }
+        IRBlock * origin = instBlocks[inst];
+        if (block == nullptr || best == origin) {
+            continue;
+        }
+
+        origin->insts.erase(std::find(origin->insts.begin(), origin->insts.end(), inst));
+        if (!place(inst, best)) {
+            // 不满足块内的定值先于使用，放弃本函数的调度，函数的指令序列保持不变
+            return false;
+        }
+        changed = true;
+    }
+
+    if (changed) {
+        graph.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 收集变量的定值与使用，确定行为与SSA值相同的变量
+void GlobalCodeMotion::collectDefUses()
+{
+    std::unordered_map<IRInst *, int> positions;
+    for (auto block: cfg->getBlocks()) {
+        for (size_t i = 0; i < block->insts.size(); i++) {
+            IRInst * inst = block->insts[i];
+            instBlocks[inst] = block;
+            positions[inst] = (int) i;
+
+            Value * def = getInstDef(inst);
+            if (def != nullptr) {
+                defCounts[def]++;
+                defInsts[def] = inst;
+            }
+            std::vector<Value *> uses;
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (use != nullptr && !use->isliteral()) {
+                    useInsts[use].push_back(inst);
+                }
+            }
+        }
+    }
+
+    // 只定值一次，并且定值所在的块支配每个使用，同一块内定值在使用之前
+    for (auto & def: defInsts) {
+        if (defCounts[def.first] != 1) {
+            continue;
+        }
+        IRBlock * defBlock = instBlocks[def.second];
+        if (!defBlock->isReachable()) {
+            continue;
+        }
+        bool dominated = true;
+        for (auto use: useInsts[def.first]) {
+            IRBlock * useBlock = instBlocks[use];
+            if (useBlock == defBlock ? positions[use] <= positions[def.second] : !cfg->dominates(defBlock, useBlock)) {
+                dominated = false;
+                break;
+            }
+        }
+        if (dominated) {
+            ssaVars.insert(def.first);
+        }
+    }
+}
+
+/// @brief 是否是可以移动的纯运算：整型的二元运算与取负，结果是临时变量，操作数是字面量或者与SSA值行为相同的变量
+bool GlobalCodeMotion::isMovable(IRInst * inst)
+{
+    IRInstOperator op = inst->getOp();
+    bool binary = op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_NQ &&
+                  static_cast<BinaryIRInst *>(inst)->mode <= 3;
+    bool neg = op == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 5;
+    if (!binary && !neg) {
+        return false;
+    }
+
+    Value * dst = inst->getDst();
+    if (!dst->isTemp() || !isScalarVar(dst) || dst->type.type == BasicType::TYPE_FLOAT || !ssaVars.count(dst)) {
+        return false;
+    }
+    for (auto src: inst->getSrc()) {
+        if (isIntLiteral(src)) {
+            continue;
+        }
+        if (!isScalarVar(src) || src->type.type == BasicType::TYPE_FLOAT) {
+            return false;
+        }
+        // 没有定值的形参在入口处已经有值
+        if (defCounts[src] != 0 && !ssaVars.count(src)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 操作数的定值所在的最早位置，无定值的形参与字面量在入口块
+IRBlock * GlobalCodeMotion::getEarlyBlock(Value * val)
+{
+    if (val->isliteral() || defCounts[val] == 0) {
+        return cfg->getEntry();
+    }
+    IRInst * def = defInsts[val];
+    auto pIter = earlyBlocks.find(def);
+    return pIter != earlyBlocks.end() ? pIter->second : instBlocks[def];
+}
+
+/// @brief 支配树上两个基本块的最近公共祖先
+IRBlock * GlobalCodeMotion::commonDominator(IRBlock * a, IRBlock * b)
+{
+    while (a != b) {
+        if (domDepths[a] >= domDepths[b]) {
+            a = a->idom;
+        } else {
+            b = b->idom;
+        }
+    }
+    return a;
+}
+
+/// @brief 把运算插入到目标块中第一次使用其结果的指令之前，没有使用时放到块尾
+/// @return false：块内操作数的定值在第一次使用之后，无法插入
+bool GlobalCodeMotion::place(IRInst * inst, IRBlock * block)
+{
+    std::vector<IRInst *> & insts = block->insts;
+    size_t pos = block->getTerminator() != nullptr ? insts.size() - 1 : insts.size();
+    for (size_t i = 0; i < pos; i++) {
+        std::vector<Value *> uses;
+        getInstUses(insts[i], uses);
+        if (std::find(uses.begin(), uses.end(), inst->getDst()) != uses.end()) {
+            pos = i;
+            break;
+        }
+    }
+
+    std::vector<Value *> & srcs = inst->getSrc();
+    for (size_t i = pos; i < insts.size(); i++) {
+        Value * def = getInstDef(insts[i]);
+        if (def != nullptr && std::find(srcs.begin(), srcs.end(), def) != srcs.end()) {
+            return false;
+        }
+    }
+
+    insts.insert(insts.begin() + pos, inst);
+    instBlocks[inst] = block;
+    return true;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file GlobalCodeMotion.h
+ * @brief 全局代码移动（Click算法）：纯运算先按操作数的定值位置求出最早可放置的块，
+ * 再按使用位置求出最晚的块，在两者之间的支配树路径上选取循环嵌套最浅、位置最靠后的块
+ *
+ * 只移动结果与操作数都只定值一次、且定值支配所有使用的变量之间的运算，这些变量的行为与SSA值相同。
+ * 循环不变的运算因此被提到循环之外，只在一个分支中使用的运算被下沉到该分支中。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FunctionCFG.h"
+#include "LoopInfo.h"
+
+/// @brief 基于支配树与循环深度的全局代码移动
+class GlobalCodeMotion {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    GlobalCodeMotion(Function * _func);
+
+    /// @brief 调度函数内的纯运算
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 收集变量的定值与使用，确定行为与SSA值相同的变量
+    void collectDefUses();
+
+    /// @brief 是否是可以移动的纯运算
+    bool isMovable(IRInst * inst);
+
+    /// @brief 操作数的定值所在的最早位置，无定值的形参与字面量在入口块
+    IRBlock * getEarlyBlock(Value * val);
+
+    /// @brief 支配树上两个基本块的最近公共祖先
+    IRBlock * commonDominator(IRBlock * a, IRBlock * b);
+
+    /// @brief 把运算插入到目标块中第一次使用其结果的指令之前，没有使用时放到块尾
+    /// @return false：块内操作数的定值在第一次使用之后，无法插入
+    bool place(IRInst * inst, IRBlock * block);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 控制流图
+    FunctionCFG * cfg = nullptr;
+
+    /// @brief 循环信息
+    LoopInfo * loopInfo = nullptr;
+
+    /// @brief 支配树上的深度
+    std::unordered_map<IRBlock *, int> domDepths;
+
+    /// @brief 变量的定值次数
+    std::unordered_map<Value *, int> defCounts;
+
+    /// @brief 变量的定值指令
+    std::unordered_map<Value *, IRInst *> defInsts;
+
+    /// @brief 使用变量的指令
+    std::unordered_map<Value *, std::vector<IRInst *>> useInsts;
+
+    /// @brief 指令所在的基本块，移动后更新
+    std::unordered_map<IRInst *, IRBlock *> instBlocks;
+
+    /// @brief 只定值一次且定值支配所有使用的变量
+    std::unordered_set<Value *> ssaVars;
+
+    /// @brief 可移动运算的最早位置
+    std::unordered_map<IRInst *, IRBlock *> earlyBlocks;
+};
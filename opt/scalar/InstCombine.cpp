@@ -0,0 +1,613 @@
+/**
+ * @file InstCombine.cpp
+ * @brief 代数化简与重结合：常量折叠、恒等式消去、取负链消去、结合链中常量的合并以及比较的化简
+ *
+ * 在基本块内按顺序处理，操作数在块内的定值指令之后未被重新定值时，可以沿定值指令向上匹配。
+ * 规范形式：交换律运算与比较的常量在右侧，减常量改为加负常量，结合链中的常量移到最外层以便继续合并。
+ * const全局标量的读取先替换为初值的字面量。
+ */
+#include <climits>
+
+#include "InstCombine.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 一条指令反复化简的最大次数
+static const int MAX_COMBINE_ROUNDS = 8;
+
+/// @brief 是否是整型的标量值，不含数组与数组元素地址
+static bool isIntValue(Value * val)
+{
+    if (isIntLiteral(val)) {
+        return true;
+    }
+    return val != nullptr && val->type.type == BasicType::TYPE_INT && !val->is_numpy && !val->is_issavenp() &&
+           val->np == nullptr;
+}
+
+/// @brief 是否是比较运算
+static bool isCompare(IRInstOperator op)
+{
+    return op >= IRInstOperator::IRINST_OP_LT && op <= IRInstOperator::IRINST_OP_NQ;
+}
+
+/// @brief 交换操作数后对应的比较运算
+static IRInstOperator swapCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LE;
+        default:
+            return op;
+    }
+}
+
+/// @brief 结果取反后对应的比较运算
+static IRInstOperator invertCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LE;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_EQ:
+            return IRInstOperator::IRINST_OP_NQ;
+        default:
+            return IRInstOperator::IRINST_OP_EQ;
+    }
+}
+
+/// @brief 常量比较的结果
+static bool evalCompare(IRInstOperator op, int32_t lhs, int32_t rhs)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return lhs < rhs;
+        case IRInstOperator::IRINST_OP_BT:
+            return lhs > rhs;
+        case IRInstOperator::IRINST_OP_LE:
+            return lhs <= rhs;
+        case IRInstOperator::IRINST_OP_BE:
+            return lhs >= rhs;
+        case IRInstOperator::IRINST_OP_EQ:
+            return lhs == rhs;
+        default:
+            return lhs != rhs;
+    }
+}
+
+/// @brief 按32位补码回绕的加法与乘法
+static int32_t wrapAdd(int32_t lhs, int32_t rhs)
+{
+    return (int32_t) ((uint32_t) lhs + (uint32_t) rhs);
+}
+
+static int32_t wrapMul(int32_t lhs, int32_t rhs)
+{
+    return (int32_t) ((uint32_t) lhs * (uint32_t) rhs);
+}
+
+/// @brief 是否是没有内存操作数的二元运算
+static bool isPlainBinary(IRInst * inst, IRInstOperator op)
+{
+    return inst != nullptr && inst->getOp() == op && static_cast<BinaryIRInst *>(inst)->mode <= 3;
+}
+
+/// @brief 是否是取负指令
+static bool isNeg(IRInst * inst)
+{
+    return inst != nullptr && inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN &&
+           static_cast<AssignIRInst *>(inst)->_flag == 5 && inst->Assign_flag != 6 && isIntValue(inst->getSrc1());
+}
+
+static IRInst * makeCopy(Value * dst, Value * src)
+{
+    return new AssignIRInst(dst, src, 0);
+}
+
+static IRInst * makeConst(Value * dst, int32_t value)
+{
+    return new AssignIRInst(dst, symtab.newConstValue(value), 0);
+}
+
+static IRInst * makeNeg(Value * dst, Value * src)
+{
+    return new AssignIRInst(dst, src, 5);
+}
+
+static IRInst * makeBinary(IRInstOperator op, Value * dst, Value * lhs, Value * rhs)
+{
+    return new BinaryIRInst(op, dst, lhs, rhs);
+}
+
+static IRInst * makeBinary(IRInstOperator op, Value * dst, Value * lhs, int32_t rhs)
+{
+    return new BinaryIRInst(op, dst, lhs, symtab.newConstValue(rhs));
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _reassociate 是否把结合链中的常量移到最外层
+InstCombine::InstCombine(Function * _func, bool _reassociate) : func(_func), reassociate(_reassociate)
+{}
+
+/// @brief 化简函数内的整型运算
+/// @return true：函数的IR被修改
+bool InstCombine::run()
+{
+    FunctionCFG cfg(func);
+    bool changed = false;
+
+    // const全局标量的读取改为初值的字面量，不再被读取的const变量由无用全局变量删除去掉
+    std::vector<Value *> uses;
+    int32_t value = 0;
+    bool hasRelational = false;
+    for (auto block: cfg.getBlocks()) {
+        for (auto inst: block->insts) {
+            IRInstOperator op = inst->getOp();
+            hasRelational |= op >= IRInstOperator::IRINST_OP_LT && op <= IRInstOperator::IRINST_OP_BE;
+            uses.clear();
+            getInstUses(inst, uses);
+            for (auto use: uses) {
+                if (getConstGlobalInt(use, value)) {
+                    replaceInstUse(inst, use, symtab.newConstValue(value));
+                    changed = true;
+                }
+            }
+            countUses(inst, 1);
+        }
+    }
+
+    // 大小比较的化简需要证明加法不回绕
+    ValueRange valueRange(func);
+    if (hasRelational) {
+        valueRange.run();
+        ranges = &valueRange;
+    }
+
+    for (auto block: cfg.getBlocks()) {
+        changed |= combineBlock(block);
+    }
+    ranges = nullptr;
+
+    // 化简后不再使用的中间结果
+    changed |= removeDeadTempDefs(&cfg);
+    if (changed) {
+        cfg.writeBack();
+    }
+    return changed;
+}
+
+/// @brief 化简一个基本块
+/// @return true：基本块被修改
+bool InstCombine::combineBlock(IRBlock * block)
+{
+    defPositions.clear();
+    defInsts.clear();
+    position = 0;
+
+    bool changed = false;
+    std::vector<IRInst *> result;
+    result.reserve(block->insts.size());
+    for (auto inst: block->insts) {
+        changed |= emit(inst, result);
+    }
+    block->insts.swap(result);
+    return changed;
+}
+
+/// @brief 反复化简一条指令直到不再变化，然后追加到结果中
+/// @param inst 指令
+/// @param result 基本块的新指令序列
+/// @return true：指令被改写
+bool InstCombine::emit(IRInst * inst, std::vector<IRInst *> & result)
+{
+    bool changed = false;
+    for (int round = 0; round < MAX_COMBINE_ROUNDS; ++round) {
+        std::vector<IRInst *> prefix;
+        IRInst * next = simplify(inst, prefix);
+        if (next == nullptr) {
+            break;
+        }
+        countUses(inst, -1);
+        countUses(next, 1);
+        for (auto extra: prefix) {
+            countUses(extra, 1);
+            emit(extra, result);
+        }
+        inst = next;
+        changed = true;
+    }
+
+    result.push_back(inst);
+    Value * def = getInstDef(inst);
+    if (def != nullptr && !symtab.findSymbolValue(def)) {
+        defPositions[def] = position;
+        defInsts[def] = inst;
+    }
+    ++position;
+    return changed;
+}
+
+/// @brief 获取变量在当前位置仍然有效的块内定值指令，其操作数在定值之后没有被重新定值
+IRInst * InstCombine::getDef(Value * val)
+{
+    auto pIter = defInsts.find(val);
+    if (pIter == defInsts.end()) {
+        return nullptr;
+    }
+    IRInst * inst = pIter->second;
+    int defPosition = defPositions[val];
+    std::vector<Value *> uses;
+    getInstUses(inst, uses);
+    for (auto use: uses) {
+        // 全局变量可能被其间的函数调用修改
+        if (use == val || (!use->isliteral() && symtab.findSymbolValue(use))) {
+            return nullptr;
+        }
+        auto useIter = defPositions.find(use);
+        if (useIter != defPositions.end() && useIter->second > defPosition) {
+            return nullptr;
+        }
+    }
+    return inst;
+}
+
+/// @brief 变量在当前位置是否等于整型常量
+bool InstCombine::getConstant(Value * val, int32_t & value)
+{
+    if (isIntLiteral(val)) {
+        value = val->intVal;
+        return true;
+    }
+    IRInst * def = getDef(val);
+    if (def != nullptr && def->getOp() == IRInstOperator::IRINST_OP_ASSIGN &&
+        static_cast<AssignIRInst *>(def)->_flag == 0 && def->Assign_flag != 6 && isIntLiteral(def->getSrc1())) {
+        value = def->getSrc1()->intVal;
+        return true;
+    }
+    return false;
+}
+
+/// @brief 变量是否只被使用一次，重结合时不会重复计算
+bool InstCombine::hasOneUse(Value * val)
+{
+    auto pIter = useCounts.find(val);
+    return pIter != useCounts.end() && pIter->second == 1;
+}
+
+/// @brief 更新指令操作数的使用次数
+void InstCombine::countUses(IRInst * inst, int delta)
+{
+    std::vector<Value *> uses;
+    getInstUses(inst, uses);
+    for (auto use: uses) {
+        useCounts[use] += delta;
+    }
+}
+
+/// @brief 新建整型临时变量
+Value * InstCombine::newTemp()
+{
+    return func->newTempValue(BasicType::TYPE_INT);
+}
+
+/// @brief 化简一条指令
+/// @param inst 指令
+/// @param prefix 需要在新指令之前插入的指令
+/// @return 化简后的指令，不能化简时返回nullptr
+IRInst * InstCombine::simplify(IRInst * inst, std::vector<IRInst *> & prefix)
+{
+    IRInstOperator op = inst->getOp();
+    Value * dst = inst->getDst();
+    if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_NQ &&
+        static_cast<BinaryIRInst *>(inst)->mode <= 3 && dst != nullptr) {
+        Value * lhs = inst->getSrc1();
+        Value * rhs = inst->getSrc2();
+        if (isCompare(op)) {
+            return simplifyCompare(op, dst, lhs, rhs);
+        }
+        if (isIntValue(dst) && isIntValue(lhs) && isIntValue(rhs)) {
+            return simplifyArith(op, dst, lhs, rhs, prefix);
+        }
+        return nullptr;
+    }
+    if (isNeg(inst) && isIntValue(dst)) {
+        return simplifyNeg(dst, inst->getSrc1());
+    }
+    if (op == IRInstOperator::IRINST_OP_SELECT && dst != nullptr && isIntValue(dst)) {
+        // 条件为常量或两个值相同时即其中一个值
+        Value * trueVal = inst->getSrc()[1];
+        Value * falseVal = inst->getSrc()[2];
+        int32_t cond = 0;
+        if (getConstant(inst->getSrc()[0], cond)) {
+            return makeCopy(dst, cond != 0 ? trueVal : falseVal);
+        }
+        if (trueVal == falseVal) {
+            return makeCopy(dst, trueVal);
+        }
+    }
+    return nullptr;
+}
+
+/// @brief 化简整型加减乘除取余
+IRInst * InstCombine::simplifyArith(IRInstOperator op,
+                                    Value * dst,
+                                    Value * lhs,
+                                    Value * rhs,
+                                    std::vector<IRInst *> & prefix)
+{
+    int32_t lc = 0, rc = 0;
+    bool lk = getConstant(lhs, lc);
+    bool rk = getConstant(rhs, rc);
+
+    // 常量折叠，除零与溢出的除法保留到运行时
+    if (lk && rk) {
+        switch (op) {
+            case IRInstOperator::IRINST_OP_ADD_I:
+                return makeConst(dst, wrapAdd(lc, rc));
+            case IRInstOperator::IRINST_OP_SUB_I:
+                return makeConst(dst, wrapAdd(lc, wrapMul(rc, -1)));
+            case IRInstOperator::IRINST_OP_MULT_I:
+                return makeConst(dst, wrapMul(lc, rc));
+            case IRInstOperator::IRINST_OP_DIV_I:
+            case IRInstOperator::IRINST_OP_MOD_I:
+                if (rc == 0 || (lc == INT_MIN && rc == -1)) {
+                    return nullptr;
+                }
+                return makeConst(dst, op == IRInstOperator::IRINST_OP_DIV_I ? lc / rc : lc % rc);
+            default:
+                return nullptr;
+        }
+    }
+
+    // 交换律运算的常量放到右侧，减常量改为加负常量
+    if (lk && (op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_MULT_I)) {
+        return makeBinary(op, dst, rhs, lc);
+    }
+    if (rk && op == IRInstOperator::IRINST_OP_SUB_I && rc != INT_MIN) {
+        return makeBinary(IRInstOperator::IRINST_OP_ADD_I, dst, lhs, -rc);
+    }
+
+    IRInst * lhsDef = getDef(lhs);
+    IRInst * rhsDef = getDef(rhs);
+    int32_t c = 0;
+    switch (op) {
+        case IRInstOperator::IRINST_OP_ADD_I:
+            if (rk) {
+                if (rc == 0) {
+                    return makeCopy(dst, lhs);
+                }
+                // (y + c1) + c2 => y + (c1 + c2)
+                if (isPlainBinary(lhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(lhsDef->getSrc2(), c)) {
+                    return makeBinary(op, dst, lhsDef->getSrc1(), wrapAdd(c, rc));
+                }
+                // (c1 - y) + c2 => (c1 + c2) - y
+                if (isPlainBinary(lhsDef, IRInstOperator::IRINST_OP_SUB_I) && getConstant(lhsDef->getSrc1(), c)) {
+                    return makeBinary(IRInstOperator::IRINST_OP_SUB_I,
+                                      dst,
+                                      symtab.newConstValue(wrapAdd(c, rc)),
+                                      lhsDef->getSrc2());
+                }
+                // -y + c => c - y
+                if (isNeg(lhsDef)) {
+                    return makeBinary(IRInstOperator::IRINST_OP_SUB_I, dst, rhs, lhsDef->getSrc1());
+                }
+                break;
+            }
+            // x + (-y) => x - y
+            if (isNeg(rhsDef)) {
+                return makeBinary(IRInstOperator::IRINST_OP_SUB_I, dst, lhs, rhsDef->getSrc1());
+            }
+            if (isNeg(lhsDef)) {
+                return makeBinary(IRInstOperator::IRINST_OP_SUB_I, dst, rhs, lhsDef->getSrc1());
+            }
+            // (y + c) + x => (y + x) + c，常量移到外层继续合并
+            if (isPlainBinary(lhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(lhsDef->getSrc2(), c) &&
+                reassociate && hasOneUse(lhs)) {
+                Value * temp = newTemp();
+                prefix.push_back(makeBinary(op, temp, lhsDef->getSrc1(), rhs));
+                return makeBinary(op, dst, temp, c);
+            }
+            if (isPlainBinary(rhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(rhsDef->getSrc2(), c) &&
+                reassociate && hasOneUse(rhs)) {
+                Value * temp = newTemp();
+                prefix.push_back(makeBinary(op, temp, lhs, rhsDef->getSrc1()));
+                return makeBinary(op, dst, temp, c);
+            }
+            break;
+
+        case IRInstOperator::IRINST_OP_SUB_I:
+            if (lhs == rhs) {
+                return makeConst(dst, 0);
+            }
+            if (lk && lc == 0) {
+                return makeNeg(dst, rhs);
+            }
+            // x - (-y) => x + y
+            if (isNeg(rhsDef)) {
+                return makeBinary(IRInstOperator::IRINST_OP_ADD_I, dst, lhs, rhsDef->getSrc1());
+            }
+            if (lk) {
+                // c1 - (z + c2) => (c1 - c2) - z
+                if (isPlainBinary(rhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(rhsDef->getSrc2(), c)) {
+                    return makeBinary(op, dst, symtab.newConstValue(wrapAdd(lc, wrapMul(c, -1))), rhsDef->getSrc1());
+                }
+                // c1 - (c2 - z) => z + (c1 - c2)
+                if (isPlainBinary(rhsDef, IRInstOperator::IRINST_OP_SUB_I) && getConstant(rhsDef->getSrc1(), c)) {
+                    return makeBinary(IRInstOperator::IRINST_OP_ADD_I,
+                                      dst,
+                                      rhsDef->getSrc2(),
+                                      wrapAdd(lc, wrapMul(c, -1)));
+                }
+                break;
+            }
+            // (y + c) - x => (y - x) + c
+            if (isPlainBinary(lhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(lhsDef->getSrc2(), c) &&
+                reassociate && hasOneUse(lhs)) {
+                Value * temp = newTemp();
+                prefix.push_back(makeBinary(op, temp, lhsDef->getSrc1(), rhs));
+                return makeBinary(IRInstOperator::IRINST_OP_ADD_I, dst, temp, c);
+            }
+            // x - (z + c) => (x - z) - c
+            if (isPlainBinary(rhsDef, IRInstOperator::IRINST_OP_ADD_I) && getConstant(rhsDef->getSrc2(), c) &&
+                c != INT_MIN && reassociate && hasOneUse(rhs)) {
+                Value * temp = newTemp();
+                prefix.push_back(makeBinary(op, temp, lhs, rhsDef->getSrc1()));
+                return makeBinary(IRInstOperator::IRINST_OP_ADD_I, dst, temp, -c);
+            }
+            break;
+
+        case IRInstOperator::IRINST_OP_MULT_I:
+            if (!rk) {
+                break;
+            }
+            if (rc == 0) {
+                return makeConst(dst, 0);
+            }
+            if (rc == 1) {
+                return makeCopy(dst, lhs);
+            }
+            if (rc == -1) {
+                return makeNeg(dst, lhs);
+            }
+            // (y * c1) * c2 => y * (c1 * c2)
+            if (isPlainBinary(lhsDef, IRInstOperator::IRINST_OP_MULT_I) && getConstant(lhsDef->getSrc2(), c)) {
+                return makeBinary(op, dst, lhsDef->getSrc1(), wrapMul(c, rc));
+            }
+            // (-y) * c => y * (-c)
+            if (isNeg(lhsDef)) {
+                return makeBinary(op, dst, lhsDef->getSrc1(), wrapMul(rc, -1));
+            }
+            break;
+
+        case IRInstOperator::IRINST_OP_DIV_I:
+            if (rk && rc == 1) {
+                return makeCopy(dst, lhs);
+            }
+            if (rk && rc == -1) {
+                return makeNeg(dst, lhs);
+            }
+            break;
+
+        case IRInstOperator::IRINST_OP_MOD_I:
+            if (rk && (rc == 1 || rc == -1)) {
+                return makeConst(dst, 0);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    // 经复制得到的常量直接使用字面量
+    if (rk && !isIntLiteral(rhs)) {
+        return makeBinary(op, dst, lhs, rc);
+    }
+    if (lk && !isIntLiteral(lhs)) {
+        return makeBinary(op, dst, symtab.newConstValue(lc), rhs);
+    }
+    return nullptr;
+}
+
+/// @brief 化简整型取负
+IRInst * InstCombine::simplifyNeg(Value * dst, Value * src)
+{
+    int32_t c = 0;
+    if (getConstant(src, c)) {
+        return makeConst(dst, wrapMul(c, -1));
+    }
+    IRInst * def = getDef(src);
+    // -(-y) => y
+    if (isNeg(def)) {
+        return makeCopy(dst, def->getSrc1());
+    }
+    // -(y - z) => z - y
+    if (isPlainBinary(def, IRInstOperator::IRINST_OP_SUB_I) && isIntValue(def->getDst())) {
+        return makeBinary(IRInstOperator::IRINST_OP_SUB_I, dst, def->getSrc2(), def->getSrc1());
+    }
+    // -(y + c) => (-c) - y
+    if (isPlainBinary(def, IRInstOperator::IRINST_OP_ADD_I) && isIntValue(def->getDst()) &&
+        getConstant(def->getSrc2(), c) && c != INT_MIN) {
+        return makeBinary(IRInstOperator::IRINST_OP_SUB_I, dst, symtab.newConstValue(-c), def->getSrc1());
+    }
+    return nullptr;
+}
+
+/// @brief 化简整型比较
+IRInst * InstCombine::simplifyCompare(IRInstOperator op, Value * dst, Value * lhs, Value * rhs)
+{
+    bool equality = op == IRInstOperator::IRINST_OP_EQ || op == IRInstOperator::IRINST_OP_NQ;
+    bool lhsBool = lhs->type.type == BasicType::TYPE_BOOL && !lhs->isliteral();
+    if (!(isIntValue(lhs) || (equality && lhsBool)) || !isIntValue(rhs)) {
+        return nullptr;
+    }
+
+    int32_t lc = 0, rc = 0;
+    bool lk = getConstant(lhs, lc);
+    bool rk = getConstant(rhs, rc);
+    if (lk && rk) {
+        return makeConst(dst, evalCompare(op, lc, rc) ? 1 : 0);
+    }
+    if (lk) {
+        return makeBinary(swapCompare(op), dst, rhs, lc);
+    }
+    if (lhs == rhs) {
+        bool reflexive = op == IRInstOperator::IRINST_OP_LE || op == IRInstOperator::IRINST_OP_BE ||
+                         op == IRInstOperator::IRINST_OP_EQ;
+        return makeConst(dst, reflexive ? 1 : 0);
+    }
+    if (!rk) {
+        return nullptr;
+    }
+
+    IRInst * def = getDef(lhs);
+    int32_t c = 0;
+    // y + c1 cmp c2 => y cmp c2 - c1；相等比较在回绕下同样成立，大小比较要求y + c1不回绕且差不溢出
+    if (isPlainBinary(def, IRInstOperator::IRINST_OP_ADD_I) && isIntValue(def->getDst()) &&
+        getConstant(def->getSrc2(), c)) {
+        int64_t diff = (int64_t) rc - c;
+        if (equality) {
+            return makeBinary(op, dst, def->getSrc1(), wrapAdd(rc, wrapMul(c, -1)));
+        }
+        IntRange range;
+        if (diff >= INT_MIN && diff <= INT_MAX && ranges != nullptr && ranges->getResultRange(def, range) &&
+            range.fitsInt32()) {
+            return makeBinary(op, dst, def->getSrc1(), (int32_t) diff);
+        }
+    }
+    if (equality) {
+        // y - z == 0 => y == z
+        if (rc == 0 && isPlainBinary(def, IRInstOperator::IRINST_OP_SUB_I) && isIntValue(def->getDst())) {
+            return makeBinary(op, dst, def->getSrc1(), def->getSrc2());
+        }
+        // -y == c => y == -c
+        if (isNeg(def)) {
+            return makeBinary(op, dst, def->getSrc1(), wrapMul(rc, -1));
+        }
+        // 比较结果与0、1的相等比较即原比较或其取反，!(a < b) => a >= b
+        if (def != nullptr && isCompare(def->getOp()) && static_cast<BinaryIRInst *>(def)->mode <= 3 &&
+            (rc == 0 || rc == 1) && isIntValue(def->getSrc2()) &&
+            (isIntValue(def->getSrc1()) || def->getSrc1()->type.type == BasicType::TYPE_BOOL)) {
+            bool same = (op == IRInstOperator::IRINST_OP_EQ) == (rc == 1);
+            IRInstOperator defOp = def->getOp();
+            return makeBinary(same ? defOp : invertCompare(defOp), dst, def->getSrc1(), def->getSrc2());
+        }
+    }
+
+    if (!isIntLiteral(rhs)) {
+        return makeBinary(op, dst, lhs, rc);
+    }
+    return nullptr;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file InstCombine.h
+ * @brief 代数化简与重结合：常量折叠、恒等式消去、取负链消去、结合链中常量的合并以及比较的化简
+ *
+ * 在基本块内按顺序处理，操作数在块内的定值指令之后未被重新定值时，可以沿定值指令向上匹配。
+ * const全局标量的读取先替换为初值的字面量。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "FunctionCFG.h"
+#include "ValueRange.h"
+
+/// @brief 基于规则的代数化简
+class InstCombine {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _reassociate 是否把结合链中的常量移到最外层
+    InstCombine(Function * _func, bool _reassociate = true);
+
+    /// @brief 化简函数内的整型运算
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 化简一个基本块
+    /// @return true：基本块被修改
+    bool combineBlock(IRBlock * block);
+
+    /// @brief 反复化简一条指令直到不再变化，然后追加到结果中
+    /// @param inst 指令
+    /// @param result 基本块的新指令序列
+    /// @return true：指令被改写
+    bool emit(IRInst * inst, std::vector<IRInst *> & result);
+
+    /// @brief 化简一条指令
+    /// @param inst 指令
+    /// @param prefix 需要在新指令之前插入的指令
+    /// @return 化简后的指令，不能化简时返回nullptr
+    IRInst * simplify(IRInst * inst, std::vector<IRInst *> & prefix);
+
+    /// @brief 化简整型加减乘除取余
+    IRInst * simplifyArith(IRInstOperator op, Value * dst, Value * lhs, Value * rhs, std::vector<IRInst *> & prefix);
+
+    /// @brief 化简整型取负
+    IRInst * simplifyNeg(Value * dst, Value * src);
+
+    /// @brief 化简整型比较
+    IRInst * simplifyCompare(IRInstOperator op, Value * dst, Value * lhs, Value * rhs);
+
+    /// @brief 获取变量在当前位置仍然有效的块内定值指令，其操作数在定值之后没有被重新定值
+    IRInst * getDef(Value * val);
+
+    /// @brief 变量在当前位置是否等于整型常量
+    bool getConstant(Value * val, int32_t & value);
+
+    /// @brief 变量是否只被使用一次，重结合时不会重复计算
+    bool hasOneUse(Value * val);
+
+    /// @brief 更新指令操作数的使用次数
+    void countUses(IRInst * inst, int delta);
+
+    /// @brief 新建整型临时变量
+    Value * newTemp();
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 是否把结合链中的常量移到最外层
+    bool reassociate;
+
+    /// @brief 变量在函数内的使用次数
+    std::unordered_map<Value *, int> useCounts;
+
+    /// @brief 变量在块内最后一次定值的位置
+    std::unordered_map<Value *, int> defPositions;
+
+    /// @brief 变量在块内最后一次定值的指令
+    std::unordered_map<Value *, IRInst *> defInsts;
+
+    /// @brief 当前指令在块内的位置
+    int position = 0;
+
+    /// @brief 整型值域分析，函数没有大小比较时为nullptr
+    ValueRange * ranges = nullptr;
+};
@@ -0,0 +1,634 @@
+/**
+ * @file PartialRedundancyElimination.cpp
+ * @brief 部分冗余消除（惰性代码移动）：在控制流图上求解可用表达式与可预期表达式，
+ * 把只在部分路径上冗余的整型运算移动到最晚的安全位置，原来的运算改为从保存变量复制
+ */
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include "PartialRedundancyElimination.h"
+#include "LoopInfo.h"
+
+/// @brief 表达式的键：运算符以及两个操作数，字面量按值区分
+using ExprKey = std::tuple<int, Value *, int32_t, Value *, int32_t>;
+
+/// @brief 是否可以作为表达式的操作数：整型字面量或者非浮点的标量变量
+static bool isCandidateOperand(Value * val)
+{
+    if (isIntLiteral(val)) {
+        return true;
+    }
+    return isScalarVar(val) && val->type.type != BasicType::TYPE_FLOAT;
+}
+
+/// @brief 是否是可以移动的运算：操作数与结果都是整型标量的加减乘除取余
+/// @details 比较运算的结果通常与紧随其后的条件跳转合并生成，不参与移动
+static bool isCandidateInst(IRInst * inst)
+{
+    IRInstOperator op = inst->getOp();
+    if (op < IRInstOperator::IRINST_OP_ADD_I || op > IRInstOperator::IRINST_OP_MULT_I ||
+        static_cast<BinaryIRInst *>(inst)->mode > 3) {
+        return false;
+    }
+    Value * dst = inst->getDst();
+    if (!isScalarVar(dst) || dst->type.type != BasicType::TYPE_INT) {
+        return false;
+    }
+    return isCandidateOperand(inst->getSrc1()) && isCandidateOperand(inst->getSrc2());
+}
+
+/// @brief 集合a与b的交集保存到a
+static void intersectWith(ExprSet & a, const ExprSet & b)
+{
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = a[i] && b[i];
+    }
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+/// @param _maxLoopHolders 每层循环内跨基本块的保存变量的最大个数
+PartialRedundancyElimination::PartialRedundancyElimination(Function * _func, int _maxLoopHolders)
+    : func(_func), maxLoopHolders(_maxLoopHolders)
+{}
+
+/// @brief 消除函数内的部分冗余运算
+/// @return true：函数的IR被修改
+bool PartialRedundancyElimination::run()
+{
+    FunctionCFG cfg(func);
+    cfg.computeDominators();
+
+    // 入口块有前驱时没有可以插入运算的入口边
+    blocks = cfg.getRPO();
+    if (blocks.empty() || !blocks.front()->preds.empty()) {
+        return false;
+    }
+
+    // 不可达的前驱不参与数据流方程，其中的指令也保持不变
+    std::unordered_map<IRBlock *, int> indices;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        indices[blocks[i]] = (int) i;
+    }
+    succs.assign(blocks.size(), {});
+    preds.assign(blocks.size(), {});
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (auto succ: blocks[i]->succs) {
+            int index = indices.at(succ);
+            if (std::find(succs[i].begin(), succs[i].end(), index) == succs[i].end()) {
+                succs[i].push_back(index);
+                preds[index].push_back((int) i);
+            }
+        }
+    }
+
+    collectExprs();
+    if (exprs.empty()) {
+        return false;
+    }
+    computeLocalSets();
+    solve();
+
+    if (!transform(cfg)) {
+        return false;
+    }
+    cfg.writeBack();
+    return true;
+}
+
+/// @brief 收集可以移动的整型运算，按运算符与操作数归并为表达式
+void PartialRedundancyElimination::collectExprs()
+{
+    auto keyOf = [](Value * val, Value *& var, int32_t & literal) {
+        if (val->isliteral()) {
+            var = nullptr;
+            literal = val->intVal;
+        } else {
+            var = val;
+            literal = 0;
+        }
+    };
+
+    std::map<ExprKey, std::vector<IRInst *>> groups;
+    for (auto block: blocks) {
+        for (auto inst: block->insts) {
+            if (!isCandidateInst(inst)) {
+                continue;
+            }
+            ExprKey key;
+            std::get<0>(key) = (int) inst->getOp();
+            keyOf(inst->getSrc1(), std::get<1>(key), std::get<2>(key));
+            keyOf(inst->getSrc2(), std::get<3>(key), std::get<4>(key));
+            groups[key].push_back(inst);
+        }
+    }
+
+    for (auto & group: groups) {
+        CandidateExpr expr;
+        for (auto src: {group.second.front()->getSrc1(), group.second.front()->getSrc2()}) {
+            if (!src->isliteral() && std::find(expr.operands.begin(), expr.operands.end(), src) == expr.operands.end()) {
+                expr.operands.push_back(src);
+            }
+        }
+        for (auto inst: group.second) {
+            Value * dst = inst->getDst();
+            if (std::find(expr.operands.begin(), expr.operands.end(), dst) == expr.operands.end()) {
+                expr.proto = inst;
+                break;
+            }
+        }
+        // 形如x = x + 1的运算没有可以复制到插入位置的形式
+        if (expr.proto == nullptr) {
+            continue;
+        }
+
+        int index = (int) exprs.size();
+        for (auto inst: group.second) {
+            occurrences[inst] = index;
+        }
+        for (auto operand: expr.operands) {
+            exprsOfOperand[operand].push_back(index);
+        }
+        exprs.push_back(expr);
+    }
+}
+
+/// @brief 计算每个基本块的局部属性：向上暴露的运算、向下暴露的运算以及不修改操作数的表达式
+void PartialRedundancyElimination::computeLocalSets()
+{
+    size_t count = exprs.size();
+    antLoc.assign(blocks.size(), ExprSet(count, false));
+    comp.assign(blocks.size(), ExprSet(count, false));
+    transp.assign(blocks.size(), ExprSet(count, true));
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (auto inst: blocks[i]->insts) {
+            auto pIter = occurrences.find(inst);
+            if (pIter != occurrences.end()) {
+                if (transp[i][pIter->second]) {
+                    antLoc[i][pIter->second] = true;
+                }
+                comp[i][pIter->second] = true;
+            }
+
+            // 运算先使用操作数再定值，x = x + 1在计算之后立即失效
+            Value * def = getInstDef(inst);
+            auto kIter = def == nullptr ? exprsOfOperand.end() : exprsOfOperand.find(def);
+            if (kIter != exprsOfOperand.end()) {
+                for (int expr: kIter->second) {
+                    transp[i][expr] = false;
+                    comp[i][expr] = false;
+                }
+            }
+        }
+    }
+
+    // 加减法重新计算的代价不及跨块保存变量占用寄存器的代价，只合并块内的重复运算，不做跨块的移动
+    for (size_t e = 0; e < count; e++) {
+        IRInstOperator op = exprs[e].proto->getOp();
+        if (op == IRInstOperator::IRINST_OP_ADD_I || op == IRInstOperator::IRINST_OP_SUB_I) {
+            for (size_t i = 0; i < blocks.size(); i++) {
+                antLoc[i][e] = false;
+                transp[i][e] = false;
+            }
+        }
+    }
+}
+
+/// @brief 求解可用、可预期、最早、推迟等数据流方程，得到插入边与可删除的块
+void PartialRedundancyElimination::solve()
+{
+    size_t count = exprs.size();
+    size_t n = blocks.size();
+    const ExprSet empty(count, false);
+
+    // 可用表达式：前向，交汇取交集，入口块入口为空
+    availOut.assign(n, ExprSet(count, true));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 0; i < n; i++) {
+            ExprSet in = preds[i].empty() ? empty : availOut[preds[i].front()];
+            for (int pred: preds[i]) {
+                intersectWith(in, availOut[pred]);
+            }
+            ExprSet out(count);
+            for (size_t e = 0; e < count; e++) {
+                out[e] = comp[i][e] || (in[e] && transp[i][e]);
+            }
+            if (out != availOut[i]) {
+                availOut[i] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+
+    // 可预期表达式：后向，交汇取交集，出口块出口为空
+    antIn.assign(n, ExprSet(count, true));
+    antOut.assign(n, ExprSet(count, false));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = n; i-- > 0;) {
+            ExprSet out = succs[i].empty() ? empty : antIn[succs[i].front()];
+            for (int succ: succs[i]) {
+                intersectWith(out, antIn[succ]);
+            }
+            ExprSet in(count);
+            for (size_t e = 0; e < count; e++) {
+                in[e] = antLoc[i][e] || (out[e] && transp[i][e]);
+            }
+            antOut[i] = std::move(out);
+            if (in != antIn[i]) {
+                antIn[i] = std::move(in);
+                changed = true;
+            }
+        }
+    }
+
+    // 最早插入位置：表达式在边的终点可预期，而在起点不可用，且无法再提前到起点之前
+    std::vector<std::vector<ExprSet>> earliest(n);
+    for (size_t p = 0; p < n; p++) {
+        for (int s: succs[p]) {
+            ExprSet set(count);
+            for (size_t e = 0; e < count; e++) {
+                set[e] = antIn[s][e] && !availOut[p][e] && (!transp[p][e] || !antOut[p][e]);
+            }
+            earliest[p].push_back(std::move(set));
+        }
+    }
+
+    // 推迟：插入点沿着不计算该表达式的路径尽量下移，入口块的入口边上最早位置即可预期的全部表达式
+    laterIn.assign(n, ExprSet(count, true));
+    laterIn[0] = antIn[0];
+    auto later = [&](int p, size_t k, size_t e) {
+        return earliest[p][k][e] || (laterIn[p][e] && !antLoc[p][e]);
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 1; i < n; i++) {
+            ExprSet in(count, true);
+            for (int pred: preds[i]) {
+                size_t k = std::find(succs[pred].begin(), succs[pred].end(), (int) i) - succs[pred].begin();
+                for (size_t e = 0; e < count; e++) {
+                    in[e] = in[e] && later(pred, k, e);
+                }
+            }
+            if (in != laterIn[i]) {
+                laterIn[i] = std::move(in);
+                changed = true;
+            }
+        }
+    }
+
+    inserts.assign(n, {});
+    deletes.assign(n, ExprSet(count, false));
+    for (size_t p = 0; p < n; p++) {
+        for (size_t k = 0; k < succs[p].size(); k++) {
+            ExprSet set(count);
+            for (size_t e = 0; e < count; e++) {
+                set[e] = later((int) p, k, e) && !laterIn[succs[p][k]][e];
+            }
+            inserts[p].push_back(std::move(set));
+        }
+        if (p != 0) {
+            for (size_t e = 0; e < count; e++) {
+                deletes[p][e] = antLoc[p][e] && !laterIn[p][e];
+            }
+        }
+    }
+}
+
+/// @brief 按求解结果插入运算并改写原来的运算
+/// @param cfg 控制流图
+/// @return true：有运算被改写
+bool PartialRedundancyElimination::transform(FunctionCFG & cfg)
+{
+    size_t count = exprs.size();
+    size_t n = blocks.size();
+
+    // 保存变量的需求：从删除了运算的块向上，直到插入点或者重新计算该表达式的运算为止
+    std::vector<ExprSet> needIn(n, ExprSet(count, false));
+    std::vector<ExprSet> needOut(n, ExprSet(count, false));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = n; i-- > 0;) {
+            ExprSet out(count, false);
+            for (size_t k = 0; k < succs[i].size(); k++) {
+                for (size_t e = 0; e < count; e++) {
+                    out[e] = out[e] || (needIn[succs[i][k]][e] && !inserts[i][k][e]);
+                }
+            }
+            ExprSet in(count);
+            for (size_t e = 0; e < count; e++) {
+                in[e] = deletes[i][e] || (transp[i][e] && !antLoc[i][e] && out[e]);
+            }
+            needOut[i] = std::move(out);
+            if (in != needIn[i]) {
+                needIn[i] = std::move(in);
+                changed = true;
+            }
+        }
+    }
+
+    inSlots.assign(n, {});
+    outSlots.assign(n, {});
+    bool changed = false;
+    for (size_t i = 0; i < n; i++) {
+        changed |= planBlock((int) i, needIn[i], needOut[i]);
+    }
+    if (!changed) {
+        return false;
+    }
+
+    // 沿边流入后继块的值与块出口或边上插入的值合并为同一个槽
+    std::vector<std::vector<std::vector<std::pair<int, int>>>> edgeDefs(n);
+    for (size_t p = 0; p < n; p++) {
+        edgeDefs[p].resize(succs[p].size());
+        for (size_t k = 0; k < succs[p].size(); k++) {
+            for (size_t e = 0; e < count; e++) {
+                if (inserts[p][k][e]) {
+                    edgeDefs[p][k].emplace_back((int) e, newSlot());
+                }
+            }
+            for (auto & in: inSlots[succs[p][k]]) {
+                auto dIter = std::find_if(edgeDefs[p][k].begin(), edgeDefs[p][k].end(), [&in](std::pair<int, int> & def) {
+                    return def.first == in.first;
+                });
+                if (dIter != edgeDefs[p][k].end()) {
+                    uniteSlots(dIter->second, in.second);
+                    continue;
+                }
+                auto pIter = outSlots[p].find(in.first);
+                if (pIter == outSlots[p].end()) {
+                    // 有路径到达时保存变量无效，放弃改写
+                    return false;
+                }
+                uniteSlots(pIter->second, in.second);
+            }
+        }
+    }
+
+    selectHolders(cfg, edgeDefs);
+    reuseResults(edgeDefs);
+
+    for (auto block: blocks) {
+        applyBlock(block);
+    }
+
+    // 在边上插入运算：唯一后继的边插入到起点的块尾，关键边拆分出新的基本块
+    for (size_t p = 0; p < n; p++) {
+        IRBlock * pred = blocks[p];
+        for (size_t k = 0; k < succs[p].size(); k++) {
+            std::vector<IRInst *> defs;
+            for (auto & def: edgeDefs[p][k]) {
+                if (!rejected.count(findSlot(def.second))) {
+                    defs.push_back(makeHolderDef(def.first, def.second));
+                }
+            }
+
+            if (defs.empty()) {
+                continue;
+            }
+
+            IRBlock * succ = blocks[succs[p][k]];
+            if (succs[p].size() == 1) {
+                auto pos = pred->getTerminator() != nullptr ? pred->insts.end() - 1 : pred->insts.end();
+                pred->insts.insert(pos, defs.begin(), defs.end());
+            } else {
+                IRBlock * split = cfg.createBlock(pred);
+                split->insts = defs;
+                split->insts.push_back(new BrIRInst(succ->label));
+                replaceBranchTarget(pred->getTerminator(), succ->label, split->label);
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief 选择跨基本块的保存变量：后端按循环分配寄存器，跨块的变量在所在的每层循环内都占用一个寄存器，
+/// 每层循环只保留收益最大的几个，其余的恢复为原来的运算
+/// @param cfg 控制流图
+/// @param edgeDefs 每条后继边上插入的表达式与槽
+void PartialRedundancyElimination::selectHolders(
+    FunctionCFG & cfg, std::vector<std::vector<std::vector<std::pair<int, int>>>> & edgeDefs)
+{
+    // 每个跨块槽集合出现的基本块，以及按循环深度加权的被删除运算的个数
+    std::unordered_map<int, std::unordered_set<IRBlock *>> webBlocks;
+    std::unordered_map<int, int64_t> benefits;
+    LoopInfo loopInfo(&cfg);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (auto & slot: inSlots[i]) {
+            webBlocks[findSlot(slot.second)].insert(blocks[i]);
+        }
+        for (auto & slot: outSlots[i]) {
+            webBlocks[findSlot(slot.second)].insert(blocks[i]);
+        }
+        for (auto & defs: edgeDefs[i]) {
+            for (auto & def: defs) {
+                webBlocks[findSlot(def.second)].insert(blocks[i]);
+            }
+        }
+        int64_t weight = 1;
+        for (int d = loopInfo.getLoopDepth(blocks[i]); d > 0 && weight < (1 << 18); d--) {
+            weight *= 8;
+        }
+        for (auto inst: blocks[i]->insts) {
+            auto pIter = plans.find(inst);
+            if (pIter != plans.end() && !pIter->second.second) {
+                benefits[findSlot(pIter->second.first)] += weight;
+            }
+        }
+    }
+
+    std::vector<int> webs;
+    for (auto & web: webBlocks) {
+        webs.push_back(web.first);
+    }
+    std::sort(webs.begin(), webs.end(), [&benefits](int a, int b) {
+        return benefits[a] != benefits[b] ? benefits[a] > benefits[b] : a < b;
+    });
+
+    std::unordered_map<Loop *, int> holderCounts;
+    for (int web: webs) {
+        std::unordered_set<Loop *> loops;
+        for (auto block: webBlocks[web]) {
+            for (Loop * loop = loopInfo.getLoopFor(block); loop != nullptr; loop = loop->parent) {
+                loops.insert(loop);
+            }
+        }
+        bool fits = std::all_of(loops.begin(), loops.end(), [this, &holderCounts](Loop * loop) {
+            return holderCounts[loop] < maxLoopHolders;
+        });
+        if (!fits) {
+            rejected.insert(web);
+            continue;
+        }
+        for (auto loop: loops) {
+            holderCounts[loop]++;
+        }
+    }
+}
+
+/// @brief 只有一个定值点的槽集合，定值的运算结果是只定值一次的临时变量时，直接用它作为保存变量，省去复制
+/// @param edgeDefs 每条后继边上插入的表达式与槽
+void PartialRedundancyElimination::reuseResults(std::vector<std::vector<std::vector<std::pair<int, int>>>> & edgeDefs)
+{
+    std::unordered_map<Value *, int> defCounts;
+    for (auto inst: func->getInterCode().getInsts()) {
+        Value * def = getInstDef(inst);
+        if (def != nullptr) {
+            defCounts[def]++;
+        }
+    }
+
+    std::unordered_map<int, int> webDefCounts;
+    std::unordered_map<int, IRInst *> webDefs;
+    for (auto & edges: edgeDefs) {
+        for (auto & defs: edges) {
+            for (auto & def: defs) {
+                webDefCounts[findSlot(def.second)]++;
+            }
+        }
+    }
+    for (auto & plan: plans) {
+        if (plan.second.second) {
+            int web = findSlot(plan.second.first);
+            webDefCounts[web]++;
+            webDefs[web] = plan.first;
+        }
+    }
+
+    for (auto & web: webDefs) {
+        Value * dst = web.second->getDst();
+        if (webDefCounts[web.first] == 1 && dst->isTemp() && defCounts[dst] == 1) {
+            slotHolders[web.first] = dst;
+        }
+    }
+}
+
+/// @brief 规划一个基本块内运算的改写，记录块入口与出口处有效的保存变量所在的槽
+/// @param index 基本块的编号
+/// @param needIn 块入口处保存变量有效的表达式
+/// @param needOut 块出口处需要保存变量有效的表达式
+/// @return true：有运算需要改写
+bool PartialRedundancyElimination::planBlock(int index, const ExprSet & needIn, const ExprSet & needOut)
+{
+    std::vector<IRInst *> & insts = blocks[index]->insts;
+
+    // 逆序确定每个运算的结果之后是否还会被块内的运算或者后继块使用
+    std::vector<bool> save(insts.size(), false);
+    ExprSet need = needOut;
+    for (size_t i = insts.size(); i-- > 0;) {
+        Value * def = getInstDef(insts[i]);
+        auto kIter = def == nullptr ? exprsOfOperand.end() : exprsOfOperand.find(def);
+        if (kIter != exprsOfOperand.end()) {
+            for (int expr: kIter->second) {
+                need[expr] = false;
+            }
+        }
+        auto pIter = occurrences.find(insts[i]);
+        if (pIter != occurrences.end()) {
+            save[i] = need[pIter->second];
+            need[pIter->second] = true;
+        }
+    }
+
+    // 顺序规划：保存变量有效时改为复制，否则在需要时计算到新的槽中
+    bool changed = false;
+    std::unordered_map<int, int> current;
+    for (size_t e = 0; e < needIn.size(); e++) {
+        if (needIn[e]) {
+            current[(int) e] = newSlot();
+        }
+    }
+    inSlots[index] = current;
+    for (size_t i = 0; i < insts.size(); i++) {
+        auto pIter = occurrences.find(insts[i]);
+        if (pIter != occurrences.end()) {
+            auto cIter = current.find(pIter->second);
+            if (cIter != current.end()) {
+                plans[insts[i]] = {cIter->second, false};
+                changed = true;
+            } else if (save[i]) {
+                int slot = newSlot();
+                plans[insts[i]] = {slot, true};
+                current[pIter->second] = slot;
+                changed = true;
+            }
+        }
+
+        Value * def = getInstDef(insts[i]);
+        auto kIter = def == nullptr ? exprsOfOperand.end() : exprsOfOperand.find(def);
+        if (kIter != exprsOfOperand.end()) {
+            for (int expr: kIter->second) {
+                current.erase(expr);
+            }
+        }
+    }
+    outSlots[index] = current;
+    return changed;
+}
+
+/// @brief 按规划改写一个基本块：保存变量有效时改为复制，否则先计算到保存变量再复制
+void PartialRedundancyElimination::applyBlock(IRBlock * block)
+{
+    std::vector<IRInst *> result;
+    for (auto inst: block->insts) {
+        auto pIter = plans.find(inst);
+        if (pIter == plans.end() || rejected.count(findSlot(pIter->second.first))) {
+            result.push_back(inst);
+            continue;
+        }
+        int slot = pIter->second.first;
+        if (pIter->second.second) {
+            if (getHolder(slot) == inst->getDst()) {
+                result.push_back(inst);
+                continue;
+            }
+            result.push_back(makeHolderDef(occurrences[inst], slot));
+        }
+        result.push_back(new AssignIRInst(inst->getDst(), getHolder(slot), 0));
+    }
+    block->insts.swap(result);
+}
+
+/// @brief 新建一个槽
+int PartialRedundancyElimination::newSlot()
+{
+    slotParents.push_back((int) slotParents.size());
+    return (int) slotParents.size() - 1;
+}
+
+/// @brief 查找槽所在集合的代表
+int PartialRedundancyElimination::findSlot(int slot)
+{
+    while (slotParents[slot] != slot) {
+        slotParents[slot] = slotParents[slotParents[slot]];
+        slot = slotParents[slot];
+    }
+    return slot;
+}
+
+/// @brief 合并两个槽
+void PartialRedundancyElimination::uniteSlots(int a, int b)
+{
+    slotParents[findSlot(a)] = findSlot(b);
+}
+
+/// @brief 获取槽的保存变量，同一集合的槽共用一个，第一次使用时新建
+Value * PartialRedundancyElimination::getHolder(int slot)
+{
+    Value *& holder = slotHolders[findSlot(slot)];
+    if (holder == nullptr) {
+        holder = func->newTempValue(BasicType::TYPE_INT);
+    }
+    return holder;
+}
+
+/// @brief 生成把表达式的值保存到槽的保存变量的指令
+IRInst * PartialRedundancyElimination::makeHolderDef(int expr, int slot)
+{
+    std::unordered_map<Value *, Value *> valueMap{{exprs[expr].proto->getDst(), getHolder(slot)}};
+    std::unordered_map<IRInst *, IRInst *> labelMap;
+    return cloneInst(exprs[expr].proto, valueMap, labelMap);
+}
@@ -0,0 +1,161 @@
+/**
+ * @file PartialRedundancyElimination.h
+ * @brief 部分冗余消除（惰性代码移动）：在控制流图上求解可用表达式与可预期表达式，
+ * 把只在部分路径上冗余的整型运算移动到最晚的安全位置，原来的运算改为从保存变量复制
+ *
+ * 同一基本块内重复出现的运算也一并消除，加减法只做块内的合并。插入位置只选在表达式在所有后续路径上都会被计算的地方，
+ * 不会在任何一条路径上增加运算次数；需要插入的关键边被拆分为新的基本块。
+ */
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "FunctionCFG.h"
+
+/// @brief 表达式集合，按表达式的编号索引
+using ExprSet = std::vector<bool>;
+
+/// @brief 参与移动的表达式
+struct CandidateExpr {
+    /// @brief 插入计算时复制的指令，其结果变量不是操作数
+    IRInst * proto = nullptr;
+
+    /// @brief 非字面量的操作数，被重新定值时表达式失效
+    std::vector<Value *> operands;
+};
+
+/// @brief 基于惰性代码移动的部分冗余消除
+class PartialRedundancyElimination {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    /// @param _maxLoopHolders 每层循环内跨基本块的保存变量的最大个数
+    PartialRedundancyElimination(Function * _func, int _maxLoopHolders = 2);
+
+    /// @brief 消除函数内的部分冗余运算
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 收集可以移动的整型运算，按运算符与操作数归并为表达式
+    void collectExprs();
+
+    /// @brief 计算每个基本块的局部属性：向上暴露的运算、向下暴露的运算以及不修改操作数的表达式
+    void computeLocalSets();
+
+    /// @brief 求解可用、可预期、最早、推迟等数据流方程，得到插入边与可删除的块
+    void solve();
+
+    /// @brief 按求解结果插入运算并改写原来的运算
+    /// @param cfg 控制流图
+    /// @return true：有运算被改写
+    bool transform(FunctionCFG & cfg);
+
+    /// @brief 选择跨基本块的保存变量，每层循环内只保留收益最大的几个，其余的恢复为原来的运算
+    /// @param cfg 控制流图
+    /// @param edgeDefs 每条后继边上插入的表达式与槽
+    void selectHolders(FunctionCFG & cfg, std::vector<std::vector<std::vector<std::pair<int, int>>>> & edgeDefs);
+
+    /// @brief 只有一个定值点且结果是只定值一次的临时变量的槽集合，直接用该结果作为保存变量
+    /// @param edgeDefs 每条后继边上插入的表达式与槽
+    void reuseResults(std::vector<std::vector<std::vector<std::pair<int, int>>>> & edgeDefs);
+
+    /// @brief 规划一个基本块内运算的改写，记录块入口与出口处有效的保存变量所在的槽
+    /// @param index 基本块的编号
+    /// @param needIn 块入口处保存变量有效的表达式
+    /// @param needOut 块出口处需要保存变量有效的表达式
+    /// @return true：有运算需要改写
+    bool planBlock(int index, const ExprSet & needIn, const ExprSet & needOut);
+
+    /// @brief 按规划改写一个基本块：保存变量有效时改为复制，否则先计算到保存变量再复制
+    void applyBlock(IRBlock * block);
+
+    /// @brief 新建一个槽
+    int newSlot();
+
+    /// @brief 查找槽所在集合的代表
+    int findSlot(int slot);
+
+    /// @brief 合并两个槽
+    void uniteSlots(int a, int b);
+
+    /// @brief 获取槽的保存变量，同一集合的槽共用一个，第一次使用时新建
+    Value * getHolder(int slot);
+
+    /// @brief 生成把表达式的值保存到槽的保存变量的指令
+    IRInst * makeHolderDef(int expr, int slot);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 每层循环内跨基本块的保存变量的最大个数
+    int maxLoopHolders;
+
+    /// @brief 可达基本块的逆后序
+    std::vector<IRBlock *> blocks;
+
+    /// @brief 每个基本块去重后的后继编号
+    std::vector<std::vector<int>> succs;
+
+    /// @brief 每个基本块去重后的前驱编号
+    std::vector<std::vector<int>> preds;
+
+    /// @brief 表达式
+    std::vector<CandidateExpr> exprs;
+
+    /// @brief 运算指令对应的表达式编号
+    std::unordered_map<IRInst *, int> occurrences;
+
+    /// @brief 变量作为操作数出现的表达式
+    std::unordered_map<Value *, std::vector<int>> exprsOfOperand;
+
+    /// @brief 块内在操作数被重新定值之前计算的表达式
+    std::vector<ExprSet> antLoc;
+
+    /// @brief 块内计算之后操作数没有被重新定值的表达式
+    std::vector<ExprSet> comp;
+
+    /// @brief 块内没有修改操作数的表达式
+    std::vector<ExprSet> transp;
+
+    /// @brief 块出口可用的表达式
+    std::vector<ExprSet> availOut;
+
+    /// @brief 块入口可预期的表达式
+    std::vector<ExprSet> antIn;
+
+    /// @brief 块出口可预期的表达式
+    std::vector<ExprSet> antOut;
+
+    /// @brief 块入口处仍可推迟的表达式
+    std::vector<ExprSet> laterIn;
+
+    /// @brief 每条后继边上需要插入的表达式，与succs对齐
+    std::vector<std::vector<ExprSet>> inserts;
+
+    /// @brief 块内第一次计算可以删除的表达式
+    std::vector<ExprSet> deletes;
+
+    /// @brief 保存变量的槽：每个定值点新建一个槽，沿边流入同一位置的槽合并，合并后的槽共用一个保存变量，
+    /// 这样各处互不相关的保存变量不会在整个函数内占用同一个寄存器
+    std::vector<int> slotParents;
+
+    /// @brief 槽集合的代表对应的保存变量
+    std::unordered_map<int, Value *> slotHolders;
+
+    /// @brief 块入口处有效的槽，表达式编号到槽
+    std::vector<std::unordered_map<int, int>> inSlots;
+
+    /// @brief 块出口处有效的槽，表达式编号到槽
+    std::vector<std::unordered_map<int, int>> outSlots;
+
+    /// @brief 放弃的槽集合的代表，其中的运算保持不变
+    std::unordered_set<int> rejected;
+
+    /// @brief 运算的改写规划：使用的槽，以及是否先计算到该槽的保存变量
+    std::unordered_map<IRInst *, std::pair<int, bool>> plans;
+};
@@ -0,0 +1,37 @@
+/**
+ * @file RangeFolding.cpp
+ * @brief 基于值域的折叠：值域分析确定结果只有一个取值的比较与整型运算改为常量赋值
+ */
+#include "RangeFolding.h"
+#include "SymbolTable.h"
+
+extern SymbolTable symtab;
+
+/// @brief 构造函数
+/// @param _func 函数
+RangeFolding::RangeFolding(Function * _func) : func(_func)
+{}
+
+/// @brief 折叠函数内结果确定的运算
+/// @return true：函数的IR被修改
+bool RangeFolding::run()
+{
+    ValueRange ranges(func);
+    ranges.run();
+
+    bool changed = false;
+    for (auto & inst: func->getInterCode().getInsts()) {
+        IntRange range;
+        if (!ranges.getResultRange(inst, range) || !range.isConstant()) {
+            continue;
+        }
+        // 常量的复制已经是折叠后的形式
+        if (inst->getOp() == IRInstOperator::IRINST_OP_ASSIGN && static_cast<AssignIRInst *>(inst)->_flag == 0 &&
+            inst->getSrc1()->isliteral()) {
+            continue;
+        }
+        inst = new AssignIRInst(inst->getDst(), symtab.newConstValue((int32_t) range.lo), 0);
+        changed = true;
+    }
+    return changed;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file RangeFolding.h
+ * @brief 基于值域的折叠：值域分析确定结果只有一个取值的比较与整型运算改为常量赋值
+ */
+#pragma once
+
+#include "ValueRange.h"
+
+/// @brief 基于值域的比较与运算折叠
+class RangeFolding {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    RangeFolding(Function * _func);
+
+    /// @brief 折叠函数内结果确定的运算
+    /// @return true：函数的IR被修改
+    bool run();
+
+private:
+    /// @brief 函数
+    Function * func;
+};
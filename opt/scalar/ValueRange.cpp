@@ -0,0 +1,489 @@
+/**
+ * @file ValueRange.cpp
+ * @brief 整型值域分析：在控制流图上按基本块传播每个标量变量的取值区间，条件跳转的两个出口按比较结果收窄区间
+ *
+ * 回边处经过若干次迭代仍在变化的边界直接放宽到32位整数的边界，保证分析收敛。
+ * 后端的整型运算按64位进行，运算结果的精确区间在32位范围内时，寄存器中的结果已经是符号扩展的。
+ */
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+
+#include "SymbolTable.h"
+#include "ValueRange.h"
+
+/// @brief 入口状态更新超过该次数后，仍在变化的边界放宽到32位整数的边界
+static const int WIDEN_VISITS = 3;
+
+/// @brief 是否是整型或布尔型的标量值，不含浮点数、数组与数组元素地址
+static bool isIntOperand(Value * val)
+{
+    if (isIntLiteral(val)) {
+        return true;
+    }
+    return val != nullptr && !val->isliteral() &&
+           (val->type.type == BasicType::TYPE_INT || val->type.type == BasicType::TYPE_BOOL) && !val->is_numpy &&
+           !val->is_issavenp() && val->np == nullptr;
+}
+
+/// @brief 是否是记录区间的变量：局部或临时的整型标量，全局变量可能被函数调用修改
+static bool isTracked(Value * val)
+{
+    return isScalarVar(val) && val->type.type != BasicType::TYPE_FLOAT;
+}
+
+/// @brief 是否是比较运算
+static bool isCompare(IRInstOperator op)
+{
+    return op >= IRInstOperator::IRINST_OP_LT && op <= IRInstOperator::IRINST_OP_NQ;
+}
+
+/// @brief 结果取反后对应的比较运算
+static IRInstOperator invertCompare(IRInstOperator op)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            return IRInstOperator::IRINST_OP_BE;
+        case IRInstOperator::IRINST_OP_BT:
+            return IRInstOperator::IRINST_OP_LE;
+        case IRInstOperator::IRINST_OP_LE:
+            return IRInstOperator::IRINST_OP_BT;
+        case IRInstOperator::IRINST_OP_BE:
+            return IRInstOperator::IRINST_OP_LT;
+        case IRInstOperator::IRINST_OP_EQ:
+            return IRInstOperator::IRINST_OP_NQ;
+        default:
+            return IRInstOperator::IRINST_OP_EQ;
+    }
+}
+
+/// @brief 比较的结果区间，两侧区间不相交时结果确定
+static IntRange evalCompare(IRInstOperator op, const IntRange & a, const IntRange & b)
+{
+    bool yes = false, no = false;
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            yes = a.hi < b.lo;
+            no = a.lo >= b.hi;
+            break;
+        case IRInstOperator::IRINST_OP_LE:
+            yes = a.hi <= b.lo;
+            no = a.lo > b.hi;
+            break;
+        case IRInstOperator::IRINST_OP_BT:
+            yes = a.lo > b.hi;
+            no = a.hi <= b.lo;
+            break;
+        case IRInstOperator::IRINST_OP_BE:
+            yes = a.lo >= b.hi;
+            no = a.hi < b.lo;
+            break;
+        case IRInstOperator::IRINST_OP_EQ:
+            yes = a.isConstant() && b.isConstant() && a.lo == b.lo;
+            no = a.hi < b.lo || b.hi < a.lo;
+            break;
+        default:
+            yes = a.hi < b.lo || b.hi < a.lo;
+            no = a.isConstant() && b.isConstant() && a.lo == b.lo;
+            break;
+    }
+    if (yes) {
+        return IntRange(1, 1);
+    }
+    if (no) {
+        return IntRange(0, 0);
+    }
+    return IntRange(0, 1);
+}
+
+/// @brief 二元运算结果的精确区间，操作数都在32位范围内，乘积不会超出64位
+static IntRange evalBinary(IRInstOperator op, const IntRange & a, const IntRange & b)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_ADD_I:
+            return IntRange(a.lo + b.lo, a.hi + b.hi);
+        case IRInstOperator::IRINST_OP_SUB_I:
+            return IntRange(a.lo - b.hi, a.hi - b.lo);
+        case IRInstOperator::IRINST_OP_MULT_I: {
+            int64_t corners[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+            return IntRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+        }
+        case IRInstOperator::IRINST_OP_DIV_I: {
+            // 除数符号确定时商在区间的角上取到极值，否则商的绝对值不超过被除数的绝对值
+            if (b.lo > 0 || b.hi < 0) {
+                int64_t corners[] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+                return IntRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+            }
+            int64_t bound = std::max(-a.lo, a.hi);
+            return IntRange(-bound, bound);
+        }
+        case IRInstOperator::IRINST_OP_MOD_I: {
+            // 余数的绝对值不超过被除数的绝对值，除数不为0时还小于除数的绝对值，符号与被除数相同
+            int64_t bound = std::max(-a.lo, a.hi);
+            if (b.lo > 0 || b.hi < 0) {
+                bound = std::min(bound, std::max(-b.lo, b.hi) - 1);
+            }
+            if (a.lo >= 0) {
+                return IntRange(0, std::min(a.hi, bound));
+            }
+            if (a.hi <= 0) {
+                return IntRange(std::max(a.lo, -bound), 0);
+            }
+            return IntRange(-bound, bound);
+        }
+        default:
+            return evalCompare(op, a, b);
+    }
+}
+
+/// @brief 按比较结果收窄两个操作数的区间
+/// @return false：比较结果不可能成立
+static bool refineCompare(IRInstOperator op, IntRange & a, IntRange & b)
+{
+    switch (op) {
+        case IRInstOperator::IRINST_OP_LT:
+            a.hi = std::min(a.hi, b.hi - 1);
+            b.lo = std::max(b.lo, a.lo + 1);
+            break;
+        case IRInstOperator::IRINST_OP_LE:
+            a.hi = std::min(a.hi, b.hi);
+            b.lo = std::max(b.lo, a.lo);
+            break;
+        case IRInstOperator::IRINST_OP_BT:
+            a.lo = std::max(a.lo, b.lo + 1);
+            b.hi = std::min(b.hi, a.hi - 1);
+            break;
+        case IRInstOperator::IRINST_OP_BE:
+            a.lo = std::max(a.lo, b.lo);
+            b.hi = std::min(b.hi, a.hi);
+            break;
+        case IRInstOperator::IRINST_OP_EQ:
+            a.lo = b.lo = std::max(a.lo, b.lo);
+            a.hi = b.hi = std::min(a.hi, b.hi);
+            break;
+        default:
+            // 不等只能去掉区间端点上的常量
+            if (b.isConstant()) {
+                a.lo += a.lo == b.lo;
+                a.hi -= a.hi == b.lo;
+            } else if (a.isConstant()) {
+                b.lo += b.lo == a.lo;
+                b.hi -= b.hi == a.lo;
+            }
+            break;
+    }
+    return a.lo <= a.hi && b.lo <= b.hi;
+}
+
+/// @brief 构造函数
+/// @param _func 函数
+ValueRange::ValueRange(Function * _func) : func(_func)
+{}
+
+/// @brief 计算每条运算指令的操作数与结果的区间
+void ValueRange::run()
+{
+    FunctionCFG cfg(func);
+    cfg.computeDominators();
+    std::vector<IRBlock *> & rpo = cfg.getRPO();
+    if (rpo.empty()) {
+        return;
+    }
+
+    // 按逆后序处理，前驱的状态尽量先于后继确定
+    std::set<int> worklist;
+    inStates[rpo[0]] = RangeState();
+    worklist.insert(0);
+    std::pair<IntRange, IntRange> operands;
+    IntRange result;
+    std::vector<IRInst *> targets;
+    while (!worklist.empty()) {
+        IRBlock * block = rpo[*worklist.begin()];
+        worklist.erase(worklist.begin());
+
+        RangeState state = inStates[block];
+        for (auto inst: block->insts) {
+            transfer(inst, state, operands, result);
+        }
+
+        IRInst * term = block->getTerminator();
+        if (term == nullptr) {
+            continue;
+        }
+        targets.clear();
+        getBranchTargets(term, targets);
+        for (size_t i = 0; i < targets.size(); ++i) {
+            IRBlock * succ = cfg.getBlockByLabel(targets[i]);
+            if (succ == nullptr || !succ->isReachable()) {
+                continue;
+            }
+            RangeState edgeState = state;
+            // 两个出口是同一个块时不能按条件区分
+            if (targets.size() == 2 && targets[0] != targets[1] && !refineEdge(block, i == 0, edgeState)) {
+                continue;
+            }
+            if (mergeInto(succ, edgeState)) {
+                worklist.insert(succ->rpo);
+            }
+        }
+    }
+
+    // 状态收敛后按入口状态重新执行一遍，记录每条指令处的区间
+    for (auto block: rpo) {
+        auto pIter = inStates.find(block);
+        if (pIter == inStates.end()) {
+            continue;
+        }
+        RangeState state = pIter->second;
+        for (auto inst: block->insts) {
+            if (transfer(inst, state, operands, result)) {
+                operandRanges[inst] = operands;
+                resultRanges[inst] = result;
+            }
+        }
+    }
+
+    inStates.clear();
+    visits.clear();
+}
+
+/// @brief 获取运算指令执行前操作数的区间，不可达或未分析的指令返回32位整数的全集
+/// @param inst 二元运算或赋值指令
+/// @param index 操作数的序号，0或1
+IntRange ValueRange::getOperandRange(IRInst * inst, int index)
+{
+    auto pIter = operandRanges.find(inst);
+    if (pIter == operandRanges.end()) {
+        return IntRange();
+    }
+    return index == 0 ? pIter->second.first : pIter->second.second;
+}
+
+/// @brief 获取运算结果的精确区间，不考虑32位回绕
+/// @param inst 二元运算或赋值指令
+/// @param range 结果区间
+/// @return false：指令不可达或不是整型运算
+bool ValueRange::getResultRange(IRInst * inst, IntRange & range)
+{
+    auto pIter = resultRanges.find(inst);
+    if (pIter == resultRanges.end()) {
+        return false;
+    }
+    range = pIter->second;
+    return true;
+}
+
+/// @brief 按64位计算的运算结果是否已经是32位结果的符号扩展，读内存与函数调用的结果除外
+bool ValueRange::isSignExtended(IRInst * inst)
+{
+    IntRange range;
+    return getResultRange(inst, range) && range.fitsInt32();
+}
+
+/// @brief 变量在当前状态下的区间
+IntRange ValueRange::lookup(RangeState & state, Value * val)
+{
+    if (isIntLiteral(val)) {
+        return IntRange(val->intVal, val->intVal);
+    }
+    auto pIter = state.find(val);
+    if (pIter == state.end()) {
+        return IntRange();
+    }
+    return pIter->second;
+}
+
+/// @brief 按指令更新状态，返回整型运算的精确结果区间
+/// @param inst 指令
+/// @param state 指令执行前的状态，执行后更新
+/// @param operands 操作数的区间
+/// @param result 结果区间
+/// @return true：指令是整型运算，result有效
+bool ValueRange::transfer(IRInst * inst,
+                          RangeState & state,
+                          std::pair<IntRange, IntRange> & operands,
+                          IntRange & result)
+{
+    IRInstOperator op = inst->getOp();
+    Value * def = getInstDef(inst);
+    bool known = false;
+    if (def != nullptr && isIntOperand(def)) {
+        if (op >= IRInstOperator::IRINST_OP_ADD_I && op <= IRInstOperator::IRINST_OP_NQ &&
+            static_cast<BinaryIRInst *>(inst)->mode <= 3 && isIntOperand(inst->getSrc1()) &&
+            isIntOperand(inst->getSrc2())) {
+            operands.first = lookup(state, inst->getSrc1());
+            operands.second = lookup(state, inst->getSrc2());
+            result = evalBinary(op, operands.first, operands.second);
+            known = true;
+        } else if (op == IRInstOperator::IRINST_OP_ASSIGN && isIntOperand(inst->getSrc1())) {
+            // 复制与取负，读内存的结果按64位读入，不计入
+            int flag = static_cast<AssignIRInst *>(inst)->_flag;
+            if (flag == 0 || flag == 5) {
+                operands.first = lookup(state, inst->getSrc1());
+                operands.second = IntRange();
+                result = flag == 0 ? operands.first : IntRange(-operands.first.hi, -operands.first.lo);
+                known = true;
+            }
+        } else if (op == IRInstOperator::IRINST_OP_SELECT && isIntOperand(inst->getSrc()[1]) &&
+                   isIntOperand(inst->getSrc()[2])) {
+            // 结果是两个操作数之一，条件已知时取对应的操作数，否则取区间的并
+            operands.first = lookup(state, inst->getSrc()[1]);
+            operands.second = lookup(state, inst->getSrc()[2]);
+            IntRange cond = lookup(state, inst->getSrc()[0]);
+            if (cond.isConstant()) {
+                result = cond.lo != 0 ? operands.first : operands.second;
+            } else {
+                result = IntRange(std::min(operands.first.lo, operands.second.lo),
+                                  std::max(operands.first.hi, operands.second.hi));
+            }
+            known = true;
+        }
+    }
+
+    if (def != nullptr && isTracked(def)) {
+        // 超出32位的结果回绕后可能是任意值，循环变量的上界由循环条件的收窄得到
+        if (known && result.fitsInt32()) {
+            state[def] = result;
+        } else {
+            state.erase(def);
+        }
+    }
+    return known;
+}
+
+/// @brief 按块尾条件跳转的一个出口收窄状态
+/// @param block 基本块
+/// @param taken true：条件为真的出口
+/// @param state 块出口的状态
+/// @return false：该出口不可能被执行
+bool ValueRange::refineEdge(IRBlock * block, bool taken, RangeState & state)
+{
+    IRInst * term = block->getTerminator();
+    if (term == nullptr || term->getOp() != IRInstOperator::IRINST_OP_BC) {
+        return true;
+    }
+    Value * cond = static_cast<BcIRInst *>(term)->temp;
+    if (cond == nullptr || !isIntOperand(cond)) {
+        return true;
+    }
+
+    IntRange condRange = lookup(state, cond);
+    if (taken) {
+        condRange.lo += condRange.lo == 0;
+        condRange.hi -= condRange.hi == 0;
+    } else {
+        condRange = condRange.lo <= 0 && condRange.hi >= 0 ? IntRange(0, 0) : IntRange(1, 0);
+    }
+    if (condRange.lo > condRange.hi) {
+        return false;
+    }
+    if (isTracked(cond)) {
+        state[cond] = condRange;
+    }
+
+    // 条件由块内的比较得到，且比较的操作数之后没有被重新定值时，收窄操作数的区间
+    std::unordered_set<Value *> laterDefs;
+    IRInst * cmp = nullptr;
+    for (int i = (int) block->insts.size() - 2; i >= 0; --i) {
+        IRInst * inst = block->insts[i];
+        Value * def = getInstDef(inst);
+        if (def == cond) {
+            cmp = inst;
+            break;
+        }
+        laterDefs.insert(def);
+    }
+    if (cmp == nullptr || !isCompare(cmp->getOp()) || static_cast<BinaryIRInst *>(cmp)->mode > 3) {
+        return true;
+    }
+    Value * lhs = cmp->getSrc1();
+    Value * rhs = cmp->getSrc2();
+    if (!isIntOperand(lhs) || !isIntOperand(rhs) || lhs == cond || rhs == cond || laterDefs.count(lhs) ||
+        laterDefs.count(rhs)) {
+        return true;
+    }
+
+    IntRange a = lookup(state, lhs), b = lookup(state, rhs);
+    if (!refineCompare(taken ? cmp->getOp() : invertCompare(cmp->getOp()), a, b)) {
+        return false;
+    }
+    if (isTracked(lhs)) {
+        state[lhs] = a;
+    }
+    if (isTracked(rhs)) {
+        state[rhs] = b;
+    }
+    return refineSource(block, lhs, a, state) && refineSource(block, rhs, b, state);
+}
+
+/// @brief 变量在块内由x + c得到且没有回绕时，按变量收窄后的区间收窄x的区间
+/// @return false：收窄后的区间为空
+bool ValueRange::refineSource(IRBlock * block, Value * val, const IntRange & range, RangeState & state)
+{
+    std::unordered_set<Value *> laterDefs;
+    for (int i = (int) block->insts.size() - 2; i >= 0; --i) {
+        IRInst * inst = block->insts[i];
+        Value * def = getInstDef(inst);
+        if (def != val) {
+            laterDefs.insert(def);
+            continue;
+        }
+        IRInstOperator op = inst->getOp();
+        if ((op != IRInstOperator::IRINST_OP_ADD_I && op != IRInstOperator::IRINST_OP_SUB_I) ||
+            static_cast<BinaryIRInst *>(inst)->mode > 3 || !isIntLiteral(inst->getSrc2())) {
+            return true;
+        }
+        Value * src = inst->getSrc1();
+        if (!isTracked(src) || src == val || laterDefs.count(src)) {
+            return true;
+        }
+        int64_t offset = op == IRInstOperator::IRINST_OP_ADD_I ? inst->getSrc2()->intVal : -inst->getSrc2()->intVal;
+        IntRange srcRange = lookup(state, src);
+        if (!IntRange(srcRange.lo + offset, srcRange.hi + offset).fitsInt32()) {
+            return true;
+        }
+        srcRange.lo = std::max(srcRange.lo, range.lo - offset);
+        srcRange.hi = std::min(srcRange.hi, range.hi - offset);
+        if (srcRange.lo > srcRange.hi) {
+            return false;
+        }
+        state[src] = srcRange;
+        return true;
+    }
+    return true;
+}
+
+/// @brief 把到达的状态合并到后继块的入口状态
+/// @return true：入口状态发生变化
+bool ValueRange::mergeInto(IRBlock * succ, RangeState & incoming)
+{
+    auto pIter = inStates.find(succ);
+    if (pIter == inStates.end()) {
+        inStates[succ] = incoming;
+        visits[succ] = 1;
+        return true;
+    }
+
+    RangeState & old = pIter->second;
+    bool widen = ++visits[succ] > WIDEN_VISITS;
+    bool changed = false;
+    for (auto iter = old.begin(); iter != old.end();) {
+        auto inIter = incoming.find(iter->first);
+        if (inIter == incoming.end()) {
+            iter = old.erase(iter);
+            changed = true;
+            continue;
+        }
+        IntRange & range = iter->second;
+        if (inIter->second.lo < range.lo) {
+            range.lo = widen ? INT_MIN : inIter->second.lo;
+            changed = true;
+        }
+        if (inIter->second.hi > range.hi) {
+            range.hi = widen ? INT_MAX : inIter->second.hi;
+            changed = true;
+        }
+        ++iter;
+    }
+    return changed;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file ValueRange.h
+ * @brief 整型值域分析：在控制流图上按基本块传播每个标量变量的取值区间，条件跳转的两个出口按比较结果收窄区间
+ *
+ * 回边处经过若干次迭代仍在变化的边界直接放宽到32位整数的边界，保证分析收敛。
+ * 后端的整型运算按64位进行，运算结果的精确区间在32位范围内时，寄存器中的结果已经是符号扩展的。
+ */
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include "FunctionCFG.h"
+
+/// @brief 整数区间，按64位保存，可以表示运算的精确结果超出32位的情况
+struct IntRange {
+    /// @brief 下界
+    int64_t lo = INT_MIN;
+
+    /// @brief 上界
+    int64_t hi = INT_MAX;
+
+    IntRange() = default;
+
+    IntRange(int64_t _lo, int64_t _hi) : lo(_lo), hi(_hi)
+    {}
+
+    /// @brief 是否在32位整数的范围内
+    bool fitsInt32() const
+    {
+        return lo >= INT_MIN && hi <= INT_MAX;
+    }
+
+    /// @brief 是否只有一个值
+    bool isConstant() const
+    {
+        return lo == hi;
+    }
+};
+
+/// @brief 变量到取值区间，不在表中的变量可以取任意32位整数
+using RangeState = std::unordered_map<Value *, IntRange>;
+
+/// @brief 函数内的整型值域分析
+class ValueRange {
+
+public:
+    /// @brief 构造函数
+    /// @param _func 函数
+    ValueRange(Function * _func);
+
+    /// @brief 计算每条运算指令的操作数与结果的区间
+    void run();
+
+    /// @brief 获取运算指令执行前操作数的区间，不可达或未分析的指令返回32位整数的全集
+    /// @param inst 二元运算或赋值指令
+    /// @param index 操作数的序号，0或1
+    IntRange getOperandRange(IRInst * inst, int index);
+
+    /// @brief 获取运算结果的精确区间，不考虑32位回绕
+    /// @param inst 二元运算或赋值指令
+    /// @param range 结果区间
+    /// @return false：指令不可达或不是整型运算
+    bool getResultRange(IRInst * inst, IntRange & range);
+
+    /// @brief 按64位计算的运算结果是否已经是32位结果的符号扩展，读内存与函数调用的结果除外
+    bool isSignExtended(IRInst * inst);
+
+private:
+    /// @brief 变量在当前状态下的区间
+    IntRange lookup(RangeState & state, Value * val);
+
+    /// @brief 按指令更新状态，返回整型运算的精确结果区间
+    /// @param inst 指令
+    /// @param state 指令执行前的状态，执行后更新
+    /// @param operands 操作数的区间
+    /// @param result 结果区间
+    /// @return true：指令是整型运算，result有效
+    bool transfer(IRInst * inst, RangeState & state, std::pair<IntRange, IntRange> & operands, IntRange & result);
+
+    /// @brief 按块尾条件跳转的一个出口收窄状态
+    /// @param block 基本块
+    /// @param taken true：条件为真的出口
+    /// @param state 块出口的状态
+    /// @return false：该出口不可能被执行
+    bool refineEdge(IRBlock * block, bool taken, RangeState & state);
+
+    /// @brief 变量在块内由x + c得到且没有回绕时，按变量收窄后的区间收窄x的区间
+    /// @return false：收窄后的区间为空
+    bool refineSource(IRBlock * block, Value * val, const IntRange & range, RangeState & state);
+
+    /// @brief 把到达的状态合并到后继块的入口状态
+    /// @return true：入口状态发生变化
+    bool mergeInto(IRBlock * succ, RangeState & incoming);
+
+    /// @brief 函数
+    Function * func;
+
+    /// @brief 基本块入口的状态
+    std::unordered_map<IRBlock *, RangeState> inStates;
+
+    /// @brief 基本块入口状态的更新次数，超过阈值后放宽边界
+    std::unordered_map<IRBlock *, int> visits;
+
+    /// @brief 指令执行前操作数的区间
+    std::unordered_map<IRInst *, std::pair<IntRange, IntRange>> operandRanges;
+
+    /// @brief 整型运算结果的精确区间
+    std::unordered_map<IRInst *, IntRange> resultRanges;
+};
@@ -0,0 +1,132 @@
+/**
+ * @file sysy_parallel.c
+ * @brief 循环并行化的fork-join运行时库：编译器把并行循环外提为函数后调用__sysy_parallel_for，
+ * 由常驻的工作线程与调用线程各执行迭代区间中的一段，全部完成后返回
+ *
+ * 生成的代码中没有函数指针，各线程通过编译器生成的分发函数__sysy_parallel_body按循环编号执行循环。
+ * 工作线程在第一次并行执行时创建，空闲时阻塞在条件变量上；迭代次数较少或嵌套调用时直接串行执行。
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/// @brief 参与并行执行的线程数，含调用线程
+#define SYSY_PARALLEL_THREADS 4
+
+/// @brief 每个线程至少分到的迭代次数，区间更小时串行执行
+#define SYSY_PARALLEL_MIN_CHUNK 64
+
+/// @brief 编译器生成的分发函数，执行编号为id的循环在[begin, end)上的迭代。
+/// 没有循环被并行化时不生成，弱引用使这样的程序同样可以链接，此时也不会调用__sysy_parallel_for
+extern void __sysy_parallel_body(int id, int begin, int end) __attribute__((weak));
+
+/// @brief 工作线程创建的保护
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+/// @brief 成功创建的工作线程数
+static int workerCount = 0;
+
+/// @brief 保护任务描述与代数的互斥锁
+static pthread_mutex_t taskLock = PTHREAD_MUTEX_INITIALIZER;
+
+/// @brief 通知工作线程有新任务的条件变量
+static pthread_cond_t taskReady = PTHREAD_COND_INITIALIZER;
+
+/// @brief 任务代数，每发布一个任务加一
+static unsigned taskGeneration = 0;
+
+/// @brief 当前任务的循环编号与迭代区间
+static int taskId;
+static int taskBegin;
+static int taskEnd;
+
+/// @brief 当前任务还未完成的工作线程数
+static atomic_int remaining;
+
+/// @brief 是否有任务正在并行执行，嵌套调用时串行执行
+static atomic_flag busy = ATOMIC_FLAG_INIT;
+
+/// @brief 执行第index段迭代，区间按线程数均分
+static void runChunk(int id, int begin, int end, int index, int parts)
+{
+    long long total = (long long) end - begin;
+    int lo = (int) (begin + total * index / parts);
+    int hi = (int) (begin + total * (index + 1) / parts);
+    if (lo < hi) {
+        __sysy_parallel_body(id, lo, hi);
+    }
+}
+
+/// @brief 工作线程：等待新的任务代数，执行自己的一段后计数减一
+static void * workerMain(void * arg)
+{
+    int index = (int) (intptr_t) arg;
+    unsigned seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&taskLock);
+        while (taskGeneration == seen) {
+            pthread_cond_wait(&taskReady, &taskLock);
+        }
+        seen = taskGeneration;
+        int id = taskId;
+        int begin = taskBegin;
+        int end = taskEnd;
+        pthread_mutex_unlock(&taskLock);
+
+        runChunk(id, begin, end, index, workerCount + 1);
+        atomic_fetch_sub_explicit(&remaining, 1, memory_order_release);
+    }
+    return 0;
+}
+
+/// @brief 创建常驻的工作线程，创建失败时以已有的线程执行
+static void createWorkers(void)
+{
+    for (int i = 1; i < SYSY_PARALLEL_THREADS; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, workerMain, (void *) (intptr_t) i) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+        ++workerCount;
+    }
+}
+
+/// @brief 并行执行编号为id的循环在[begin, end)上的全部迭代，返回时所有迭代都已完成
+void __sysy_parallel_for(int id, int begin, int end)
+{
+    if (begin >= end) {
+        return;
+    }
+    if ((long long) end - begin < (long long) SYSY_PARALLEL_THREADS * SYSY_PARALLEL_MIN_CHUNK ||
+        atomic_flag_test_and_set(&busy)) {
+        __sysy_parallel_body(id, begin, end);
+        return;
+    }
+
+    pthread_once(&poolOnce, createWorkers);
+    if (workerCount == 0) {
+        __sysy_parallel_body(id, begin, end);
+        atomic_flag_clear(&busy);
+        return;
+    }
+
+    // 发布任务，工作线程执行第1段及以后，调用线程执行第0段
+    atomic_store_explicit(&remaining, workerCount, memory_order_relaxed);
+    pthread_mutex_lock(&taskLock);
+    taskId = id;
+    taskBegin = begin;
+    taskEnd = end;
+    ++taskGeneration;
+    pthread_cond_broadcast(&taskReady);
+    pthread_mutex_unlock(&taskLock);
+
+    runChunk(id, begin, end, 0, workerCount + 1);
+
+    // 各段迭代量相近，等待时间很短，让出处理器等待而不阻塞
+    while (atomic_load_explicit(&remaining, memory_order_acquire) != 0) {
+        sched_yield();
+    }
+    atomic_flag_clear(&busy);
+}